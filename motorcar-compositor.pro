@@ -38,7 +38,7 @@ UI_DIR = lib/.ui
 QMAKE_CXXFLAGS += -std=c++11 -DGL_GLEXT_PROTOTYPES -DMOTORCAR_SHADER_PATH=$$PWD/src/compositor/shaders
 
 
-LIBS += -lGL
+LIBS += -lGL -lEGL
 LIBS += -L $$QTWAYLANDSOURCEPATH/lib
 INCLUDEPATH += $$QTWAYLANDSOURCEPATH/include
 #INCLUDEPATH += $$QTWAYLANDSOURCEPATH/include/QtCompositor/5.3.0/
@@ -104,6 +104,29 @@ HEADERS += \
     src/compositor/events/sixdofevent.h \
     src/compositor/scenegraph/input/sixdofpointingdevice.h \
     src/compositor/scenegraph/output/wayland/motorcarsurfacenode.h\
+    src/compositor/gl/openglextensions.h \
+    src/compositor/profiling/histogram.h \
+    src/compositor/profiling/framestatistics.h \
+    src/compositor/qt/shmsurfacetexture.h \
+    src/compositor/gl/pixelunpackbufferring.h \
+    src/compositor/qt/textureuploadpool.h \
+    src/compositor/qt/clientbuffertexturecache.h \
+    src/compositor/gl/textureatlas.h \
+    src/compositor/scenegraph/output/wayland/surfacebatch.h \
+    src/compositor/gl/mipmappedtexture.h \
+    src/compositor/wayland/output/depthbuffer.h \
+    src/compositor/gl/rendergraph.h \
+    src/compositor/gl/gpuresourcepool.h \
+    src/compositor/scenegraph/output/framesnapshot.h \
+    src/compositor/scenegraph/output/framerenderer.h \
+    src/compositor/qt/renderthread.h \
+    src/compositor/gl/texturemailbox.h \
+    src/compositor/scenegraph/output/display/mirrordisplay.h \
+    src/compositor/wayland/output/posechannel.h \
+    src/compositor/scenegraph/input/posepredictor.h \
+    src/compositor/wayland/output/presentationfeedback.h \
+    src/compositor/scenegraph/input/oneeurofilter.h \
+    src/compositor/scenegraph/input/trackersamplequeue.h \
 #    src/device/device.h \
 #    src/device/oculushmd.h \
 #    src/device/sixensemotionsensingsystem.h \
@@ -153,6 +176,29 @@ SOURCES += \
     src/compositor/events/sixdofevent.cpp \
     src/compositor/scenegraph/input/sixdofpointingdevice.cpp \
     src/compositor/scenegraph/output/wayland/motorcarsurfacenode.cpp\
+    src/compositor/gl/openglextensions.cpp \
+    src/compositor/profiling/histogram.cpp \
+    src/compositor/profiling/framestatistics.cpp \
+    src/compositor/qt/shmsurfacetexture.cpp \
+    src/compositor/gl/pixelunpackbufferring.cpp \
+    src/compositor/qt/textureuploadpool.cpp \
+    src/compositor/qt/clientbuffertexturecache.cpp \
+    src/compositor/gl/textureatlas.cpp \
+    src/compositor/scenegraph/output/wayland/surfacebatch.cpp \
+    src/compositor/gl/mipmappedtexture.cpp \
+    src/compositor/wayland/output/depthbuffer.cpp \
+    src/compositor/gl/rendergraph.cpp \
+    src/compositor/gl/gpuresourcepool.cpp \
+    src/compositor/scenegraph/output/framesnapshot.cpp \
+    src/compositor/scenegraph/output/framerenderer.cpp \
+    src/compositor/qt/renderthread.cpp \
+    src/compositor/gl/texturemailbox.cpp \
+    src/compositor/scenegraph/output/display/mirrordisplay.cpp \
+    src/compositor/wayland/output/posechannel.cpp \
+    src/compositor/scenegraph/input/posepredictor.cpp \
+    src/compositor/wayland/output/presentationfeedback.cpp \
+    src/compositor/scenegraph/input/oneeurofilter.cpp \
+    src/compositor/scenegraph/input/trackersamplequeue.cpp \
 #    src/device/oculushmd.cpp \
 #    src/device/sixensemotionsensingsystem.cpp \
 #    src/device/sixensecontrollernode.cpp \
@@ -177,8 +223,12 @@ OTHER_FILES += \
     src/compositor/shaders/depthcompositedsurface.frag \
     src/compositor/shaders/depthcompositedsurfaceblitter.frag \
     src/compositor/shaders/depthcompositedsurfaceblitter.vert \
+    src/compositor/shaders/depthcompositedsurfacereprojection.vert \
+    src/compositor/shaders/depthcompositedsurfacereprojection.frag \
     src/compositor/shaders/softkineticdepthcam.vert \
-    src/compositor/shaders/softkineticdepthcam.frag
+    src/compositor/shaders/softkineticdepthcam.frag \
+    src/compositor/shaders/motorcarmirror.vert \
+    src/compositor/shaders/motorcarmirror.frag
 
 
 
@@ -59,10 +59,16 @@ public:
     virtual int start() = 0;
 
     ///Gets the OpenGL context in which the compositing is taking place
-    /*this context is used by display classes to allow them to do all of the drawing in the correct context.
-     * eventually this should be capable of returning multiple contexts, or perhaps the contexts should be created externally and passed in*/
+    /*this context is used by display classes to allow them to do all of the drawing in the correct context.*/
     virtual OpenGLContext *getContext() = 0;
 
+    ///Creates a context drawing into a window of its own on the given screen, for an additional display
+    /*The context shares textures, buffers and programs with the one returned by getContext(). Displays of
+     * different contexts are drawn concurrently, every context on a thread of its own, if the compositor
+     * supports it. Displays must be added to the scene before the compositor is started to be drawn on
+     * their own thread. Returns NULL if no window could be created on the screen*/
+    virtual OpenGLContext *createContext(int screen) = 0;
+
     ///Gets the Motorcar seat associated with this compositors default input devices
     virtual Seat *defaultSeat() const = 0 ;
 
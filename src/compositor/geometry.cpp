@@ -77,9 +77,10 @@ void Geometry::Ray::draw(SceneGraphNode *parent, glm::vec3 color, glm::mat4 tran
     };
     auto node = new WireframeNode(vertices, 4, color, parent, transform*translation);
 
+    //the ray is only drawn if it is added while a frame is being snapshotted
     auto scene = parent->scene();
-    for(auto display : scene->displays()){
-        node->draw(scene, display);
+    if(scene->frameSnapshot() != NULL){
+        node->snapshot(scene, scene->frameSnapshot());
     }
 
 delete node;
@@ -0,0 +1,396 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#include <gl/gpuresourcepool.h>
+#include <gl/openglextensions.h>
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+
+using namespace motorcar;
+
+//frames a released resource is kept around for reuse, long enough to cover a window being resized or reopened
+static const unsigned int MAX_IDLE_FRAMES = 300;
+
+GpuResourcePool::GpuResourcePool()
+    :m_budgetBytes(0)
+    ,m_allocatedBytes(0)
+    ,m_freeBytes(0)
+    ,m_releaseFrame(0)
+    ,m_oldestFrameInUse(0)
+    ,m_immutableStorageSupported(-1)
+    ,m_overBudget(false)
+{
+}
+
+GpuResourcePool::~GpuResourcePool()
+{
+    for(const Resource &resource : m_free){
+        destroy(resource);
+    }
+    for(const std::pair<const GLuint, Resource> &entry : m_textures){
+        destroy(entry.second);
+    }
+    for(const std::pair<const GLuint, Resource> &entry : m_renderbuffers){
+        destroy(entry.second);
+    }
+}
+
+void GpuResourcePool::registerOwner(const void *owner, const std::string &name)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_ownerNames[owner] = name;
+}
+
+void GpuResourcePool::unregisterOwner(const void *owner)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::map<const void *, size_t>::iterator bytes = m_ownerBytes.find(owner);
+    if(bytes != m_ownerBytes.end()){
+        std::cout << "Warning: " << ownerName(owner) << " still holds " << bytes->second << " bytes of GPU resources" << std::endl;
+    }
+    m_ownerNames.erase(owner);
+}
+
+GLuint GpuResourcePool::acquireTexture(const void *owner, GLenum internalFormat, glm::ivec2 size, int levels, bool mayExceedBudget)
+{
+    return acquire(owner, false, internalFormat, size, levels, mayExceedBudget);
+}
+
+void GpuResourcePool::releaseTexture(GLuint texture)
+{
+    if(texture != 0){
+        release(m_textures, texture);
+    }
+}
+
+GLuint GpuResourcePool::acquireRenderbuffer(const void *owner, GLenum internalFormat, glm::ivec2 size)
+{
+    return acquire(owner, true, internalFormat, size, 1, false);
+}
+
+void GpuResourcePool::releaseRenderbuffer(GLuint renderbuffer)
+{
+    if(renderbuffer != 0){
+        release(m_renderbuffers, renderbuffer);
+    }
+}
+
+void GpuResourcePool::endFrame()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for(size_t i = 0; i < m_free.size();){
+        if(recyclable(m_free[i]) && ++m_free[i].idleFrames > MAX_IDLE_FRAMES){
+            destroy(m_free[i]);
+            m_free.erase(m_free.begin() + i);
+        }else{
+            i++;
+        }
+    }
+}
+
+void GpuResourcePool::setReleaseFrame(unsigned long frame)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_releaseFrame = frame;
+}
+
+void GpuResourcePool::setOldestFrameInUse(unsigned long frame)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_oldestFrameInUse = frame;
+    makeRoom(0);
+}
+
+size_t GpuResourcePool::budgetBytes() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_budgetBytes;
+}
+
+void GpuResourcePool::setBudgetBytes(size_t budgetBytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_budgetBytes = budgetBytes;
+    makeRoom(0);
+}
+
+size_t GpuResourcePool::allocatedBytes() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_allocatedBytes;
+}
+
+size_t GpuResourcePool::freeBytes() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_freeBytes;
+}
+
+size_t GpuResourcePool::ownerBytes(const void *owner) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::map<const void *, size_t>::const_iterator bytes = m_ownerBytes.find(owner);
+    return bytes == m_ownerBytes.end() ? 0 : bytes->second;
+}
+
+void GpuResourcePool::printUsage(std::ostream &stream) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    printUsageLocked(stream);
+}
+
+size_t GpuResourcePool::bytesPerPixel(GLenum internalFormat)
+{
+    switch(internalFormat){
+    case GL_R8:
+        return 1;
+    case GL_RG8:
+    case GL_DEPTH_COMPONENT16:
+        return 2;
+    case GL_RGBA16F:
+        return 8;
+    case GL_RGBA32F:
+        return 16;
+    default:
+        //RGB formats and 24 bit depth are padded to four bytes by practically every driver
+        return 4;
+    }
+}
+
+GLuint GpuResourcePool::acquire(const void *owner, bool renderbuffer, GLenum internalFormat, glm::ivec2 size, int levels, bool mayExceedBudget)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    Resource resource;
+    bool recycled = false;
+    for(size_t i = 0; i < m_free.size(); i++){
+        const Resource &candidate = m_free[i];
+        if(recyclable(candidate) && candidate.renderbuffer == renderbuffer && candidate.internalFormat == internalFormat &&
+                candidate.size.x == size.x && candidate.size.y == size.y && candidate.levels == levels){
+            resource = candidate;
+            m_free.erase(m_free.begin() + i);
+            m_freeBytes -= resource.bytes;
+            recycled = true;
+            break;
+        }
+    }
+
+    if(!recycled){
+        size_t bytes = 0;
+        for(int level = 0; level < levels; level++){
+            bytes += (size_t) glm::max(size.x >> level, 1) * glm::max(size.y >> level, 1) * bytesPerPixel(internalFormat);
+        }
+
+        if(!makeRoom(bytes)){
+            if(mayExceedBudget){
+                //always reported, as the budget is too small for what the compositor itself needs to draw
+                std::cout << "Warning: GPU memory budget exhausted, exceeding it by " << bytes / 1024 << " KiB for " << ownerName(owner) << std::endl;
+                printUsageLocked(std::cout);
+            }else{
+                //only report once per run of failures so a client committing every frame does not flood the log
+                if(!m_overBudget){
+                    std::cout << "Warning: GPU memory budget exhausted, refusing " << bytes / 1024 << " KiB for " << ownerName(owner) << std::endl;
+                    printUsageLocked(std::cout);
+                    m_overBudget = true;
+                }
+                return 0;
+            }
+        }else{
+            m_overBudget = false;
+        }
+
+        resource.name = allocate(renderbuffer, internalFormat, size, levels);
+        resource.renderbuffer = renderbuffer;
+        resource.internalFormat = internalFormat;
+        resource.size = size;
+        resource.levels = levels;
+        resource.bytes = bytes;
+        m_allocatedBytes += bytes;
+    }
+
+    resource.owner = owner;
+    resource.idleFrames = 0;
+    (renderbuffer ? m_renderbuffers : m_textures)[resource.name] = resource;
+    m_ownerBytes[owner] += resource.bytes;
+    return resource.name;
+}
+
+void GpuResourcePool::release(std::map<GLuint, GpuResourcePool::Resource> &resources, GLuint name)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::map<GLuint, Resource>::iterator it = resources.find(name);
+    if(it == resources.end()){
+        std::cout << "Warning: releasing GPU resource " << name << " which was not acquired from the pool" << std::endl;
+        return;
+    }
+
+    Resource resource = it->second;
+    resources.erase(it);
+
+    std::map<const void *, size_t>::iterator bytes = m_ownerBytes.find(resource.owner);
+    bytes->second -= resource.bytes;
+    if(bytes->second == 0){
+        m_ownerBytes.erase(bytes);
+    }
+
+    resource.owner = NULL;
+    resource.idleFrames = 0;
+    resource.releaseFrame = m_releaseFrame;
+    m_free.push_back(resource);
+    m_freeBytes += resource.bytes;
+    makeRoom(0);
+}
+
+GLuint GpuResourcePool::allocate(bool renderbuffer, GLenum internalFormat, glm::ivec2 size, int levels)
+{
+    GLuint name = 0;
+    if(renderbuffer){
+        glGenRenderbuffers(1, &name);
+        glBindRenderbuffer(GL_RENDERBUFFER, name);
+        glRenderbufferStorage(GL_RENDERBUFFER, internalFormat, size.x, size.y);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        return name;
+    }
+
+    if(m_immutableStorageSupported < 0){
+        m_immutableStorageSupported = OpenGLExtensions::versionAtLeast(4, 2) ||
+                OpenGLExtensions::hasExtension("GL_ARB_texture_storage");
+    }
+
+    glGenTextures(1, &name);
+    glBindTexture(GL_TEXTURE_2D, name);
+    if(m_immutableStorageSupported){
+        glTexStorage2D(GL_TEXTURE_2D, levels, internalFormat, size.x, size.y);
+    }else{
+        //the client format only has to be compatible with the internal format since no data is uploaded
+        GLenum format = GL_RGBA, type = GL_UNSIGNED_BYTE;
+        switch(internalFormat){
+        case GL_R8:
+            format = GL_RED;
+            break;
+        case GL_RG8:
+            format = GL_RG;
+            break;
+        case GL_RGB8:
+            format = GL_RGB;
+            break;
+        case GL_DEPTH_COMPONENT16:
+            format = GL_DEPTH_COMPONENT;
+            type = GL_UNSIGNED_SHORT;
+            break;
+        case GL_DEPTH_COMPONENT24:
+            format = GL_DEPTH_COMPONENT;
+            type = GL_UNSIGNED_INT;
+            break;
+        case GL_DEPTH24_STENCIL8:
+            format = GL_DEPTH_STENCIL;
+            type = GL_UNSIGNED_INT_24_8;
+            break;
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+        for(int level = 0; level < levels; level++){
+            glTexImage2D(GL_TEXTURE_2D, level, internalFormat, glm::max(size.x >> level, 1), glm::max(size.y >> level, 1), 0,
+                         format, type, NULL);
+        }
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return name;
+}
+
+void GpuResourcePool::destroy(const GpuResourcePool::Resource &resource)
+{
+    if(resource.renderbuffer){
+        glDeleteRenderbuffers(1, &resource.name);
+    }else{
+        glDeleteTextures(1, &resource.name);
+    }
+    m_allocatedBytes -= resource.bytes;
+    if(resource.owner == NULL){
+        m_freeBytes -= resource.bytes;
+    }
+}
+
+bool GpuResourcePool::makeRoom(size_t bytes)
+{
+    if(m_budgetBytes == 0){
+        return true;
+    }
+    //the oldest free resources are at the front and the least likely to be asked for again
+    for(size_t i = 0; i < m_free.size() && m_allocatedBytes + bytes > m_budgetBytes;){
+        if(recyclable(m_free[i])){
+            destroy(m_free[i]);
+            m_free.erase(m_free.begin() + i);
+        }else{
+            i++;
+        }
+    }
+    return m_allocatedBytes + bytes <= m_budgetBytes;
+}
+
+bool GpuResourcePool::recyclable(const GpuResourcePool::Resource &resource) const
+{
+    return resource.releaseFrame <= m_oldestFrameInUse;
+}
+
+void GpuResourcePool::printUsageLocked(std::ostream &stream) const
+{
+    std::vector<std::pair<size_t, const void *> > owners;
+    for(const std::pair<const void * const, size_t> &entry : m_ownerBytes){
+        owners.push_back(std::make_pair(entry.second, entry.first));
+    }
+    std::sort(owners.rbegin(), owners.rend());
+
+    stream << "GPU resources: " << m_allocatedBytes / 1024 << " KiB allocated, " << m_freeBytes / 1024 << " KiB pooled";
+    if(m_budgetBytes > 0){
+        stream << ", budget " << m_budgetBytes / 1024 << " KiB";
+    }
+    stream << std::endl;
+    for(const std::pair<size_t, const void *> &owner : owners){
+        stream << "    " << ownerName(owner.second) << ": " << owner.first / 1024 << " KiB" << std::endl;
+    }
+}
+
+std::string GpuResourcePool::ownerName(const void *owner) const
+{
+    std::map<const void *, std::string>::const_iterator name = m_ownerNames.find(owner);
+    if(name != m_ownerNames.end()){
+        return name->second;
+    }
+    std::ostringstream stream;
+    stream << "unnamed owner " << owner;
+    return stream.str();
+}
@@ -0,0 +1,149 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#ifndef GPURESOURCEPOOL_H
+#define GPURESOURCEPOOL_H
+
+#include <GL/gl.h>
+#include <glm/glm.hpp>
+
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace motorcar {
+///Recycles textures and renderbuffers and accounts for the video memory they use
+/*Resources are handed out by internal format, size and mip level count. Released resources are kept
+ * in a free list and handed out again to the next request with the same description, and are only
+ * deleted once they have sat unused for a while (see endFrame()).
+ *
+ * When frames are drawn on other threads, a frame which was snapshotted before a resource was released may
+ * still sample it. Releases are therefore tagged with the frame being prepared at the time (see
+ * setReleaseFrame()), and the resource is neither handed out again nor deleted before every frame older than
+ * that one has been drawn (see setOldestFrameInUse()). Without either being called resources are recycled
+ * immediately.
+ *
+ * Every resource is charged to an owner, an arbitrary pointer identifying whoever holds it (a surface,
+ * a display, a device). Owners may register a human readable name, and the bytes held by each owner can
+ * be printed to find out which one is responsible when video memory usage grows.
+ *
+ * When a budget is set, a request which would take the total (including free resources) over it first
+ * frees pooled resources, and fails by returning 0 if that is not enough, so callers must handle not
+ * getting a resource. Requests which may exceed the budget, like the render targets without which
+ * nothing can be drawn at all, are still granted in that case, taking room the next ordinary requests
+ * are then refused.
+ *
+ * The pool may be used from any thread whose context shares objects with the compositor's context*/
+class GpuResourcePool
+{
+public:
+    GpuResourcePool();
+    ~GpuResourcePool();
+
+    ///sets the name the owner is listed under, resources may be acquired for owners which never registered
+    void registerOwner(const void *owner, const std::string &name);
+    ///forgets the owner's name, warning about any resources it still holds
+    void unregisterOwner(const void *owner);
+
+    ///returns a GL_TEXTURE_2D with storage for the given number of mip levels, or 0 if the budget is exhausted
+    /*the texture parameters of a recycled texture are whatever its previous user left them as, a texture
+     * which may exceed the budget is always returned*/
+    GLuint acquireTexture(const void *owner, GLenum internalFormat, glm::ivec2 size, int levels = 1, bool mayExceedBudget = false);
+    void releaseTexture(GLuint texture);
+
+    ///returns a renderbuffer with storage of the given format, or 0 if the budget is exhausted
+    GLuint acquireRenderbuffer(const void *owner, GLenum internalFormat, glm::ivec2 size);
+    void releaseRenderbuffer(GLuint renderbuffer);
+
+    ///ages the free list, deleting resources which have not been reused for a while
+    void endFrame();
+
+    ///tags resources released from now on as possibly sampled by any frame before the given one
+    void setReleaseFrame(unsigned long frame);
+    ///lets resources released with a release frame up to the given one be recycled, as no older frame is drawn anymore
+    void setOldestFrameInUse(unsigned long frame);
+
+    ///limit on the bytes held by the pool in use and free, 0 means unlimited
+    size_t budgetBytes() const;
+    void setBudgetBytes(size_t budgetBytes);
+
+    size_t allocatedBytes() const;
+    size_t freeBytes() const;
+    size_t ownerBytes(const void *owner) const;
+
+    ///prints the bytes held by each owner, largest first
+    void printUsage(std::ostream &stream) const;
+
+    ///approximate size of one pixel of the given internal format, as drivers do not report actual usage
+    static size_t bytesPerPixel(GLenum internalFormat);
+
+private:
+    struct Resource{
+        GLuint name;
+        bool renderbuffer;
+        GLenum internalFormat;
+        glm::ivec2 size;
+        int levels;
+        size_t bytes;
+        const void *owner;
+        unsigned int idleFrames;
+        unsigned long releaseFrame;
+    };
+
+    mutable std::mutex m_mutex;
+    std::map<GLuint, Resource> m_textures, m_renderbuffers;
+    std::vector<Resource> m_free;
+    std::map<const void *, std::string> m_ownerNames;
+    std::map<const void *, size_t> m_ownerBytes;
+    size_t m_budgetBytes, m_allocatedBytes, m_freeBytes;
+    unsigned long m_releaseFrame, m_oldestFrameInUse;
+    int m_immutableStorageSupported;
+    bool m_overBudget;
+
+    GLuint acquire(const void *owner, bool renderbuffer, GLenum internalFormat, glm::ivec2 size, int levels, bool mayExceedBudget);
+    void release(std::map<GLuint, Resource> &resources, GLuint name);
+    GLuint allocate(bool renderbuffer, GLenum internalFormat, glm::ivec2 size, int levels);
+    void destroy(const Resource &resource);
+    ///whether no frame which may sample the free resource is drawn anymore
+    bool recyclable(const Resource &resource) const;
+    ///deletes free resources until the given number of bytes fits within the budget, returns whether it does
+    bool makeRoom(size_t bytes);
+    std::string ownerName(const void *owner) const;
+    void printUsageLocked(std::ostream &stream) const;
+};
+}
+
+#endif // GPURESOURCEPOOL_H
@@ -0,0 +1,141 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#include <gl/mipmappedtexture.h>
+#include <gl/openglextensions.h>
+
+using namespace motorcar;
+
+static float maxAnisotropy()
+{
+    static float anisotropy = -1;
+    if(anisotropy < 0){
+        anisotropy = 1;
+        if(OpenGLExtensions::hasExtension("GL_EXT_texture_filter_anisotropic")){
+            glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &anisotropy);
+        }
+    }
+    return anisotropy;
+}
+
+MipmappedTexture::MipmappedTexture(GpuResourcePool *pool, const std::string &name)
+    :m_pool(pool)
+    ,m_texture(0)
+    ,m_readFramebuffer(0)
+    ,m_drawFramebuffer(0)
+{
+    m_pool->registerOwner(this, name);
+    glGenFramebuffers(1, &m_readFramebuffer);
+    glGenFramebuffers(1, &m_drawFramebuffer);
+}
+
+MipmappedTexture::~MipmappedTexture()
+{
+    glDeleteFramebuffers(1, &m_readFramebuffer);
+    glDeleteFramebuffers(1, &m_drawFramebuffer);
+    m_pool->releaseTexture(m_texture);
+    m_pool->unregisterOwner(this);
+}
+
+bool MipmappedTexture::isSupported()
+{
+    return OpenGLExtensions::versionAtLeast(3, 0) || OpenGLExtensions::hasExtension("GL_ARB_framebuffer_object");
+}
+
+void MipmappedTexture::update(GLuint sourceTexture, glm::ivec2 size)
+{
+    if(m_texture == 0 || size != m_size){
+        allocate(size);
+        if(m_texture == 0){
+            return;
+        }
+    }
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_readFramebuffer);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, sourceTexture, 0);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_drawFramebuffer);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_texture, 0);
+
+    //halving with linear filtering samples between the texels of each 2x2 block
+    glBlitFramebuffer(0, 0, size.x, size.y, 0, 0, m_baseSize.x, m_baseSize.y, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    glBindTexture(GL_TEXTURE_2D, m_texture);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+GLuint MipmappedTexture::texture() const
+{
+    return m_texture;
+}
+
+glm::ivec2 MipmappedTexture::size() const
+{
+    return m_size;
+}
+
+void MipmappedTexture::allocate(glm::ivec2 size)
+{
+    m_pool->releaseTexture(m_texture);
+    m_size = glm::ivec2(0);
+
+    glm::ivec2 baseSize = glm::max(size / 2, glm::ivec2(1));
+    int levels = 1;
+    while((baseSize.x >> levels) > 0 || (baseSize.y >> levels) > 0){
+        levels++;
+    }
+
+    m_texture = m_pool->acquireTexture(this, GL_RGBA8, baseSize, levels);
+    if(m_texture == 0){
+        return;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, m_texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    if(maxAnisotropy() > 1){
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, maxAnisotropy());
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    m_size = size;
+    m_baseSize = baseSize;
+}
@@ -0,0 +1,87 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#ifndef MIPMAPPEDTEXTURE_H
+#define MIPMAPPEDTEXTURE_H
+
+#include <gl/gpuresourcepool.h>
+
+#include <glm/glm.hpp>
+#include <GL/gl.h>
+
+#include <string>
+
+namespace motorcar {
+///Mipmapped copy of another texture, starting at half its resolution
+/*Client textures are allocated with a single level (or are EGLImage siblings which cannot have more, and
+ * shared memory textures are swapped and sampled by drawing threads while the next upload goes on), so
+ * surfaces which are minified on screen are drawn from a copy with a mip chain instead. Since the copy is
+ * only used once more than one texel falls on a pixel, the source's own resolution is left out of it: the
+ * copy is made with a linear framebuffer blit into a half resolution level 0, which averages each 2x2 block,
+ * followed by glGenerateMipmap. That costs a third of the source's memory rather than four thirds for a full
+ * resolution chain. It is sampled trilinearly, with anisotropic filtering where
+ * GL_EXT_texture_filter_anisotropic is available.
+ *
+ * The chain is taken from the resource pool and charged to the copy itself under the given name, so its cost
+ * shows up apart from the source's in the pool's usage report. If the pool's budget is exhausted texture()
+ * stays 0 and the caller should keep drawing from the source texture.
+ *
+ * Must only be used while the context it was created in is current*/
+class MipmappedTexture
+{
+public:
+    MipmappedTexture(GpuResourcePool *pool, const std::string &name);
+    ~MipmappedTexture();
+
+    ///returns whether the current context can blit textures and generate mipmaps
+    static bool isSupported();
+
+    ///copies the given texture, which must be of the given size, and regenerates the mip chain
+    void update(GLuint sourceTexture, glm::ivec2 size);
+
+    GLuint texture() const;
+    ///size of the source texture the copy was last made from
+    glm::ivec2 size() const;
+
+private:
+    GpuResourcePool *m_pool;
+    GLuint m_texture;
+    GLuint m_readFramebuffer, m_drawFramebuffer;
+    glm::ivec2 m_size, m_baseSize;
+
+    void allocate(glm::ivec2 size);
+};
+}
+
+#endif // MIPMAPPEDTEXTURE_H
@@ -0,0 +1,80 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#include <gl/openglextensions.h>
+
+#include <cstdio>
+#include <cstring>
+
+using namespace motorcar;
+
+bool OpenGLExtensions::hasExtension(const std::string &name)
+{
+    if(versionAtLeast(3, 0)){
+        GLint numExtensions = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+        for(GLint i = 0; i < numExtensions; i++){
+            const char *extension = (const char *) glGetStringi(GL_EXTENSIONS, i);
+            if(extension != NULL && name == extension){
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const char *extensions = (const char *) glGetString(GL_EXTENSIONS);
+    if(extensions == NULL){
+        return false;
+    }
+    //match whole names only, GL_ARB_foo must not match GL_ARB_foo_bar
+    const char *start = extensions;
+    while((start = std::strstr(start, name.c_str())) != NULL){
+        const char *end = start + name.size();
+        if((start == extensions || start[-1] == ' ') && (*end == ' ' || *end == '\0')){
+            return true;
+        }
+        start = end;
+    }
+    return false;
+}
+
+bool OpenGLExtensions::versionAtLeast(int major, int minor)
+{
+    const char *version = (const char *) glGetString(GL_VERSION);
+    int contextMajor = 0, contextMinor = 0;
+    if(version == NULL || std::sscanf(version, "%d.%d", &contextMajor, &contextMinor) != 2){
+        return false;
+    }
+    return contextMajor > major || (contextMajor == major && contextMinor >= minor);
+}
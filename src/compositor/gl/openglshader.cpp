@@ -46,8 +46,16 @@ using namespace motorcar;
 #define STRINGIZE(x) #x
 #define STRINGIZE_VALUE_OF(x) STRINGIZE(x)
 
+thread_local int OpenGLShader::s_drawingThreadSlot = -1;
+
 OpenGLShader::OpenGLShader(std::string vertexShaderFileName, std::string fragmentShaderFileName)
+    :m_creatingThread(std::this_thread::get_id())
 {
+    for(int slot = 0; slot < MAX_DRAWING_THREAD_SLOTS; slot++){
+        m_slotCopies[slot] = 0;
+        m_slotLinked[slot] = false;
+    }
+
     std::string shaderDirPath = STRINGIZE_VALUE_OF(MOTORCAR_SHADER_PATH);
     shaderDirPath += "/";
     std::cout << "shader path: " << STRINGIZE_VALUE_OF(MOTORCAR_SHADER_PATH) << std::endl;
@@ -76,16 +84,114 @@ OpenGLShader::OpenGLShader(std::string vertexShaderFileName, std::string fragmen
     vertexShaderStream.close();
     fragmentShaderStream.close();
 
+    m_vertexShader = vertexShader;
+    m_fragmentShader = fragmentShader;
     m_handle = compileShaderFromStrings(vertexShader, fragmentShader);
 
 }
 
+OpenGLShader::~OpenGLShader()
+{
+    for(int slot = 0; slot < MAX_DRAWING_THREAD_SLOTS; slot++){
+        if(m_slotCopies[slot] != 0){
+            glDeleteProgram(m_slotCopies[slot]);
+        }
+    }
+    for(std::map<std::thread::id, GLuint>::value_type &copy : m_copies){
+        if(copy.second != 0){
+            glDeleteProgram(copy.second);
+        }
+    }
+    glDeleteProgram(m_handle);
+}
+
+void OpenGLShader::setDrawingThreadSlot(int slot)
+{
+    if(slot < 0 || slot >= MAX_DRAWING_THREAD_SLOTS){
+        std::cout << "Warning: no shader slot " << slot << ", the thread will look its programs up under a lock" << std::endl;
+        slot = -1;
+    }
+    s_drawingThreadSlot = slot;
+}
+
 GLuint OpenGLShader::handle() const
 {
-    return m_handle;
+    int slot = s_drawingThreadSlot;
+    if(slot >= 0 && m_slotLinked[slot]){
+        return m_slotCopies[slot];
+    }
+
+    std::thread::id thread = std::this_thread::get_id();
+    if(thread == m_creatingThread || m_handle == 0){
+        return m_handle;
+    }
+
+    if(slot >= 0){
+        m_slotCopies[slot] = linkCopy();
+        m_slotLinked[slot] = true;
+        return m_slotCopies[slot];
+    }
+
+    std::lock_guard<std::mutex> lock(m_copiesMutex);
+    std::map<std::thread::id, GLuint>::iterator copy = m_copies.find(thread);
+    if(copy != m_copies.end()){
+        return copy->second;
+    }
+    GLuint program = linkCopy();
+    m_copies[thread] = program;
+    return program;
+}
+
+GLuint OpenGLShader::linkCopy() const
+{
+    GLuint program = compileShaderFromStrings(m_vertexShader, m_fragmentShader);
+    if(program == 0){
+        std::cerr << "Error: cannot link a copy of program " << m_handle << ", this thread will not draw with it" << std::endl;
+        return 0;
+    }
+
+    GLint count;
+    GLint size;
+    GLenum type;
+    GLchar name[256];
+
+    //attribute locations are fixed before linking again, uniform locations can only be checked afterwards
+    glGetProgramiv(m_handle, GL_ACTIVE_ATTRIBUTES, &count);
+    for(GLint i = 0; i < count; i++){
+        glGetActiveAttrib(m_handle, i, sizeof(name), NULL, &size, &type, name);
+        GLint location = glGetAttribLocation(m_handle, name);
+        if(location >= 0){
+            glBindAttribLocation(program, location, name);
+        }
+    }
+    glLinkProgram(program);
+
+    glUseProgram(program);
+    glGetProgramiv(m_handle, GL_ACTIVE_UNIFORMS, &count);
+    for(GLint i = 0; i < count; i++){
+        glGetActiveUniform(m_handle, i, sizeof(name), NULL, &size, &type, name);
+        GLint location = glGetUniformLocation(m_handle, name);
+        if(glGetUniformLocation(program, name) != location){
+            //sharing the original would let threads overwrite each other's uniforms mid draw
+            std::cerr << "Error: copy of program " << m_handle << " has a different location for uniform " << name
+                      << ", this thread will not draw with it" << std::endl;
+            glUseProgram(0);
+            glDeleteProgram(program);
+            return 0;
+        }
+        //sampler units are set once when the shader is created rather than before every draw, other integers are copied along
+        if(type == GL_SAMPLER_2D || type == GL_SAMPLER_CUBE || type == GL_INT){
+            GLint value;
+            glGetUniformiv(m_handle, location, &value);
+            glUniform1i(location, value);
+        }
+    }
+    glUseProgram(0);
+
+    return program;
 }
 
-GLuint OpenGLShader::compileShaderFromStrings(std::string &vertexShader, std::string &fragmentShader)
+GLuint OpenGLShader::compileShaderFromStrings(const std::string &vertexShader, const std::string &fragmentShader) const
 {
     GLuint VS; //handles to vert shader object
     GLuint FS; //handles to frag shader object
@@ -93,7 +199,7 @@ GLuint OpenGLShader::compileShaderFromStrings(std::string &vertexShader, std::st
 
 
     //create a program object and attach the compiled shader
-    m_handle = glCreateProgram();
+    GLuint program = glCreateProgram();
 
     if(vertexShader.length() > 0){
 
@@ -112,7 +218,7 @@ GLuint OpenGLShader::compileShaderFromStrings(std::string &vertexShader, std::st
                 std::cerr << "Error compiling vertex shader:\n" << std::endl;
                 return 0;
         }
-        glAttachShader(m_handle, VS);
+        glAttachShader(program, VS);
     }
 
     if(fragmentShader.length() > 0){
@@ -131,23 +237,23 @@ GLuint OpenGLShader::compileShaderFromStrings(std::string &vertexShader, std::st
                 std::cerr << "Error compiling fragment shader:\n" << std::endl;
                 return 0;
         }
-        glAttachShader(m_handle, FS);
+        glAttachShader(program, FS);
 
     }
 
-    glLinkProgram(m_handle);
+    glLinkProgram(program);
     /* check shader status requires helper functions */
     printOpenGLError();
-    glGetProgramiv(m_handle, GL_LINK_STATUS, &linked);
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
     if (!linked) {
-      std::cerr << "Error linking shader: " << m_handle << "\n" << std::endl;
+      std::cerr << "Error linking shader: " << program << "\n" << std::endl;
       return 0;
     }
 
 
-    //printProgramInfoLog(m_handle);
+    //printProgramInfoLog(program);
 
-    return m_handle;
+    return program;
 }
 
 
@@ -41,25 +41,64 @@
 #include <string>
 #include <fstream>
 #include <streambuf>
+#include <map>
+#include <mutex>
+#include <thread>
 
 
 
 
 
 namespace motorcar{
+///A linked program, of which every thread drawing with it gets its own copy
+/*Uniform values are state of the program object, which is shared between contexts, so threads drawing
+ * concurrently in different contexts with the same program would overwrite each other's uniforms. The
+ * thread which created the shader uses the program linked on creation, every other thread gets a copy
+ * linked from the same sources on its first call to handle(), with the same attribute locations and
+ * sampler units, so locations queried from the original are valid for every copy. Should the linker assign a
+ * copy's uniforms different locations, that thread gets program 0 and draws nothing with the shader, as
+ * sharing the original would race on its uniforms.
+ *
+ * Threads which draw every frame take a slot with setDrawingThreadSlot(), their copy is then looked up
+ * without locking. Any other thread falls back to a map guarded by a mutex.
+ *
+ * The copies are shared between contexts like the original, so the shader can be deleted by the thread
+ * which created it once no thread draws with it anymore*/
 class OpenGLShader
 {
 public:
     //OpenGLShader(std::string &vertexShader, std::string &fragmentShader);
     OpenGLShader(std::string vertexShaderFileName, std::string fragmentShaderFileName);
+    ~OpenGLShader();
 
+    ///returns the program for the calling thread, linking its copy if there is none yet
     GLuint handle() const;
 
+    ///number of threads which can take a slot
+    static const int MAX_DRAWING_THREAD_SLOTS = 8;
+    ///assigns the calling thread its own entry in every shader's copies, each slot must be used by one thread only
+    static void setDrawingThreadSlot(int slot);
+
 
 
 private:
     GLuint m_handle;
-    GLuint compileShaderFromStrings(std::string &vertexShader, std::string &fragmentShader);
+    std::string m_vertexShader, m_fragmentShader;
+    std::thread::id m_creatingThread;
+
+    //copies of threads with a slot, each entry is only written by its thread
+    mutable GLuint m_slotCopies[MAX_DRAWING_THREAD_SLOTS];
+    mutable bool m_slotLinked[MAX_DRAWING_THREAD_SLOTS];
+
+    mutable std::mutex m_copiesMutex;
+    mutable std::map<std::thread::id, GLuint> m_copies;
+
+    static thread_local int s_drawingThreadSlot;
+
+    GLuint compileShaderFromStrings(const std::string &vertexShader, const std::string &fragmentShader) const;
+    ///links a program from the shader's sources whose attribute locations and sampler units match the original's
+    /*returns 0 if the copy could not be linked or its uniforms were assigned different locations*/
+    GLuint linkCopy() const;
 };
 }
 
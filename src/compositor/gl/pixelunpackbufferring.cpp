@@ -0,0 +1,168 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#include <gl/pixelunpackbufferring.h>
+#include <gl/openglextensions.h>
+
+#include <iostream>
+
+using namespace motorcar;
+
+//offsets handed out are kept aligned so rows can be copied with aligned stores
+static const size_t ALLOCATION_ALIGNMENT = 64;
+
+PixelUnpackBufferRing::PixelUnpackBufferRing(size_t slotSize, unsigned int slotCount)
+    :m_buffer(0)
+    ,m_slotSize(slotSize)
+    ,m_slotCount(slotCount)
+    ,m_persistent(false)
+    ,m_persistentData(NULL)
+    ,m_mapped(false)
+    ,m_currentSlot(0)
+    ,m_slotOffset(0)
+    ,m_fences(slotCount, (GLsync) NULL)
+{
+    m_persistent = OpenGLExtensions::versionAtLeast(4, 4) ||
+            OpenGLExtensions::hasExtension("GL_ARB_buffer_storage");
+
+    glGenBuffers(1, &m_buffer);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_buffer);
+    if(m_persistent){
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_PIXEL_UNPACK_BUFFER, m_slotSize * m_slotCount, NULL, flags);
+        m_persistentData = (unsigned char *) glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, m_slotSize * m_slotCount, flags);
+        if(m_persistentData == NULL){
+            std::cout << "Warning: could not persistently map pixel unpack buffer, falling back to mapping per upload" << std::endl;
+            //storage created with glBufferStorage is immutable, so start over with a fresh buffer
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            glDeleteBuffers(1, &m_buffer);
+            glGenBuffers(1, &m_buffer);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_buffer);
+            m_persistent = false;
+        }
+    }
+    if(!m_persistent){
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, m_slotSize * m_slotCount, NULL, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+PixelUnpackBufferRing::~PixelUnpackBufferRing()
+{
+    for(GLsync fence : m_fences){
+        if(fence != NULL){
+            glDeleteSync(fence);
+        }
+    }
+    if(m_persistentData != NULL){
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_buffer);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+    glDeleteBuffers(1, &m_buffer);
+}
+
+bool PixelUnpackBufferRing::isSupported()
+{
+    return OpenGLExtensions::versionAtLeast(3, 2) || OpenGLExtensions::hasExtension("GL_ARB_sync");
+}
+
+bool PixelUnpackBufferRing::allocate(size_t size, void **data, GLintptr *offset)
+{
+    if(size > m_slotSize){
+        return false;
+    }
+    if(m_slotOffset + size > m_slotSize){
+        advanceSlot();
+    }
+
+    GLintptr bufferOffset = m_currentSlot * m_slotSize + m_slotOffset;
+    m_slotOffset = (m_slotOffset + size + ALLOCATION_ALIGNMENT - 1) & ~(ALLOCATION_ALIGNMENT - 1);
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_buffer);
+    if(m_persistent){
+        *data = m_persistentData + bufferOffset;
+    }else{
+        *data = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, bufferOffset, size,
+                                 GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        if(*data == NULL){
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            return false;
+        }
+        m_mapped = true;
+    }
+    *offset = bufferOffset;
+    return true;
+}
+
+void PixelUnpackBufferRing::unmap()
+{
+    if(m_mapped){
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        m_mapped = false;
+    }
+}
+
+void PixelUnpackBufferRing::release()
+{
+    unmap();
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+size_t PixelUnpackBufferRing::slotSize() const
+{
+    return m_slotSize;
+}
+
+void PixelUnpackBufferRing::advanceSlot()
+{
+    //everything issued so far that reads from the slot we are leaving is covered by this fence
+    if(m_fences[m_currentSlot] != NULL){
+        glDeleteSync(m_fences[m_currentSlot]);
+    }
+    m_fences[m_currentSlot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    m_currentSlot = (m_currentSlot + 1) % m_slotCount;
+    m_slotOffset = 0;
+
+    GLsync fence = m_fences[m_currentSlot];
+    if(fence != NULL){
+        GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        if(result == GL_TIMEOUT_EXPIRED || result == GL_WAIT_FAILED){
+            std::cout << "Warning: timed out waiting for pixel unpack buffer slot, uploads may be corrupted" << std::endl;
+        }
+        glDeleteSync(fence);
+        m_fences[m_currentSlot] = NULL;
+    }
+}
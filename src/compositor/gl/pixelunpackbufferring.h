@@ -0,0 +1,91 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#ifndef PIXELUNPACKBUFFERRING_H
+#define PIXELUNPACKBUFFERRING_H
+
+#include <GL/gl.h>
+#include <vector>
+#include <cstddef>
+
+namespace motorcar {
+///Ring of pixel unpack buffer space used to stream texture uploads
+/*Pixel data is copied into buffer space handed out by allocate() and the texture is then updated from
+ * the bound GL_PIXEL_UNPACK_BUFFER, so the transfer to the GPU happens asynchronously instead of inside
+ * glTexSubImage2D. The buffer is split into slots which are filled in order; when a slot is left a fence
+ * is inserted, and the slot is only reused once that fence has signaled.
+ *
+ * Where GL_ARB_buffer_storage is available the buffer is mapped once, persistently and coherently,
+ * otherwise each allocation maps its range unsynchronized (the fences already guarantee the GPU is done
+ * with it) and unmap() must be called before the upload is issued.
+ *
+ * Must only be used while the context it was created in is current*/
+class PixelUnpackBufferRing
+{
+public:
+    PixelUnpackBufferRing(size_t slotSize = 16 * 1024 * 1024, unsigned int slotCount = 3);
+    ~PixelUnpackBufferRing();
+
+    ///returns whether the current context supports pixel buffer objects and fence syncs
+    static bool isSupported();
+
+    ///reserves size bytes of buffer space
+    /*binds the buffer to GL_PIXEL_UNPACK_BUFFER and returns a pointer to write the pixel data to and the offset
+     * to pass to glTexSubImage2D in place of a client memory pointer, returns false if the request does not
+     * fit in a single slot, in which case nothing is bound and the caller should upload from client memory*/
+    bool allocate(size_t size, void **data, GLintptr *offset);
+    ///makes the data written since allocate() visible to GL, must be called before the data is used
+    void unmap();
+    ///unbinds the buffer from GL_PIXEL_UNPACK_BUFFER
+    void release();
+
+    size_t slotSize() const;
+
+private:
+    GLuint m_buffer;
+    size_t m_slotSize;
+    unsigned int m_slotCount;
+    bool m_persistent;
+    unsigned char *m_persistentData;
+    bool m_mapped;
+
+    unsigned int m_currentSlot;
+    size_t m_slotOffset;
+    std::vector<GLsync> m_fences;
+
+    void advanceSlot();
+};
+}
+
+#endif // PIXELUNPACKBUFFERRING_H
@@ -0,0 +1,319 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#include <gl/rendergraph.h>
+#include <gl/openglextensions.h>
+
+#include <iostream>
+#include <sstream>
+
+using namespace motorcar;
+
+//frames pooled storage may go unused before it is freed, long enough to ride out a display being briefly idle
+static const unsigned int MAX_IDLE_FRAMES = 120;
+
+RenderGraph::RenderGraph(GpuResourcePool *pool)
+    :m_pool(pool)
+    ,m_compiled(false)
+    ,m_invalidateSupported(-1)
+{
+}
+
+RenderGraph::~RenderGraph()
+{
+    for(Storage &storage : m_storage){
+        destroyStorage(storage);
+    }
+}
+
+void RenderGraph::reset()
+{
+    m_targets.clear();
+    m_passes.clear();
+    m_compiled = false;
+}
+
+RenderGraph::Target RenderGraph::createTarget(const std::string &name, glm::ivec2 size, int attachments, const void *owner)
+{
+    TargetInfo target = {name, size, attachments, owner, false, 0, -1, -1, -1};
+    m_targets.push_back(target);
+    return m_targets.size() - 1;
+}
+
+RenderGraph::Target RenderGraph::importTarget(const std::string &name, GLuint framebuffer, glm::ivec2 size)
+{
+    TargetInfo target = {name, size, COLOR | DEPTH_STENCIL, NULL, true, framebuffer, -1, -1, -1};
+    m_targets.push_back(target);
+    return m_targets.size() - 1;
+}
+
+RenderGraph::Pass RenderGraph::addPass(const std::string &name, RenderGraph::Executor *executor)
+{
+    PassInfo pass;
+    pass.name = name;
+    pass.executor = executor;
+    pass.culled = false;
+    m_passes.push_back(pass);
+    return m_passes.size() - 1;
+}
+
+void RenderGraph::read(RenderGraph::Pass pass, RenderGraph::Target target)
+{
+    m_passes[pass].reads.push_back(target);
+}
+
+void RenderGraph::write(RenderGraph::Pass pass, RenderGraph::Target target)
+{
+    m_passes[pass].writes.push_back(target);
+}
+
+void RenderGraph::compile()
+{
+    //a pass is needed if it writes something that is presented or read by a later pass which is needed
+    std::vector<bool> needed(m_targets.size(), false);
+    for(size_t t = 0; t < m_targets.size(); t++){
+        needed[t] = m_targets[t].imported;
+    }
+    for(int p = m_passes.size() - 1; p >= 0; p--){
+        PassInfo &pass = m_passes[p];
+        pass.culled = true;
+        for(Target target : pass.writes){
+            if(needed[target]){
+                pass.culled = false;
+            }
+        }
+        if(!pass.culled){
+            for(Target target : pass.reads){
+                needed[target] = true;
+            }
+        }
+    }
+
+    for(TargetInfo &target : m_targets){
+        target.firstUse = target.lastUse = -1;
+        target.storage = -1;
+    }
+    for(int p = 0; p < (int) m_passes.size(); p++){
+        if(m_passes[p].culled){
+            continue;
+        }
+        std::vector<Target> used(m_passes[p].reads);
+        used.insert(used.end(), m_passes[p].writes.begin(), m_passes[p].writes.end());
+        for(Target t : used){
+            TargetInfo &target = m_targets[t];
+            if(target.firstUse < 0){
+                target.firstUse = p;
+            }
+            target.lastUse = p;
+        }
+    }
+
+    //free storage that has not been needed for a while before handing out storage for this frame
+    for(size_t i = 0; i < m_storage.size();){
+        if(m_storage[i].idleFrames > MAX_IDLE_FRAMES){
+            destroyStorage(m_storage[i]);
+            m_storage.erase(m_storage.begin() + i);
+        }else{
+            m_storage[i].busyUntil = -1;
+            i++;
+        }
+    }
+
+    //targets are assigned in order of first use, so storage freed by an earlier target can be aliased by a later one
+    for(int p = 0; p < (int) m_passes.size(); p++){
+        for(TargetInfo &target : m_targets){
+            if(!target.imported && target.firstUse == p){
+                target.storage = acquireStorage(target, p);
+                m_storage[target.storage].busyUntil = target.lastUse;
+            }
+        }
+    }
+
+    for(Storage &storage : m_storage){
+        storage.idleFrames = storage.busyUntil < 0 ? storage.idleFrames + 1 : 0;
+    }
+
+    m_compiled = true;
+}
+
+void RenderGraph::execute()
+{
+    if(!m_compiled){
+        compile();
+    }
+
+    for(int p = 0; p < (int) m_passes.size(); p++){
+        PassInfo &pass = m_passes[p];
+        if(pass.culled){
+            continue;
+        }
+
+        //whatever an aliased target held before its first use belongs to another target, so it need not be loaded
+        for(size_t t = 0; t < m_targets.size(); t++){
+            if(m_targets[t].firstUse == p){
+                invalidate(t);
+            }
+        }
+
+        pass.executor->executePass(this, p);
+
+        for(size_t t = 0; t < m_targets.size(); t++){
+            if(m_targets[t].lastUse == p){
+                invalidate(t);
+            }
+        }
+    }
+}
+
+GLuint RenderGraph::framebuffer(RenderGraph::Target target) const
+{
+    const TargetInfo &info = m_targets[target];
+    if(info.imported){
+        return info.importedFramebuffer;
+    }
+    return info.storage < 0 ? 0 : m_storage[info.storage].framebuffer;
+}
+
+GLuint RenderGraph::texture(RenderGraph::Target target, RenderGraph::Attachment attachment) const
+{
+    const TargetInfo &info = m_targets[target];
+    if(info.imported || info.storage < 0){
+        return 0;
+    }
+    const Storage &storage = m_storage[info.storage];
+    return attachment == COLOR ? storage.colorTexture : storage.depthStencilTexture;
+}
+
+glm::ivec2 RenderGraph::size(RenderGraph::Target target) const
+{
+    return m_targets[target].size;
+}
+
+int RenderGraph::acquireStorage(const RenderGraph::TargetInfo &target, int pass)
+{
+    for(size_t i = 0; i < m_storage.size(); i++){
+        const Storage &storage = m_storage[i];
+        if(storage.busyUntil < pass && storage.owner == target.owner && storage.size == target.size &&
+                storage.attachments == target.attachments){
+            return i;
+        }
+    }
+    m_storage.push_back(createStorage(target.size, target.attachments, target.owner));
+    return m_storage.size() - 1;
+}
+
+RenderGraph::Storage RenderGraph::createStorage(glm::ivec2 size, int attachments, const void *owner)
+{
+    Storage storage = {size, attachments, owner, 0, 0, 0, -1, 0};
+
+    if(m_ownerStorageCount[owner]++ == 0){
+        std::ostringstream name;
+        name << "render targets of display " << owner;
+        m_pool->registerOwner(owner, name.str());
+    }
+
+    glGenFramebuffers(1, &storage.framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, storage.framebuffer);
+
+    if(attachments & COLOR){
+        storage.colorTexture = m_pool->acquireTexture(owner, GL_RGBA8, size, 1, true);
+        glBindTexture(GL_TEXTURE_2D, storage.colorTexture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, storage.colorTexture, 0);
+    }
+
+    if(attachments & DEPTH_STENCIL){
+        storage.depthStencilTexture = m_pool->acquireTexture(owner, GL_DEPTH24_STENCIL8, size, 1, true);
+        glBindTexture(GL_TEXTURE_2D, storage.depthStencilTexture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, storage.depthStencilTexture, 0);
+    }
+
+    if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE){
+        std::cout << "Warning: render graph framebuffer of size " << size.x << ", " << size.y << " is incomplete" << std::endl;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return storage;
+}
+
+void RenderGraph::destroyStorage(RenderGraph::Storage &storage)
+{
+    glDeleteFramebuffers(1, &storage.framebuffer);
+    m_pool->releaseTexture(storage.colorTexture);
+    m_pool->releaseTexture(storage.depthStencilTexture);
+
+    if(--m_ownerStorageCount[storage.owner] == 0){
+        m_ownerStorageCount.erase(storage.owner);
+        m_pool->unregisterOwner(storage.owner);
+    }
+}
+
+void RenderGraph::invalidate(RenderGraph::Target target)
+{
+    const TargetInfo &info = m_targets[target];
+    if(info.imported || info.storage < 0){
+        return;
+    }
+
+    if(m_invalidateSupported < 0){
+        m_invalidateSupported = OpenGLExtensions::versionAtLeast(4, 3) ||
+                OpenGLExtensions::hasExtension("GL_ARB_invalidate_subdata");
+    }
+    if(!m_invalidateSupported){
+        return;
+    }
+
+    GLenum attachments[2];
+    GLsizei count = 0;
+    if(info.attachments & COLOR){
+        attachments[count++] = GL_COLOR_ATTACHMENT0;
+    }
+    if(info.attachments & DEPTH_STENCIL){
+        attachments[count++] = GL_DEPTH_STENCIL_ATTACHMENT;
+    }
+
+    GLint previous = 0;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previous);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_storage[info.storage].framebuffer);
+    glInvalidateFramebuffer(GL_DRAW_FRAMEBUFFER, count, attachments);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previous);
+}
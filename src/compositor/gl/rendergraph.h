@@ -0,0 +1,159 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#ifndef RENDERGRAPH_H
+#define RENDERGRAPH_H
+
+#include <gl/gpuresourcepool.h>
+
+#include <GL/gl.h>
+#include <glm/glm.hpp>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace motorcar {
+///Per frame graph of render passes and the render targets they read and write
+/*Each frame the passes are declared in the order they should run, together with the render targets
+ * they write to and read from. Targets are either imported (a framebuffer owned elsewhere, like the
+ * window's default framebuffer) or transient, in which case the graph provides a framebuffer with the
+ * requested attachments for as long as the target is used within the frame.
+ *
+ * compile() drops passes whose results never reach an imported target, then assigns the transient
+ * targets to pooled framebuffers; targets whose lifetimes do not overlap share the same storage. When
+ * the context supports it the attachments are invalidated before their first and after their last use
+ * in the frame, so the driver never has to preserve contents which are about to be overwritten.
+ *
+ * Pooled framebuffers survive between frames and are freed once they have gone unused for a while,
+ * so resizing a display does not leak its old targets. Their attachments come from the resource pool
+ * and are accounted there under whoever declared the target, usually a display, and storage is only
+ * aliased between targets of the same owner so that each one is charged for what it actually uses.
+ * As nothing can be drawn without them, render targets are granted even when that exceeds the budget.
+ *
+ * Must only be used while the compositor's OpenGL context is current*/
+class RenderGraph
+{
+public:
+    enum Attachment{
+        COLOR = 1,
+        DEPTH_STENCIL = 2
+    };
+
+    typedef int Target;
+    typedef int Pass;
+
+    ///Implemented by whatever declares passes, called back when each of its passes runs
+    class Executor
+    {
+    public:
+        virtual ~Executor() {}
+        virtual void executePass(RenderGraph *graph, Pass pass) = 0;
+    };
+
+    RenderGraph(GpuResourcePool *pool);
+    ~RenderGraph();
+
+    ///forgets the passes and targets declared for the previous frame, pooled framebuffers are kept
+    void reset();
+
+    ///declares a render target backed by pooled storage, attachments is a combination of Attachment flags
+    /*the storage is charged to the given owner in the resource pool*/
+    Target createTarget(const std::string &name, glm::ivec2 size, int attachments, const void *owner);
+    ///declares a render target drawing into an existing framebuffer, passes writing to it are never culled
+    Target importTarget(const std::string &name, GLuint framebuffer, glm::ivec2 size);
+
+    Pass addPass(const std::string &name, Executor *executor);
+    void read(Pass pass, Target target);
+    void write(Pass pass, Target target);
+
+    ///culls unused passes and assigns storage to the transient targets
+    void compile();
+    ///runs the passes which survived compile() in the order they were declared
+    void execute();
+
+    ///returns the framebuffer of the target, only valid after compile() and until the next reset()
+    GLuint framebuffer(Target target) const;
+    ///returns the texture holding the given attachment of a transient target, 0 for imported targets
+    GLuint texture(Target target, Attachment attachment) const;
+    glm::ivec2 size(Target target) const;
+
+private:
+    struct TargetInfo{
+        std::string name;
+        glm::ivec2 size;
+        int attachments;
+        const void *owner;
+        bool imported;
+        GLuint importedFramebuffer;
+        //indices of the first and last surviving pass using this target, -1 if unused
+        int firstUse, lastUse;
+        //index into m_storage for transient targets
+        int storage;
+    };
+
+    struct PassInfo{
+        std::string name;
+        Executor *executor;
+        std::vector<Target> reads, writes;
+        bool culled;
+    };
+
+    struct Storage{
+        glm::ivec2 size;
+        int attachments;
+        const void *owner;
+        GLuint framebuffer, colorTexture, depthStencilTexture;
+        //last pass in the current frame using this storage, -1 if it is free this frame
+        int busyUntil;
+        unsigned int idleFrames;
+    };
+
+    GpuResourcePool *m_pool;
+    std::vector<TargetInfo> m_targets;
+    std::vector<PassInfo> m_passes;
+    std::vector<Storage> m_storage;
+    //number of pooled storages held by each owner, which are registered with the pool while they hold any
+    std::map<const void *, int> m_ownerStorageCount;
+    bool m_compiled;
+    int m_invalidateSupported;
+
+    int acquireStorage(const TargetInfo &target, int pass);
+    Storage createStorage(glm::ivec2 size, int attachments, const void *owner);
+    void destroyStorage(Storage &storage);
+    void invalidate(Target target);
+};
+}
+
+#endif // RENDERGRAPH_H
@@ -0,0 +1,234 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#include <gl/textureatlas.h>
+#include <gl/openglextensions.h>
+
+#include <climits>
+
+using namespace motorcar;
+
+static const int GUTTER = 1;
+
+TextureAtlas::TextureAtlas(GpuResourcePool *pool, int size)
+    :m_pool(pool)
+    ,m_size(size)
+    ,m_texture(0)
+    ,m_readFramebuffer(0)
+    ,m_drawFramebuffer(0)
+    ,m_generation(0)
+    ,m_usedArea(0)
+    ,m_freedArea(0)
+{
+    m_pool->registerOwner(this, "surface atlas");
+    m_texture = m_pool->acquireTexture(this, GL_RGBA8, glm::ivec2(m_size));
+    glBindTexture(GL_TEXTURE_2D, m_texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &m_readFramebuffer);
+    glGenFramebuffers(1, &m_drawFramebuffer);
+
+    clear();
+}
+
+TextureAtlas::~TextureAtlas()
+{
+    glDeleteFramebuffers(1, &m_readFramebuffer);
+    glDeleteFramebuffers(1, &m_drawFramebuffer);
+    m_pool->releaseTexture(m_texture);
+    m_pool->unregisterOwner(this);
+}
+
+bool TextureAtlas::isSupported()
+{
+    return OpenGLExtensions::versionAtLeast(3, 0) || OpenGLExtensions::hasExtension("GL_ARB_framebuffer_object");
+}
+
+bool TextureAtlas::allocate(glm::ivec2 size, glm::ivec4 *region)
+{
+    int width = size.x + 2 * GUTTER;
+    int height = size.y + 2 * GUTTER;
+    if(size.x <= 0 || size.y <= 0 || width > m_size || height > m_size){
+        return false;
+    }
+
+    int index, x, y;
+    if(!findPosition(width, height, &index, &x, &y)){
+        if(m_freedArea == 0){
+            return false;
+        }
+        //start over, everybody still holding a region will allocate again for the new generation
+        clear();
+        m_generation++;
+        if(!findPosition(width, height, &index, &x, &y)){
+            return false;
+        }
+    }
+
+    addSkylineLevel(index, x, y, width, height);
+    m_usedArea += (long) width * height;
+    *region = glm::ivec4(x + GUTTER, y + GUTTER, size.x, size.y);
+    return true;
+}
+
+void TextureAtlas::free(const glm::ivec4 &region, unsigned int generation)
+{
+    if(generation != m_generation){
+        return;
+    }
+    m_freedArea += (long) (region.z + 2 * GUTTER) * (region.w + 2 * GUTTER);
+    if(m_freedArea >= m_usedArea){
+        //nothing is left in the atlas, so it can be reused without invalidating anyone
+        clear();
+    }
+}
+
+void TextureAtlas::copy(GLuint sourceTexture, const glm::ivec4 &region)
+{
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_readFramebuffer);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, sourceTexture, 0);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_drawFramebuffer);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_texture, 0);
+
+    int x = region.x, y = region.y, width = region.z, height = region.w;
+    glBlitFramebuffer(0, 0, width, height, x, y, x + width, y + height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+    //fill the gutter by stretching the outermost texels outwards
+    glBlitFramebuffer(0, 0, width, 1, x, y - GUTTER, x + width, y, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBlitFramebuffer(0, height - 1, width, height, x, y + height, x + width, y + height + GUTTER, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBlitFramebuffer(0, 0, 1, height, x - GUTTER, y, x, y + height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBlitFramebuffer(width - 1, 0, width, height, x + width, y, x + width + GUTTER, y + height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+glm::vec4 TextureAtlas::textureCoordinates(const glm::ivec4 &region) const
+{
+    return glm::vec4(region) / (float) m_size;
+}
+
+GLuint TextureAtlas::texture() const
+{
+    return m_texture;
+}
+
+int TextureAtlas::size() const
+{
+    return m_size;
+}
+
+unsigned int TextureAtlas::generation() const
+{
+    return m_generation;
+}
+
+void TextureAtlas::clear()
+{
+    m_skyline.clear();
+    SkylineSegment floor = {0, 0, m_size};
+    m_skyline.push_back(floor);
+    m_usedArea = 0;
+    m_freedArea = 0;
+}
+
+bool TextureAtlas::findPosition(int width, int height, int *bestIndex, int *bestX, int *bestY) const
+{
+    int bestTop = INT_MAX, bestWidth = INT_MAX;
+    *bestIndex = -1;
+
+    for(size_t i = 0; i < m_skyline.size(); i++){
+        int x = m_skyline[i].x;
+        if(x + width > m_size){
+            break;
+        }
+        //the region rests on the highest segment it spans
+        int y = 0;
+        int remaining = width;
+        for(size_t j = i; remaining > 0; j++){
+            if(m_skyline[j].y > y){
+                y = m_skyline[j].y;
+            }
+            remaining -= m_skyline[j].width;
+        }
+        if(y + height > m_size){
+            continue;
+        }
+        //prefer the lowest top, then the narrowest segment so wide gaps stay available
+        if(y + height < bestTop || (y + height == bestTop && m_skyline[i].width < bestWidth)){
+            bestTop = y + height;
+            bestWidth = m_skyline[i].width;
+            *bestIndex = i;
+            *bestX = x;
+            *bestY = y;
+        }
+    }
+    return *bestIndex >= 0;
+}
+
+void TextureAtlas::addSkylineLevel(int index, int x, int y, int width, int height)
+{
+    SkylineSegment segment = {x, y + height, width};
+    m_skyline.insert(m_skyline.begin() + index, segment);
+
+    //shrink or remove the segments the new one now covers
+    for(size_t i = index + 1; i < m_skyline.size(); i++){
+        int previousEnd = m_skyline[i - 1].x + m_skyline[i - 1].width;
+        if(m_skyline[i].x >= previousEnd){
+            break;
+        }
+        int shrink = previousEnd - m_skyline[i].x;
+        m_skyline[i].x += shrink;
+        m_skyline[i].width -= shrink;
+        if(m_skyline[i].width > 0){
+            break;
+        }
+        m_skyline.erase(m_skyline.begin() + i);
+        i--;
+    }
+
+    //merge neighbouring segments at the same height
+    for(size_t i = 0; i + 1 < m_skyline.size(); i++){
+        if(m_skyline[i].y == m_skyline[i + 1].y){
+            m_skyline[i].width += m_skyline[i + 1].width;
+            m_skyline.erase(m_skyline.begin() + i + 1);
+            i--;
+        }
+    }
+}
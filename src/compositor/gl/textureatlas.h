@@ -0,0 +1,102 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#ifndef TEXTUREATLAS_H
+#define TEXTUREATLAS_H
+
+#include <gl/gpuresourcepool.h>
+
+#include <glm/glm.hpp>
+#include <GL/gl.h>
+
+#include <vector>
+
+namespace motorcar {
+///Single texture holding many small images, packed with a skyline allocator
+/*Regions are packed bottom-left first along a skyline of the tops of the regions allocated so far,
+ * which wastes little space for the mix of cursor, menu and tooltip sizes the atlas is meant for.
+ * Freed space is not reused individually; once an allocation does not fit and some space has been
+ * freed the whole atlas is cleared and generation() is incremented, at which point every holder of a
+ * region from an older generation has to allocate and copy its image again.
+ *
+ * Each region is surrounded by a one texel gutter so that linear filtering does not bleed neighbours in.
+ *
+ * Must only be used while the context it was created in is current*/
+class TextureAtlas
+{
+public:
+    ///the atlas texture is taken from the pool, texture() is 0 if the pool's budget did not allow for it
+    TextureAtlas(GpuResourcePool *pool, int size = 1024);
+    ~TextureAtlas();
+
+    ///returns whether the current context can copy textures into the atlas
+    static bool isSupported();
+
+    ///reserves space for an image of the given size, returning its region as (x, y, width, height) in texels
+    /*returns false if the image does not fit even in an empty atlas, the region is only valid for the
+     * generation current after this call*/
+    bool allocate(glm::ivec2 size, glm::ivec4 *region);
+    ///marks a region as no longer used, regions from an older generation are ignored
+    void free(const glm::ivec4 &region, unsigned int generation);
+
+    ///copies the given texture, which must be the size of region, into the region
+    void copy(GLuint sourceTexture, const glm::ivec4 &region);
+
+    ///returns the texture coordinates of the region as (s, t, width, height)
+    glm::vec4 textureCoordinates(const glm::ivec4 &region) const;
+
+    GLuint texture() const;
+    int size() const;
+    unsigned int generation() const;
+
+private:
+    struct SkylineSegment{
+        int x, y, width;
+    };
+
+    GpuResourcePool *m_pool;
+    int m_size;
+    GLuint m_texture;
+    GLuint m_readFramebuffer, m_drawFramebuffer;
+    std::vector<SkylineSegment> m_skyline;
+    unsigned int m_generation;
+    long m_usedArea, m_freedArea;
+
+    void clear();
+    bool findPosition(int width, int height, int *bestIndex, int *bestX, int *bestY) const;
+    void addSkylineLevel(int index, int x, int y, int width, int height);
+};
+}
+
+#endif // TEXTUREATLAS_H
@@ -0,0 +1,153 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#include <gl/texturemailbox.h>
+#include <gl/gpuresourcepool.h>
+
+#include <iostream>
+
+using namespace motorcar;
+
+TextureMailbox::TextureMailbox(GpuResourcePool *resourcePool)
+    :m_resourcePool(resourcePool)
+    ,m_writing(-1)
+    ,m_published(-1)
+    ,m_reading(-1)
+{
+    m_resourcePool->registerOwner(this, "texture mailbox");
+    for(Slot &slot : m_slots){
+        slot.texture = 0;
+        slot.size = glm::ivec2(0);
+        slot.writtenFence = 0;
+        slot.readFence = 0;
+    }
+}
+
+TextureMailbox::~TextureMailbox()
+{
+    for(Slot &slot : m_slots){
+        if(slot.texture != 0){
+            m_resourcePool->releaseTexture(slot.texture);
+        }
+        if(slot.writtenFence != 0){
+            glDeleteSync(slot.writtenFence);
+        }
+        if(slot.readFence != 0){
+            glDeleteSync(slot.readFence);
+        }
+    }
+    m_resourcePool->unregisterOwner(this);
+}
+
+void TextureMailbox::replaceFence(GLsync *fence)
+{
+    //deletion is deferred by GL until nobody waits on the fence anymore
+    if(*fence != 0){
+        glDeleteSync(*fence);
+    }
+    *fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    //the fence is only guaranteed to signal once it has been flushed from the context that created it
+    glFlush();
+}
+
+GLuint TextureMailbox::beginWrite(glm::ivec2 size)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for(int i = 0; i < 3; i++){
+        if(i != m_published && i != m_reading){
+            m_writing = i;
+            break;
+        }
+    }
+
+    Slot &slot = m_slots[m_writing];
+    if(slot.readFence != 0){
+        glWaitSync(slot.readFence, 0, GL_TIMEOUT_IGNORED);
+    }
+
+    if(slot.texture == 0 || slot.size != size){
+        if(slot.texture != 0){
+            m_resourcePool->releaseTexture(slot.texture);
+        }
+        slot.texture = m_resourcePool->acquireTexture(this, GL_RGBA8, size);
+        slot.size = size;
+        if(slot.texture == 0){
+            std::cout << "Warning: no memory left for a " << size.x << "x" << size.y << " mailbox texture" << std::endl;
+            m_writing = -1;
+            return 0;
+        }
+        glBindTexture(GL_TEXTURE_2D, slot.texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    return slot.texture;
+}
+
+void TextureMailbox::endWrite()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(m_writing < 0){
+        return;
+    }
+    replaceFence(&m_slots[m_writing].writtenFence);
+    m_published = m_writing;
+    m_writing = -1;
+}
+
+GLuint TextureMailbox::beginRead(glm::ivec2 *size)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(m_published < 0){
+        return 0;
+    }
+    m_reading = m_published;
+
+    Slot &slot = m_slots[m_reading];
+    glWaitSync(slot.writtenFence, 0, GL_TIMEOUT_IGNORED);
+    *size = slot.size;
+    return slot.texture;
+}
+
+void TextureMailbox::endRead()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(m_reading < 0){
+        return;
+    }
+    replaceFence(&m_slots[m_reading].readFence);
+    m_reading = -1;
+}
@@ -0,0 +1,88 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#ifndef TEXTUREMAILBOX_H
+#define TEXTUREMAILBOX_H
+
+#include <GL/gl.h>
+#include <glm/glm.hpp>
+
+#include <mutex>
+
+namespace motorcar {
+class GpuResourcePool;
+///Hands images drawn in one context to another context sharing objects with it
+/*The writer fills one of three textures while the reader samples the most recently published one, so
+ * neither ever waits for the other to finish a frame; a published image which is not read before the
+ * next one is published is skipped. Fences make the reader's commands wait for the writer's, and the
+ * writer's for the reader's before a texture is filled again, so the threads only block on the GPU.
+ *
+ * Textures come from the resource pool and are reallocated when the size written changes. The mailbox
+ * must be deleted with a context current which shares objects with the writer's and reader's*/
+class TextureMailbox
+{
+public:
+    TextureMailbox(GpuResourcePool *resourcePool);
+    ~TextureMailbox();
+
+    ///returns a texture of the given size to fill, or 0 if the pool is out of memory
+    /*commands issued in the current context after this call wait for the reader to have finished sampling it*/
+    GLuint beginWrite(glm::ivec2 size);
+    ///publishes the texture returned by beginWrite() once the commands filling it, issued in the current context, have completed
+    void endWrite();
+
+    ///returns the most recently published texture and stores its size, or returns 0 if nothing was published yet
+    /*commands issued in the current context after this call wait for the commands filling it to have completed*/
+    GLuint beginRead(glm::ivec2 *size);
+    ///gives back the texture returned by beginRead() once the commands sampling it, issued in the current context, have completed
+    void endRead();
+
+private:
+    struct Slot{
+        GLuint texture;
+        glm::ivec2 size;
+        //signalled once the texture has been filled and once it was last sampled
+        GLsync writtenFence, readFence;
+    };
+
+    GpuResourcePool *m_resourcePool;
+    Slot m_slots[3];
+    int m_writing, m_published, m_reading;
+    std::mutex m_mutex;
+
+    static void replaceFence(GLsync *fence);
+};
+}
+
+#endif // TEXTUREMAILBOX_H
@@ -0,0 +1,300 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#include <profiling/framestatistics.h>
+#include <gl/openglextensions.h>
+
+#include <signal.h>
+#include <cmath>
+#include <cstring>
+
+using namespace motorcar;
+
+static volatile sig_atomic_t g_dumpRequested = 0;
+
+static void handleDumpSignal(int)
+{
+    g_dumpRequested = 1;
+}
+
+FrameStatistics::FrameStatistics(float refreshRateHz)
+    :m_cpuTime("cpu time", "ms")
+    ,m_gpuTime("gpu time", "ms")
+    ,m_swapInterval("swap interval", "ms")
+    ,m_frameCount(0)
+    ,m_missedVBlanks(0)
+    ,m_framesWithMissedVBlanks(0)
+    ,m_refreshRateHz(refreshRateHz)
+    ,m_reportIntervalSeconds(5)
+    ,m_gpuTimingSupported(false)
+    ,m_gpuTimingInitialized(false)
+    ,m_startTime(Clock::now())
+    ,m_hasSwapped(false)
+    ,m_framesSinceReport(0)
+    ,m_missedSinceReport(0)
+{
+    m_lastReportTime = m_startTime;
+    m_lastSwapTime = m_startTime;
+    m_currentFrame.gpuQuery = 0;
+}
+
+FrameStatistics::~FrameStatistics()
+{
+    if(m_csvLog.is_open()){
+        m_csvLog.close();
+    }
+}
+
+void FrameStatistics::beginFrame()
+{
+    if(!m_gpuTimingInitialized){
+        initializeGpuTiming();
+    }
+
+    collectPendingFrames(false);
+
+    m_currentFrame.frameNumber = m_frameCount;
+    m_currentFrame.beginTime = Clock::now();
+    m_currentFrame.cpuMicros = 0;
+    m_currentFrame.swapIntervalMicros = 0;
+    m_currentFrame.missedVBlanks = 0;
+    m_currentFrame.gpuQuery = 0;
+
+    if(m_gpuTimingSupported){
+        if(m_freeQueries.empty()){
+            collectPendingFrames(true);
+        }
+        m_currentFrame.gpuQuery = m_freeQueries.front();
+        m_freeQueries.pop_front();
+        glBeginQuery(GL_TIME_ELAPSED, m_currentFrame.gpuQuery);
+    }
+}
+
+void FrameStatistics::endCpuWork()
+{
+    m_currentFrame.cpuMicros = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - m_currentFrame.beginTime).count();
+    if(m_currentFrame.gpuQuery != 0){
+        glEndQuery(GL_TIME_ELAPSED);
+    }
+}
+
+void FrameStatistics::endFrame()
+{
+    Clock::time_point now = Clock::now();
+
+    if(m_hasSwapped){
+        m_currentFrame.swapIntervalMicros = std::chrono::duration_cast<std::chrono::microseconds>(now - m_lastSwapTime).count();
+        if(m_refreshRateHz > 0){
+            double refreshPeriodMicros = 1000000.0 / m_refreshRateHz;
+            long vblanks = std::lround(m_currentFrame.swapIntervalMicros / refreshPeriodMicros);
+            m_currentFrame.missedVBlanks = vblanks > 1 ? vblanks - 1 : 0;
+        }
+    }
+    m_lastSwapTime = now;
+
+    if(m_currentFrame.gpuQuery != 0){
+        m_pendingFrames.push_back(m_currentFrame);
+    }else{
+        finishFrameRecord(m_currentFrame, 0, false);
+    }
+    m_hasSwapped = true;
+    m_frameCount++;
+
+    if(g_dumpRequested){
+        g_dumpRequested = 0;
+        dump();
+    }
+
+    if(m_reportIntervalSeconds > 0 &&
+            now - m_lastReportTime >= std::chrono::seconds(m_reportIntervalSeconds)){
+        printSummary();
+        m_lastReportTime = now;
+        m_framesSinceReport = 0;
+        m_missedSinceReport = 0;
+    }
+}
+
+void FrameStatistics::dump(std::ostream &stream)
+{
+    double seconds = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - m_startTime).count() / 1000.0;
+    stream << "Frame statistics: " << m_frameCount << " frames in " << seconds << " seconds at "
+           << m_refreshRateHz << " Hz refresh" << std::endl;
+    m_cpuTime.print(stream, 0.001);
+    if(m_gpuTimingSupported){
+        m_gpuTime.print(stream, 0.001);
+    }else{
+        stream << "gpu time: not available, context does not support timer queries" << std::endl;
+    }
+    m_swapInterval.print(stream, 0.001);
+    stream << "missed vblanks: " << m_missedVBlanks << " in " << m_framesWithMissedVBlanks
+           << " frames (" << (m_frameCount > 0 ? 100.0 * m_framesWithMissedVBlanks / m_frameCount : 0)
+           << "%)" << std::endl;
+}
+
+void FrameStatistics::reset()
+{
+    m_cpuTime.reset();
+    m_gpuTime.reset();
+    m_swapInterval.reset();
+    m_frameCount = 0;
+    m_missedVBlanks = 0;
+    m_framesWithMissedVBlanks = 0;
+    m_startTime = Clock::now();
+}
+
+void FrameStatistics::installSignalHandler()
+{
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = handleDumpSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    if(sigaction(SIGUSR1, &action, NULL) != 0){
+        std::cerr << "Warning: could not install SIGUSR1 handler for frame statistics" << std::endl;
+    }
+}
+
+void FrameStatistics::setCsvLogPath(const std::string &path)
+{
+    if(m_csvLog.is_open()){
+        m_csvLog.close();
+    }
+    if(path.empty()){
+        return;
+    }
+    m_csvLog.open(path.c_str(), std::ios::out | std::ios::trunc);
+    if(m_csvLog.is_open()){
+        m_csvLog << "frame,time_ms,cpu_us,gpu_us,swap_interval_us,missed_vblanks" << std::endl;
+        std::cout << "logging frame statistics to " << path << std::endl;
+    }else{
+        std::cerr << "Warning: could not open frame statistics log " << path << std::endl;
+    }
+}
+
+float FrameStatistics::refreshRateHz() const
+{
+    return m_refreshRateHz;
+}
+
+void FrameStatistics::setRefreshRateHz(float refreshRateHz)
+{
+    m_refreshRateHz = refreshRateHz;
+}
+
+int FrameStatistics::reportIntervalSeconds() const
+{
+    return m_reportIntervalSeconds;
+}
+
+void FrameStatistics::setReportIntervalSeconds(int reportIntervalSeconds)
+{
+    m_reportIntervalSeconds = reportIntervalSeconds;
+}
+
+std::chrono::steady_clock::time_point FrameStatistics::lastSwapTime() const
+{
+    return m_lastSwapTime;
+}
+
+void FrameStatistics::initializeGpuTiming()
+{
+    m_gpuTimingInitialized = true;
+    m_gpuTimingSupported = OpenGLExtensions::versionAtLeast(3, 3) ||
+            OpenGLExtensions::hasExtension("GL_ARB_timer_query");
+    if(m_gpuTimingSupported){
+        GLuint queries[MAX_PENDING_QUERIES];
+        glGenQueries(MAX_PENDING_QUERIES, queries);
+        for(int i = 0; i < MAX_PENDING_QUERIES; i++){
+            m_freeQueries.push_back(queries[i]);
+        }
+    }
+}
+
+void FrameStatistics::collectPendingFrames(bool block)
+{
+    while(!m_pendingFrames.empty()){
+        const FrameRecord &record = m_pendingFrames.front();
+        if(!block){
+            GLuint available = 0;
+            glGetQueryObjectuiv(record.gpuQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+            if(!available){
+                return;
+            }
+        }
+        //only ever wait for the oldest query
+        block = false;
+
+        GLuint64 gpuNanos = 0;
+        glGetQueryObjectui64v(record.gpuQuery, GL_QUERY_RESULT, &gpuNanos);
+        finishFrameRecord(record, gpuNanos, true);
+        m_freeQueries.push_back(record.gpuQuery);
+        m_pendingFrames.pop_front();
+    }
+}
+
+void FrameStatistics::finishFrameRecord(const FrameRecord &record, uint64_t gpuNanos, bool hasGpuTime)
+{
+    m_cpuTime.record(record.cpuMicros);
+    if(hasGpuTime){
+        m_gpuTime.record(gpuNanos / 1000);
+    }
+    //the first frame has nothing to measure its swap interval against
+    if(record.swapIntervalMicros > 0){
+        m_swapInterval.record(record.swapIntervalMicros);
+    }
+    if(record.missedVBlanks > 0){
+        m_missedVBlanks += record.missedVBlanks;
+        m_missedSinceReport += record.missedVBlanks;
+        m_framesWithMissedVBlanks++;
+    }
+    m_framesSinceReport++;
+
+    if(m_csvLog.is_open()){
+        m_csvLog << record.frameNumber << ","
+                 << std::chrono::duration_cast<std::chrono::milliseconds>(record.beginTime - m_startTime).count() << ","
+                 << record.cpuMicros << ",";
+        if(hasGpuTime){
+            m_csvLog << gpuNanos / 1000;
+        }
+        m_csvLog << "," << record.swapIntervalMicros << "," << record.missedVBlanks << "\n";
+    }
+}
+
+void FrameStatistics::printSummary()
+{
+    float fps = (float) m_framesSinceReport / m_reportIntervalSeconds;
+    std::cout << m_framesSinceReport << " frames in " << m_reportIntervalSeconds << " seconds: " << fps
+              << " fps, overall swap interval p99 " << m_swapInterval.valueAtPercentile(99) / 1000.0
+              << " ms, " << m_missedSinceReport << " missed vblanks" << std::endl;
+}
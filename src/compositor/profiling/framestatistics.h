@@ -0,0 +1,132 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#ifndef FRAMESTATISTICS_H
+#define FRAMESTATISTICS_H
+
+#include <profiling/histogram.h>
+
+#include <GL/gl.h>
+
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace motorcar {
+///Collects per-frame timing statistics for the compositor main loop
+/*Records CPU time, GPU time (using GL_TIME_ELAPSED queries when the context supports timer queries),
+ * the interval between buffer swaps and the number of vertical blanks missed by each frame into
+ * histograms, so that occasional dropped frames show up in the tail percentiles instead of being
+ * averaged away.
+ *
+ * A summary is printed periodically, a full dump is printed when the process receives SIGUSR1
+ * (see installSignalHandler) and whenever dump() is called, and every frame can optionally be
+ * appended to a CSV file for offline analysis.
+ *
+ * The compositor is expected to call beginFrame() before doing any work for a frame, endCpuWork()
+ * just before swapping buffers and endFrame() once the swap returns, all with the rendering
+ * context current*/
+class FrameStatistics
+{
+public:
+    FrameStatistics(float refreshRateHz = 60);
+    ~FrameStatistics();
+
+    void beginFrame();
+    void endCpuWork();
+    void endFrame();
+
+    ///prints the full set of histograms
+    void dump(std::ostream &stream = std::cout);
+    void reset();
+
+    ///registers a SIGUSR1 handler which makes the next call to endFrame() print a dump
+    static void installSignalHandler();
+
+    ///opens the given file and appends one line per frame to it, pass an empty string to stop logging
+    void setCsvLogPath(const std::string &path);
+
+    float refreshRateHz() const;
+    void setRefreshRateHz(float refreshRateHz);
+
+    ///interval in seconds between single line summaries, 0 disables them
+    int reportIntervalSeconds() const;
+    void setReportIntervalSeconds(int reportIntervalSeconds);
+
+    ///time at which the most recent buffer swap returned
+    std::chrono::steady_clock::time_point lastSwapTime() const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct FrameRecord
+    {
+        uint64_t frameNumber;
+        Clock::time_point beginTime;
+        uint64_t cpuMicros;
+        uint64_t swapIntervalMicros;
+        unsigned int missedVBlanks;
+        GLuint gpuQuery;
+    };
+
+    static const int MAX_PENDING_QUERIES = 4;
+
+    Histogram m_cpuTime, m_gpuTime, m_swapInterval;
+    uint64_t m_frameCount, m_missedVBlanks, m_framesWithMissedVBlanks;
+
+    float m_refreshRateHz;
+    int m_reportIntervalSeconds;
+
+    bool m_gpuTimingSupported, m_gpuTimingInitialized;
+    std::deque<GLuint> m_freeQueries;
+    std::deque<FrameRecord> m_pendingFrames;
+
+    FrameRecord m_currentFrame;
+    Clock::time_point m_lastSwapTime, m_lastReportTime, m_startTime;
+    bool m_hasSwapped;
+    uint64_t m_framesSinceReport, m_missedSinceReport;
+
+    std::ofstream m_csvLog;
+
+    void initializeGpuTiming();
+    ///moves frames whose GPU queries have completed out of the pending queue, waiting on the oldest one if block is set
+    void collectPendingFrames(bool block);
+    void finishFrameRecord(const FrameRecord &record, uint64_t gpuNanos, bool hasGpuTime);
+    void printSummary();
+};
+}
+
+#endif // FRAMESTATISTICS_H
@@ -0,0 +1,146 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#include <profiling/histogram.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+using namespace motorcar;
+
+Histogram::Histogram(std::string name, std::string unit, unsigned int subBucketBits)
+    :m_name(name)
+    ,m_unit(unit)
+    ,m_subBucketBits(subBucketBits)
+    ,m_subBucketCount(1ull << subBucketBits)
+    ,m_counts(m_subBucketCount + (64 - subBucketBits) * (m_subBucketCount / 2), 0)
+    ,m_count(0)
+    ,m_max(0)
+    ,m_sum(0)
+{
+}
+
+void Histogram::record(uint64_t value)
+{
+    m_counts[bucketIndex(value)]++;
+    m_count++;
+    m_sum += value;
+    if(value > m_max){
+        m_max = value;
+    }
+}
+
+void Histogram::reset()
+{
+    std::fill(m_counts.begin(), m_counts.end(), 0);
+    m_count = 0;
+    m_max = 0;
+    m_sum = 0;
+}
+
+uint64_t Histogram::valueAtPercentile(double percentile) const
+{
+    if(m_count == 0){
+        return 0;
+    }
+
+    uint64_t target = (uint64_t) std::ceil((percentile / 100.0) * m_count);
+    if(target < 1){
+        target = 1;
+    }
+
+    uint64_t cumulative = 0;
+    for(size_t i = 0; i < m_counts.size(); i++){
+        cumulative += m_counts[i];
+        if(cumulative >= target){
+            return std::min(bucketUpperBound(i), m_max);
+        }
+    }
+    return m_max;
+}
+
+uint64_t Histogram::count() const
+{
+    return m_count;
+}
+
+uint64_t Histogram::max() const
+{
+    return m_max;
+}
+
+double Histogram::mean() const
+{
+    return m_count == 0 ? 0 : (double) m_sum / m_count;
+}
+
+void Histogram::print(std::ostream &stream, double unitScale) const
+{
+    stream << std::fixed << std::setprecision(2)
+           << m_name << ": n=" << m_count
+           << " mean=" << mean() * unitScale
+           << " p50=" << valueAtPercentile(50) * unitScale
+           << " p95=" << valueAtPercentile(95) * unitScale
+           << " p99=" << valueAtPercentile(99) * unitScale
+           << " max=" << m_max * unitScale
+           << " " << m_unit << std::endl;
+}
+
+std::string Histogram::name() const
+{
+    return m_name;
+}
+
+size_t Histogram::bucketIndex(uint64_t value) const
+{
+    if(value < m_subBucketCount){
+        return value;
+    }
+    unsigned int msb = 63 - __builtin_clzll(value);
+    unsigned int shift = msb - (m_subBucketBits - 1);
+    uint64_t halfCount = m_subBucketCount / 2;
+    return m_subBucketCount + (shift - 1) * halfCount + ((value >> shift) - halfCount);
+}
+
+uint64_t Histogram::bucketUpperBound(size_t index) const
+{
+    if(index < m_subBucketCount){
+        return index;
+    }
+    uint64_t halfCount = m_subBucketCount / 2;
+    unsigned int shift = (index - m_subBucketCount) / halfCount + 1;
+    uint64_t subBucket = (index - m_subBucketCount) % halfCount + halfCount;
+    return ((subBucket + 1) << shift) - 1;
+}
@@ -0,0 +1,83 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <vector>
+#include <string>
+#include <ostream>
+#include <stdint.h>
+
+namespace motorcar {
+///Log-linear histogram of integer samples with bounded relative error
+/*Samples below 2^subBucketBits are counted exactly, larger samples fall into buckets
+ * whose width doubles every power of two, so each bucket covers at most 1/2^(subBucketBits - 1)
+ * of its value. This keeps tail percentiles (p99, p99.9) accurate over several orders of
+ * magnitude without storing individual samples, in the spirit of HdrHistogram*/
+class Histogram
+{
+public:
+    Histogram(std::string name, std::string unit = "us", unsigned int subBucketBits = 5);
+
+    void record(uint64_t value);
+    void reset();
+
+    ///Returns the smallest value v such that at least the given percentage of samples are <= v
+    /*the value returned is the upper bound of the bucket containing the percentile, so it
+     * over-reports by at most the bucket resolution*/
+    uint64_t valueAtPercentile(double percentile) const;
+
+    uint64_t count() const;
+    uint64_t max() const;
+    double mean() const;
+
+    ///prints a single line summary of the form "name: n=... p50=... p95=... p99=... max=..."
+    void print(std::ostream &stream, double unitScale = 1.0) const;
+
+    std::string name() const;
+
+private:
+    std::string m_name, m_unit;
+    unsigned int m_subBucketBits;
+    uint64_t m_subBucketCount;
+    std::vector<uint64_t> m_counts;
+    uint64_t m_count, m_max, m_sum;
+
+    size_t bucketIndex(uint64_t value) const;
+    uint64_t bucketUpperBound(size_t index) const;
+};
+}
+
+#endif // HISTOGRAM_H
@@ -0,0 +1,202 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#include <qt/clientbuffertexturecache.h>
+#include <gl/openglextensions.h>
+
+#include <cstring>
+#include <iostream>
+
+using namespace qtmotorcar;
+
+//declared locally since the prototypes in eglext.h changed from wl_buffer to wl_resource over time
+typedef EGLImageKHR (*CreateImageFunction)(EGLDisplay display, EGLContext context, EGLenum target, EGLClientBuffer buffer, const EGLint *attributes);
+typedef EGLBoolean (*DestroyImageFunction)(EGLDisplay display, EGLImageKHR image);
+typedef EGLBoolean (*QueryWaylandBufferFunction)(EGLDisplay display, struct wl_resource *buffer, EGLint attribute, EGLint *value);
+typedef void (*ImageTargetTexture2DFunction)(GLenum target, void *image);
+
+static CreateImageFunction createImage = NULL;
+static DestroyImageFunction destroyImage = NULL;
+static QueryWaylandBufferFunction queryWaylandBuffer = NULL;
+static ImageTargetTexture2DFunction imageTargetTexture2D = NULL;
+
+static bool hasEGLExtension(EGLDisplay display, const char *name)
+{
+    const char *extensions = eglQueryString(display, EGL_EXTENSIONS);
+    if(extensions == NULL){
+        return false;
+    }
+    size_t length = std::strlen(name);
+    const char *start = extensions;
+    while((start = std::strstr(start, name)) != NULL){
+        const char *end = start + length;
+        if((start == extensions || start[-1] == ' ') && (*end == ' ' || *end == '\0')){
+            return true;
+        }
+        start = end;
+    }
+    return false;
+}
+
+ClientBufferTextureCache::ClientBufferTextureCache()
+    :m_display(eglGetCurrentDisplay())
+    ,m_releaseFrame(0)
+    ,m_oldestFrameInUse(0)
+{
+    createImage = (CreateImageFunction) eglGetProcAddress("eglCreateImageKHR");
+    destroyImage = (DestroyImageFunction) eglGetProcAddress("eglDestroyImageKHR");
+    queryWaylandBuffer = (QueryWaylandBufferFunction) eglGetProcAddress("eglQueryWaylandBufferWL");
+    imageTargetTexture2D = (ImageTargetTexture2DFunction) eglGetProcAddress("glEGLImageTargetTexture2DOES");
+}
+
+ClientBufferTextureCache::~ClientBufferTextureCache()
+{
+    while(!m_entries.empty()){
+        evict(m_entries.begin()->second);
+    }
+    for(Entry *entry : m_evicted){
+        destroy(entry);
+    }
+}
+
+bool ClientBufferTextureCache::isSupported()
+{
+    EGLDisplay display = eglGetCurrentDisplay();
+    return display != EGL_NO_DISPLAY &&
+            hasEGLExtension(display, "EGL_KHR_image_base") &&
+            hasEGLExtension(display, "EGL_WL_bind_wayland_display") &&
+            motorcar::OpenGLExtensions::hasExtension("GL_OES_EGL_image");
+}
+
+GLuint ClientBufferTextureCache::texture(wl_resource *buffer)
+{
+    if(buffer == NULL){
+        return 0;
+    }
+
+    std::map<struct wl_resource *, Entry *>::iterator it = m_entries.find(buffer);
+    Entry *entry = it != m_entries.end() ? it->second : import(buffer);
+    return entry != NULL ? entry->texture : 0;
+}
+
+size_t ClientBufferTextureCache::size() const
+{
+    return m_entries.size();
+}
+
+void ClientBufferTextureCache::setReleaseFrame(unsigned long frame)
+{
+    m_releaseFrame = frame;
+}
+
+void ClientBufferTextureCache::setOldestFrameInUse(unsigned long frame)
+{
+    m_oldestFrameInUse = frame;
+    for(size_t i = 0; i < m_evicted.size();){
+        if(m_evicted[i]->releaseFrame <= m_oldestFrameInUse){
+            destroy(m_evicted[i]);
+            m_evicted.erase(m_evicted.begin() + i);
+        }else{
+            i++;
+        }
+    }
+}
+
+ClientBufferTextureCache::Entry *ClientBufferTextureCache::import(wl_resource *buffer)
+{
+    if(createImage == NULL || destroyImage == NULL || queryWaylandBuffer == NULL || imageTargetTexture2D == NULL){
+        return NULL;
+    }
+
+    //planar YUV buffers need one image per plane, leave those to QtCompositor
+    EGLint format;
+    if(!queryWaylandBuffer(m_display, buffer, EGL_TEXTURE_FORMAT, &format) ||
+            (format != EGL_TEXTURE_RGB && format != EGL_TEXTURE_RGBA)){
+        return NULL;
+    }
+
+    EGLImageKHR image = createImage(m_display, EGL_NO_CONTEXT, EGL_WAYLAND_BUFFER_WL, (EGLClientBuffer) buffer, NULL);
+    if(image == EGL_NO_IMAGE_KHR){
+        std::cout << "Warning: could not import client buffer " << buffer << " as EGLImage" << std::endl;
+        return NULL;
+    }
+
+    Entry *entry = new Entry();
+    entry->cache = this;
+    entry->buffer = buffer;
+    entry->image = image;
+
+    glGenTextures(1, &entry->texture);
+    glBindTexture(GL_TEXTURE_2D, entry->texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    imageTargetTexture2D(GL_TEXTURE_2D, image);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    entry->destroyListener.notify = ClientBufferTextureCache::handleBufferDestroyed;
+    wl_resource_add_destroy_listener(buffer, &entry->destroyListener);
+
+    m_entries[buffer] = entry;
+    return entry;
+}
+
+void ClientBufferTextureCache::evict(Entry *entry)
+{
+    wl_list_remove(&entry->destroyListener.link);
+    m_entries.erase(entry->buffer);
+    //the image keeps the storage alive after the buffer is gone, so a frame in flight still samples the old contents
+    entry->buffer = NULL;
+    entry->releaseFrame = m_releaseFrame;
+    if(entry->releaseFrame <= m_oldestFrameInUse){
+        destroy(entry);
+    }else{
+        m_evicted.push_back(entry);
+    }
+}
+
+void ClientBufferTextureCache::destroy(Entry *entry)
+{
+    glDeleteTextures(1, &entry->texture);
+    destroyImage(m_display, entry->image);
+    delete entry;
+}
+
+void ClientBufferTextureCache::handleBufferDestroyed(wl_listener *listener, void *data)
+{
+    (void) data;
+    Entry *entry = wl_container_of(listener, entry, destroyListener);
+    entry->cache->evict(entry);
+}
@@ -0,0 +1,106 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#ifndef CLIENTBUFFERTEXTURECACHE_H
+#define CLIENTBUFFERTEXTURECACHE_H
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GL/gl.h>
+
+#include <wayland-server.h>
+
+#include <map>
+#include <vector>
+#include <cstddef>
+
+namespace qtmotorcar{
+///Textures for hardware accelerated client buffers, imported once per wl_buffer
+/*Clients rendering with EGL cycle through a small set of wl_buffers, so instead of importing the
+ * attached buffer on every commit each one is imported into an EGLImage and texture the first time it
+ * is seen and the texture is reused whenever it is attached again. Since the texture is a sibling of the
+ * client's buffer storage it always shows the buffer's current contents. Entries are evicted when the
+ * client destroys the buffer.
+ *
+ * Frames drawn on other threads may still sample the texture of an evicted entry, so like resources released
+ * to the GpuResourcePool, the texture and image are only deleted once every frame older than the one being
+ * prepared when the buffer was destroyed has been drawn (see setReleaseFrame() and setOldestFrameInUse()).
+ *
+ * Must only be used while the compositor's OpenGL context is current*/
+class ClientBufferTextureCache
+{
+public:
+    ClientBufferTextureCache();
+    ~ClientBufferTextureCache();
+
+    ///returns whether the current context can import wayland buffers as EGLImages
+    static bool isSupported();
+
+    ///returns the texture for the buffer, importing it if it is not cached yet
+    /*returns 0 if the buffer could not be imported, in which case the caller should fall back to the
+     * texture QtCompositor creates for the surface*/
+    GLuint texture(struct wl_resource *buffer);
+
+    ///number of buffers currently imported
+    size_t size() const;
+
+    ///tags entries evicted from now on as possibly sampled by any frame before the given one
+    void setReleaseFrame(unsigned long frame);
+    ///deletes evicted entries with a release frame up to the given one, as no older frame is drawn anymore
+    void setOldestFrameInUse(unsigned long frame);
+
+private:
+    struct Entry{
+        struct wl_listener destroyListener;
+        ClientBufferTextureCache *cache;
+        struct wl_resource *buffer;
+        EGLImageKHR image;
+        GLuint texture;
+        unsigned long releaseFrame;
+    };
+
+    EGLDisplay m_display;
+    std::map<struct wl_resource *, Entry *> m_entries;
+    //evicted entries whose texture frames in flight may still sample
+    std::vector<Entry *> m_evicted;
+    unsigned long m_releaseFrame, m_oldestFrameInUse;
+
+    Entry *import(struct wl_resource *buffer);
+    void evict(Entry *entry);
+    void destroy(Entry *entry);
+    static void handleBufferDestroyed(struct wl_listener *listener, void *data);
+};
+}
+
+#endif // CLIENTBUFFERTEXTURECACHE_H
@@ -34,21 +34,22 @@
 ****************************************************************************/
 #include <qt/opengldata.h>
 
+#include <iostream>
+
 
 OpenGLData::OpenGLData(QOpenGLWindow *window)
     : m_window(window)
+    , m_context(NULL)
+    , m_offscreenSurface(NULL)
     , m_textureBlitter(0)
+    , m_uploadBuffer(NULL)
+    , m_uploadPool(NULL)
+    , m_clientBufferCache(NULL)
     , m_ppcm(64)
 {
     m_window->makeCurrent();
 
-    m_textureCache = new QOpenGLTextureCache(m_window->context());
-    m_textureBlitter = new TextureBlitter();
-    //m_backgroundImage = makeBackgroundImage(QLatin1String(":/background.jpg"));
-
-    QOpenGLFunctions *functions = m_window->context()->functions();
-    functions->glGenFramebuffers(1, &m_surface_fbo);
-
+    //drawing state is per context, so it is set up on the context frames are drawn with
    // glClearDepth(1.0f);
     glDepthFunc(GL_LESS);
     glEnable(GL_DEPTH_TEST);
@@ -66,13 +67,56 @@ OpenGLData::OpenGLData(QOpenGLWindow *window)
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 
+    //offscreen surfaces have to be created on the gui thread
+    m_offscreenSurface = new QOffscreenSurface();
+    m_offscreenSurface->setFormat(m_window->context()->format());
+    m_offscreenSurface->create();
+
+    m_context = new QOpenGLContext();
+    m_context->setFormat(m_window->context()->format());
+    m_context->setShareContext(m_window->context());
+    m_context->create();
+    if(!m_offscreenSurface->isValid() || !m_context->isValid() || m_context->shareContext() == NULL){
+        std::cout << "Warning: could not create shared context for the main thread, frames will be drawn on the main thread" << std::endl;
+        delete m_context;
+        m_context = NULL;
+    }
+    makeCurrent();
+
+    m_textureCache = new QOpenGLTextureCache(context());
+    m_textureBlitter = new TextureBlitter();
+    //m_backgroundImage = makeBackgroundImage(QLatin1String(":/background.jpg"));
+
+    QOpenGLFunctions *functions = context()->functions();
+    functions->glGenFramebuffers(1, &m_surface_fbo);
+
+    if(motorcar::PixelUnpackBufferRing::isSupported()){
+        m_uploadBuffer = new motorcar::PixelUnpackBufferRing();
+
+        //handing textures between contexts relies on the same fence syncs as the upload buffer
+        m_uploadPool = new qtmotorcar::TextureUploadPool(context());
+        if(!m_uploadPool->isValid()){
+            delete m_uploadPool;
+            m_uploadPool = NULL;
+        }
+    }
+
+    if(qtmotorcar::ClientBufferTextureCache::isSupported()){
+        m_clientBufferCache = new qtmotorcar::ClientBufferTextureCache();
+    }
+
 
 }
 
 OpenGLData::~OpenGLData()
 {
+    delete m_clientBufferCache;
+    delete m_uploadPool;
+    delete m_uploadBuffer;
     delete m_textureBlitter;
     delete m_textureCache;
+    delete m_context;
+    delete m_offscreenSurface;
 }
 
 //QImage OpenGLData::makeBackgroundImage(const QString &fileName)
@@ -100,4 +144,17 @@ float OpenGLData::ppcm()
     return m_ppcm;
 }
 
+bool OpenGLData::makeCurrent()
+{
+    if(m_context == NULL){
+        return m_window->makeCurrent();
+    }
+    return m_context->makeCurrent(m_offscreenSurface);
+}
+
+QOpenGLContext *OpenGLData::context() const
+{
+    return m_context != NULL ? m_context : m_window->context();
+}
+
 
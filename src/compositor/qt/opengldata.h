@@ -47,21 +47,42 @@
 #include <QtGui/QOpenGLShaderProgram>
 #include <QtGui/QOpenGLContext>
 #include <QtGui/QOpenGLFunctions>
+#include <QtGui/QOffscreenSurface>
 
 #include <glm/glm.hpp>
 
+#include <gl/pixelunpackbufferring.h>
+#include <qt/textureuploadpool.h>
+#include <qt/clientbuffertexturecache.h>
+
 class SceneGraphNode;
 class OpenGLData
 {
 public:
     QOpenGLWindow *m_window;
+    ///context the main thread does its GL work with, sharing objects with the window's context
+    /*the window's context can then be handed to a render thread, NULL if no shared context could be created,
+     * in which case everything is done with the window's context on the main thread*/
+    QOpenGLContext *m_context;
+    QOffscreenSurface *m_offscreenSurface;
     TextureBlitter *m_textureBlitter;
     QOpenGLTextureCache *m_textureCache;
     GLuint m_surface_fbo;
+    ///staging buffers for shared memory surface uploads, NULL if the context does not support them
+    motorcar::PixelUnpackBufferRing *m_uploadBuffer;
+    ///workers uploading shared memory surfaces as soon as they are committed, NULL if uploads happen during the frame
+    qtmotorcar::TextureUploadPool *m_uploadPool;
+    ///textures for hardware accelerated client buffers, NULL if buffers cannot be imported directly
+    qtmotorcar::ClientBufferTextureCache *m_clientBufferCache;
     OpenGLData(QOpenGLWindow *window);
     ~OpenGLData();
 
     float ppcm();
+
+    ///makes the main thread's context current
+    bool makeCurrent();
+    ///the main thread's context
+    QOpenGLContext *context() const;
 private:
     float m_ppcm;
 
@@ -42,7 +42,7 @@
 #include <QTouchEvent>
 
 
-QOpenGLWindow::QOpenGLWindow(const QSurfaceFormat &format, const QRect &geometry)
+QOpenGLWindow::QOpenGLWindow(const QSurfaceFormat &format, const QRect &geometry, QOpenGLContext *shareContext)
     : m_format(format)
 {
     setSurfaceType(QWindow::OpenGLSurface);
@@ -51,6 +51,9 @@ QOpenGLWindow::QOpenGLWindow(const QSurfaceFormat &format, const QRect &geometry
     create();
     m_context = new QOpenGLContext;
     m_context->setFormat(format);
+    if(shareContext != NULL){
+        m_context->setShareContext(shareContext);
+    }
     m_context->create();
 
 }
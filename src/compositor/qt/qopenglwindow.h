@@ -48,7 +48,8 @@
 class QOpenGLWindow : public QWindow
 {
 public:
-    QOpenGLWindow(const QSurfaceFormat &format, const QRect &geometry);
+    ///creates the window and its context, which shares objects with shareContext if it is given
+    QOpenGLWindow(const QSurfaceFormat &format, const QRect &geometry, QOpenGLContext *shareContext = NULL);
 public:
     QOpenGLContext* context() { return m_context; }
     bool makeCurrent() { return m_context->makeCurrent(this); }
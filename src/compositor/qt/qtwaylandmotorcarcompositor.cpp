@@ -40,7 +40,8 @@
 #include <qt/qtwaylandmotorcarcompositor.h>
 #include <qt/qtwaylandmotorcarsurface.h>
 #include <qt/qtwaylandmotorcarseat.h>
-#include <sys/time.h>
+#include <scenegraph/input/posepredictor.h>
+#include <stdlib.h>
 
 
 #include <QtCompositor/private/qwlsurface_p.h>
@@ -55,6 +56,7 @@
 #include <QScreen>
 #include <QProcess>
 
+#include <algorithm>
 #include <iostream>
 #include <vector>
 
@@ -62,11 +64,16 @@
 
 using namespace qtmotorcar;
 
+//with render threads, frame callbacks stop waiting for presentations once no frame has been presented for this long
+static const uint64_t STALLED_PRESENTATION_NANOS = 100000000;
+
 QtWaylandMotorcarCompositor::QtWaylandMotorcarCompositor(QOpenGLWindow *window, QGuiApplication *app, motorcar::Scene * scene)
     : QWaylandCompositor(window, 0, DefaultExtensions | SubSurfaceExtension)
     , m_scene(scene)
     , m_glData(new OpenGLData(window))//glm::rotate(glm::translate(glm::mat4(1), glm::vec3(0,0,1.5f)), 180.f, glm::vec3(0,1,0)))))
     , m_renderScheduler(this)
+    , m_defaultContext(NULL)
+    , m_frameSnapshots(NULL)
     , m_draggingWindow(0)
     , m_dragKeyIsPressed(false)
     , m_cursorSurface(NULL)
@@ -77,7 +84,7 @@ QtWaylandMotorcarCompositor::QtWaylandMotorcarCompositor(QOpenGLWindow *window,
     , m_modifiers(Qt::NoModifier)
     , m_app(app)
     , m_defaultSeat(NULL)
-    , m_frames(0)
+    , m_frameStatistics(new motorcar::FrameStatistics(qGuiApp->primaryScreen()->refreshRate()))
 
 {
     setDisplay(NULL);
@@ -96,6 +103,21 @@ QtWaylandMotorcarCompositor::QtWaylandMotorcarCompositor(QOpenGLWindow *window,
 
     m_defaultSeat = new QtWaylandMotorcarSeat(this->defaultInputDevice());
 
+    //planar YUV buffers are uploaded as is and converted by the surface shader
+    wl_display_add_shm_format(waylandDisplay(), WL_SHM_FORMAT_NV12);
+    wl_display_add_shm_format(waylandDisplay(), WL_SHM_FORMAT_YUV420);
+
+    motorcar::FrameStatistics::installSignalHandler();
+    const char *statisticsLogPath = getenv("MOTORCAR_FRAME_STATISTICS_CSV");
+    if(statisticsLogPath != NULL){
+        m_frameStatistics->setCsvLogPath(statisticsLogPath);
+    }
+
+    const char *memoryBudget = getenv("MOTORCAR_GPU_MEMORY_BUDGET_MB");
+    if(memoryBudget != NULL){
+        m_scene->resourcePool()->setBudgetBytes((size_t) atol(memoryBudget) * 1024 * 1024);
+    }
+
 
 //    motorcar::Display testDisplay(window_context, glm::vec2(1), *m_scene, glm::mat4(1));
 //    for(int i = 0; i < 2 ; i++){
@@ -109,6 +131,12 @@ QtWaylandMotorcarCompositor::QtWaylandMotorcarCompositor(QOpenGLWindow *window,
 
 QtWaylandMotorcarCompositor::~QtWaylandMotorcarCompositor()
 {
+    for(QtWaylandMotorcarOpenGLContext *context : m_displayContexts){
+        delete context->window();
+        delete context;
+    }
+    delete m_defaultContext;
+    delete m_frameStatistics;
     delete m_glData;
 }
 
@@ -152,15 +180,99 @@ QtWaylandMotorcarCompositor *QtWaylandMotorcarCompositor::create(int argc, char*
 int QtWaylandMotorcarCompositor::start()
 {
     this->glData()->m_window->showFullScreen();
+    for(QtWaylandMotorcarOpenGLContext *context : m_displayContexts){
+        context->window()->showFullScreen();
+    }
+
+    //the windows' contexts can only be handed to render threads if the main thread has one of its own
+    std::vector<QtWaylandMotorcarOpenGLContext *> contexts = displayContexts();
+    if(m_glData->m_context != NULL && RenderThread::isSupported() && !contexts.empty()){
+        m_frameSnapshots = new motorcar::FrameSnapshotBuffer(contexts.size());
+        for(size_t i = 0; i < contexts.size(); i++){
+            //the first thread draws the default window, whose frames are the ones the statistics are about
+            m_renderThreads.push_back(new RenderThread(contexts[i], m_scene->resourcePool(), i == 0 ? m_frameStatistics : NULL,
+                                                       m_frameSnapshots, i));
+            connect(m_renderThreads.back(), SIGNAL(framePresented(quint32,quint64)), this, SLOT(framePresented(quint32,quint64)),
+                    Qt::QueuedConnection);
+        }
+        //a frame is drawn while the next one is being prepared, so it is presented an interval later
+        m_scene->setPresentationLatencyFrames(2);
+    }else{
+        std::cout << "Warning: threaded OpenGL is not available, frames will be drawn on the main thread" << std::endl;
+        m_scene->setPresentationLatencyFrames(1);
+    }
+    QScreen *screen = m_glData->m_window->screen();
+    if(screen != NULL && screen->refreshRate() > 0){
+        m_scene->setRefreshNanos((uint32_t) (1000000000.0 / screen->refreshRate()));
+    }
+    m_glData->makeCurrent();
+
     this->cleanupGraphicsResources();
     int result = m_app->exec();
+
+    for(RenderThread *renderThread : m_renderThreads){
+        delete renderThread;
+    }
+    m_renderThreads.clear();
+    for(std::map<QtWaylandMotorcarOpenGLContext *, motorcar::FrameRenderer *>::value_type &renderer : m_frameRenderers){
+        renderer.first->makeCurrent();
+        delete renderer.second;
+    }
+    m_frameRenderers.clear();
+    m_glData->makeCurrent();
+    //the items of the snapshots still hold GL resources, which are released with the main context current
+    delete m_frameSnapshots;
+    m_frameSnapshots = NULL;
+    m_frameSnapshot.clear();
+
+    m_frameStatistics->dump();
     delete m_app;
     return result;
 }
 
 motorcar::OpenGLContext *QtWaylandMotorcarCompositor::getContext()
 {
-    return new QtWaylandMotorcarOpenGLContext(this->glData()->m_window);
+    if(m_defaultContext == NULL){
+        m_defaultContext = new QtWaylandMotorcarOpenGLContext(this->glData()->m_window);
+    }
+    return m_defaultContext;
+}
+
+motorcar::OpenGLContext *QtWaylandMotorcarCompositor::createContext(int screen)
+{
+    QList<QScreen *> screens = QGuiApplication::screens();
+    if(screen < 0 || screen >= screens.size()){
+        std::cout << "Warning: cannot create a display context on screen " << screen << ", there are " << screens.size() << " screens" << std::endl;
+        return NULL;
+    }
+
+    QOpenGLWindow *window = new QOpenGLWindow(m_glData->m_window->format(), screens[screen]->geometry(), m_glData->m_window->context());
+    if(window->context()->shareContext() != m_glData->m_window->context()){
+        std::cout << "Warning: the context for screen " << screen << " cannot share objects with the compositor's context" << std::endl;
+        delete window;
+        return NULL;
+    }
+
+    QtWaylandMotorcarOpenGLContext *context = new QtWaylandMotorcarOpenGLContext(window);
+    m_displayContexts.push_back(context);
+    return context;
+}
+
+std::vector<QtWaylandMotorcarOpenGLContext *> QtWaylandMotorcarCompositor::displayContexts() const
+{
+    std::vector<QtWaylandMotorcarOpenGLContext *> contexts;
+    for(motorcar::Display *display : m_scene->displays()){
+        //every display context was created by this compositor
+        QtWaylandMotorcarOpenGLContext *context = static_cast<QtWaylandMotorcarOpenGLContext *>(display->glContext());
+        if(std::find(contexts.begin(), contexts.end(), context) == contexts.end()){
+            if(context == m_defaultContext){
+                contexts.insert(contexts.begin(), context);
+            }else{
+                contexts.push_back(context);
+            }
+        }
+    }
+    return contexts;
 }
 
 wl_display *QtWaylandMotorcarCompositor::wlDisplay()
@@ -230,6 +342,23 @@ QtWaylandMotorcarSurface *QtWaylandMotorcarCompositor::getMotorcarSurface(QWayla
 
 
 
+std::vector<QtWaylandMotorcarSurface *> QtWaylandMotorcarCompositor::motorcarSurfacesFor(QWaylandSurface *surface) const
+{
+    std::vector<QtWaylandMotorcarSurface *> motorsurfaces;
+    QtWaylandMotorcarSurface *motorsurface = this->getMotorcarSurface(surface);
+    if(motorsurface != NULL){
+        motorsurfaces.push_back(motorsurface);
+    }
+    motorcar::WaylandSurfaceNode *cursorNode = m_defaultSeat->pointer()->cursorNode();
+    if(cursorNode != NULL){
+        QtWaylandMotorcarSurface *cursorSurface = static_cast<QtWaylandMotorcarSurface *>(cursorNode->surface());
+        if(cursorSurface != motorsurface && cursorSurface->surface() == surface){
+            motorsurfaces.push_back(cursorSurface);
+        }
+    }
+    return motorsurfaces;
+}
+
 //TODO: consider revising to take  MotorcarSurfaceNode as argument depending on call sites
 void QtWaylandMotorcarCompositor::ensureKeyboardFocusSurface(QWaylandSurface *oldSurface)
 {
@@ -260,6 +389,10 @@ void QtWaylandMotorcarCompositor::surfaceDestroyed(QObject *object)
             this->scene()->windowManager()->destroySurface(motorsurface);
             m_surfaceMap.erase (surface);
 
+            //the motorcar surface outlives its QWaylandSurface, but its textures must not
+            static_cast<QtWaylandMotorcarSurface *>(motorsurface)->setSurface(NULL);
+            this->scene()->resourcePool()->unregisterOwner(motorsurface);
+
             for (unsigned i=0; i<topLevelSurfaces.size(); ++i) {
               if (topLevelSurfaces[i] == surface) {
                 topLevelSurfaces.erase(topLevelSurfaces.begin() + i);
@@ -291,7 +424,9 @@ void QtWaylandMotorcarCompositor::surfaceMapped()
             float popupZOffset = 0.05f;
 
 
-            if(type == QWaylandSurface::WindowType::Toplevel){
+            if(surface->parentSurface() != NULL && surface->parentSurface()->subSurfaces().contains(surface)){
+                surfaceType = motorcar::WaylandSurface::SurfaceType::SUBSURFACE;
+            }else if(type == QWaylandSurface::WindowType::Toplevel){
                 surfaceType = motorcar::WaylandSurface::SurfaceType::TOPLEVEL;
             }else if(type == QWaylandSurface::WindowType::Popup){
                 surfaceType = motorcar::WaylandSurface::SurfaceType::POPUP;
@@ -363,18 +498,25 @@ void QtWaylandMotorcarCompositor::surfaceDamaged()
     QWaylandSurface *surface = qobject_cast<QWaylandSurface *>(sender());
 
     if(surface != NULL){
-        motorcar::WaylandSurface *motorsurface = this->getMotorcarSurface(surface);
-        if(motorsurface != NULL){
-            //surfaceNode->setDamaged(true);
-        }else{
-          //  std::cout << "Warning: surface damaged but doesnt have associated surfaceNode" <<std::endl;
+        for(QtWaylandMotorcarSurface *motorsurface : this->motorcarSurfacesFor(surface)){
+            motorsurface->notifyCommitted();
         }
-
     }
 
     surfaceDamaged(surface);
 }
 
+void QtWaylandMotorcarCompositor::surfaceDamaged(const QRegion &damage)
+{
+    QWaylandSurface *surface = qobject_cast<QWaylandSurface *>(sender());
+
+    if(surface != NULL){
+        for(QtWaylandMotorcarSurface *motorsurface : this->motorcarSurfacesFor(surface)){
+            motorsurface->addDamage(damage);
+        }
+    }
+}
+
 void QtWaylandMotorcarCompositor::surfacePosChanged()
 {
     //m_renderScheduler.start(0);
@@ -393,6 +535,7 @@ void QtWaylandMotorcarCompositor::surfaceCreated(QWaylandSurface *surface)
     connect(surface, SIGNAL(mapped()), this, SLOT(surfaceMapped()));
     connect(surface, SIGNAL(unmapped()), this, SLOT(surfaceUnmapped()));
     connect(surface, SIGNAL(committed()), this, SLOT(surfaceDamaged()));
+    connect(surface, SIGNAL(damaged(const QRegion &)), this, SLOT(surfaceDamaged(const QRegion &)));
     connect(surface, SIGNAL(extendedSurfaceReady()), this, SLOT(sendExpose()));
     connect(surface, SIGNAL(posChanged()), this, SLOT(surfacePosChanged()));
 
@@ -457,6 +600,11 @@ void QtWaylandMotorcarCompositor::setDefaultSeat(QtWaylandMotorcarSeat *defaultS
     m_defaultSeat = defaultSeat;
 }
 
+motorcar::FrameStatistics *QtWaylandMotorcarCompositor::frameStatistics() const
+{
+    return m_frameStatistics;
+}
+
 
 void QtWaylandMotorcarCompositor::updateCursor()
 {
@@ -529,38 +677,47 @@ QWaylandSurface *QtWaylandMotorcarCompositor::surfaceAt(const QPointF &point, QP
 
 void QtWaylandMotorcarCompositor::render()
 {
-    m_glData->m_window->makeCurrent();
+    m_glData->makeCurrent();
     frameStarted();
     cleanupGraphicsResources();
 
+    //textures may be overwritten while preparing the frame, which frames drawn so far must have finished reading
+    waitForDrawnFrames();
+    if(m_frameSnapshots != NULL){
+        //pooled resources released by earlier frames are recycled once no frame which may sample them is drawn anymore
+        unsigned long oldestFrameInUse = m_frameSnapshots->oldestGenerationInUse();
+        m_scene->resourcePool()->setOldestFrameInUse(oldestFrameInUse);
+        if(m_glData->m_clientBufferCache != NULL){
+            m_glData->m_clientBufferCache->setOldestFrameInUse(oldestFrameInUse);
+        }
+    }
+    scene()->prepareForFrame(this->handle()->currentTimeMsecs());
 
-    scene()->drawFrame();
+    //culling, picking and texture preparation happen once here, however many displays draw the snapshot
+    motorcar::FrameSnapshot *frame = m_frameSnapshots != NULL ? m_frameSnapshots->writeSnapshot() : &m_frameSnapshot;
+    scene()->snapshotFrame(frame);
     scene()->finishFrame();
 
-    scene()->prepareForFrame(this->handle()->currentTimeMsecs());
-    sendFrameCallbacks(surfaces());
+    if(m_frameSnapshots != NULL){
+        m_frameSnapshots->publish();
+        //from now on resources are released while the published snapshot, which may sample them, is in flight
+        unsigned long releaseFrame = m_frameSnapshots->writeGeneration();
+        m_scene->resourcePool()->setReleaseFrame(releaseFrame);
+        if(m_glData->m_clientBufferCache != NULL){
+            m_glData->m_clientBufferCache->setReleaseFrame(releaseFrame);
+        }
+        //frame callbacks are done once a render thread presents a frame, unless none has for a while (every window hidden)
+        if(motorcar::PosePredictor::monotonicNanos() - scene()->lastPresentationNanos() > STALLED_PRESENTATION_NANOS){
+            sendFrameCallbacks(surfaces());
+        }
+    }else{
+        drawFrame(frame);
+        framePresented(frame->sequence, motorcar::PosePredictor::monotonicNanos());
+    }
 
 
     //frameFinished();
 
-    m_glData->m_window->swapBuffers();
-
-    struct timeval tv;
-    static const int32_t benchmark_interval = 5;
-    gettimeofday(&tv, NULL);
-        uint32_t time = this->handle()->currentTimeMsecs();//tv.tv_sec * 1000 + tv.tv_usec / 1000;
-        if (m_frames == 0)
-          m_benchmark_time = time;
-        if (time - m_benchmark_time > (benchmark_interval * 1000)) {
-          std::cout << m_frames << " frames in " << benchmark_interval
-                    << " seconds: " << (float)m_frames / benchmark_interval
-                    << std::endl;
-          m_benchmark_time = time;
-          m_frames = 0;
-        }
-
-        m_frames++;
-
 
 //    glFlush();
 //    glFinish();
@@ -573,6 +730,44 @@ void QtWaylandMotorcarCompositor::render()
 
 }
 
+void QtWaylandMotorcarCompositor::framePresented(quint32 frame, quint64 presentedNanos)
+{
+    if(m_scene->framePresented(frame, presentedNanos)){
+        //clients draw their next frame once the previous one is on the screen, rather than as soon as it was snapshotted
+        sendFrameCallbacks(surfaces());
+    }
+}
+
+void QtWaylandMotorcarCompositor::drawFrame(const motorcar::FrameSnapshot *frame)
+{
+    std::vector<QtWaylandMotorcarOpenGLContext *> contexts = displayContexts();
+
+    m_frameStatistics->beginFrame();
+    for(QtWaylandMotorcarOpenGLContext *context : contexts){
+        context->makeCurrent();
+        motorcar::FrameRenderer *&renderer = m_frameRenderers[context];
+        if(renderer == NULL){
+            renderer = new motorcar::FrameRenderer(m_scene->resourcePool(), context);
+        }
+        renderer->drawFrame(frame);
+    }
+    m_frameStatistics->endCpuWork();
+    for(QtWaylandMotorcarOpenGLContext *context : contexts){
+        context->makeCurrent();
+        context->window()->swapBuffers();
+    }
+    m_frameStatistics->endFrame();
+
+    m_glData->makeCurrent();
+}
+
+void QtWaylandMotorcarCompositor::waitForDrawnFrames()
+{
+    if(m_frameSnapshots != NULL){
+        m_frameSnapshots->waitForDrawnFrames();
+    }
+}
+
 bool QtWaylandMotorcarCompositor::eventFilter(QObject *obj, QEvent *event)
 {
     if (obj != m_glData->m_window)
@@ -43,10 +43,13 @@
 #include <qwaylandcompositor.h>
 
 #include <motorcar.h>
+#include <profiling/framestatistics.h>
 
 
 #include <qt/qtwaylandmotorcaropenglcontext.h>
 #include <qt/opengldata.h>
+#include <qt/renderthread.h>
+#include <scenegraph/output/framerenderer.h>
 
 #include <QGuiApplication>
 #include <QDesktopWidget>
@@ -71,6 +74,7 @@ public:
     virtual int start() override;
 
     virtual motorcar::OpenGLContext *getContext() override;
+    virtual motorcar::OpenGLContext *createContext(int screen) override;
 
     struct wl_display *wlDisplay() override;
 
@@ -89,14 +93,27 @@ public:
     motorcar::Seat *defaultSeat() const override;
     void setDefaultSeat(QtWaylandMotorcarSeat *defaultSeat);
 
+    motorcar::FrameStatistics *frameStatistics() const;
+
+    ///makes the current context wait for every frame drawn so far before executing further commands
+    /*must be called on the main thread before overwriting a texture which frames that may still be
+     * being drawn sample, does nothing if frames are drawn on the main thread*/
+    void waitForDrawnFrames();
+
+    ///returns the contexts of the scene's displays, the default context first if any display uses it
+    std::vector<QtWaylandMotorcarOpenGLContext *> displayContexts() const;
+
 private slots:
     void surfaceDestroyed(QObject *object);
     void surfaceMapped();
     void surfaceUnmapped();
     void surfaceDamaged();
+    void surfaceDamaged(const QRegion &damage);
     void surfacePosChanged();
 
     void render();
+    ///reports the presentation of the frame to the scene and does the frame callbacks, if no display presented it before
+    void framePresented(quint32 frame, quint64 presentedNanos);
 protected:
     void surfaceDamaged(QWaylandSurface *surface);
     void surfaceCreated(QWaylandSurface *surface);
@@ -113,6 +130,9 @@ protected:
     void setCursorSurface(QWaylandSurface *surface, int hotspotX, int hotspotY);
 
     void ensureKeyboardFocusSurface(QWaylandSurface *oldSurface);
+
+    ///returns every motorcar surface wrapping the given surface (the cursor surface may wrap a surface that also has its own entry)
+    std::vector<QtWaylandMotorcarSurface *> motorcarSurfacesFor(QWaylandSurface *surface) const;
 //    QImage makeBackgroundImage(const QString &fileName);
 
 private slots:
@@ -128,6 +148,19 @@ private:
     OpenGLData *m_glData;
     QTimer m_renderScheduler;
 
+    QtWaylandMotorcarOpenGLContext *m_defaultContext;
+    //contexts created for additional displays, and their windows
+    std::vector<QtWaylandMotorcarOpenGLContext *> m_displayContexts;
+
+    //frames are drawn by one render thread per display context if the platform allows it, otherwise on the main thread
+    motorcar::FrameSnapshotBuffer *m_frameSnapshots;
+    std::vector<RenderThread *> m_renderThreads;
+    std::map<QtWaylandMotorcarOpenGLContext *, motorcar::FrameRenderer *> m_frameRenderers;
+    motorcar::FrameSnapshot m_frameSnapshot;
+
+    ///draws the snapshot for every display context in turn and swaps their windows, when there are no render threads
+    void drawFrame(const motorcar::FrameSnapshot *frame);
+
 
     //Dragging windows around
     QWaylandSurface *m_draggingWindow;
@@ -146,7 +179,7 @@ private:
 
     std::map<QWaylandSurface *, QtWaylandMotorcarSurface *> m_surfaceMap;
 
-    uint32_t m_frames, m_benchmark_time;
+    motorcar::FrameStatistics *m_frameStatistics;
 
     QPointF m_lastPos;
 
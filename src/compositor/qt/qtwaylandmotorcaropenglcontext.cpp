@@ -15,3 +15,8 @@ void qtmotorcar::QtWaylandMotorcarOpenGLContext::makeCurrent()
 {
     m_window->makeCurrent();
 }
+
+QOpenGLWindow *qtmotorcar::QtWaylandMotorcarOpenGLContext::window() const
+{
+    return m_window;
+}
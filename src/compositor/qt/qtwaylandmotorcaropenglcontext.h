@@ -46,6 +46,8 @@ public:
     glm::ivec2 defaultFramebufferSize() override;
     void makeCurrent() override;
 
+    QOpenGLWindow *window() const;
+
 private:
     QOpenGLWindow *m_window;
 };
@@ -33,15 +33,40 @@
 **
 ****************************************************************************/
 #include <qt/qtwaylandmotorcarsurface.h>
+
+#include <QtCompositor/private/qwlsurface_p.h>
+#include <QtCompositor/private/qwlsurfacebuffer_p.h>
+
+#include <sstream>
+
 using namespace qtmotorcar;
 
 QtWaylandMotorcarSurface::QtWaylandMotorcarSurface(QWaylandSurface *surface, QtWaylandMotorcarCompositor *compositor, SurfaceType type)
     :motorcar::WaylandSurface(type)
     , m_surface(surface)
+    , m_textureID(0)
+    , m_frontTexture(0)
+    , m_uploadInFlight(false)
+    , m_uploadCommitSerial(0)
+    , m_committed(true)
     , m_compositor(compositor)
-    , m_ownsTexture(false)
 {
+    m_bufferDestroyListener.listener.notify = QtWaylandMotorcarSurface::handleBufferDestroyed;
+    m_bufferDestroyListener.surface = this;
+
+    //named after the QWaylandSurface so the usage report can be matched up with the surface creation log
+    motorcar::GpuResourcePool *pool = compositor->scene()->resourcePool();
+    std::ostringstream name;
+    name << "surface " << surface;
+    pool->registerOwner(this, name.str());
+    m_shmTextures[0].setResourcePool(pool, this);
+    m_shmTextures[1].setResourcePool(pool, this);
+}
 
+QtWaylandMotorcarSurface::~QtWaylandMotorcarSurface()
+{
+    //the pool must not write into the textures once they are gone
+    finishUpload(true);
 }
 
 GLuint QtWaylandMotorcarSurface::texture()
@@ -50,6 +75,22 @@ GLuint QtWaylandMotorcarSurface::texture()
     return m_textureID;
 }
 
+motorcar::WaylandSurface::TextureFormat QtWaylandMotorcarSurface::textureFormat()
+{
+    if(m_surface != NULL && m_surface->type() == QWaylandSurface::Shm){
+        return m_shmTextures[m_frontTexture].format();
+    }
+    return TextureFormat::RGBA;
+}
+
+GLuint QtWaylandMotorcarSurface::planeTexture(int plane)
+{
+    if(m_surface != NULL && m_surface->type() == QWaylandSurface::Shm){
+        return m_shmTextures[m_frontTexture].texture(plane);
+    }
+    return motorcar::WaylandSurface::planeTexture(plane);
+}
+
 glm::ivec2 QtWaylandMotorcarSurface::size()
 {
     return glm::ivec2(m_surface->size().width(), m_surface->size().height());
@@ -63,9 +104,29 @@ void QtWaylandMotorcarSurface::setSize(glm::ivec2 newSize)
 
 glm::ivec2 QtWaylandMotorcarSurface::position()
 {
+    if(m_type == SurfaceType::SUBSURFACE && m_surface->parentSurface() != NULL){
+        QPointF pos = m_surface->mapTo(m_surface->parentSurface(), QPointF(0, 0));
+        return glm::ivec2(pos.x(), pos.y());
+    }
     return glm::ivec2(m_surface->pos().x(), m_surface->pos().y());
 }
 
+int QtWaylandMotorcarSurface::stackingIndex()
+{
+    if(m_type != SurfaceType::SUBSURFACE || m_surface->parentSurface() == NULL){
+        return 0;
+    }
+    //the parent keeps its subsurfaces bottom to top, reordered by place_above and place_below
+    int index = 0;
+    for(QWaylandSurface *sibling : m_surface->parentSurface()->subSurfaces()){
+        if(sibling == m_surface){
+            return index;
+        }
+        index++;
+    }
+    return 0;
+}
+
 motorcar::WaylandSurface *QtWaylandMotorcarSurface::parentSurface()
 {
     if(m_surface->parentSurface() != NULL){
@@ -78,10 +139,30 @@ motorcar::WaylandSurface *QtWaylandMotorcarSurface::parentSurface()
 
 void QtWaylandMotorcarSurface::prepare()
 {
-    if (m_ownsTexture){
-        glDeleteTextures(1, &m_textureID);
+    if(uploadsAsynchronously()){
+        //uploads are started on commit, so all that is left is picking up the ones that have finished,
+        //only waiting if there is nothing to draw yet
+        finishUpload(m_shmTextures[m_frontTexture].texture() == 0);
+        if(m_committed){
+            //committed while the previous upload was still in flight
+            startUpload();
+        }
+        m_textureID = m_shmTextures[m_frontTexture].texture();
+        return;
+    }
+    finishUpload(true);
+
+    if(!m_committed && m_textureID != 0){
+        return;
     }
-    m_textureID = composeSurface(m_surface, &m_ownsTexture, m_compositor->glData());
+
+    QRegion damage = m_pendingDamage;
+    m_committed = false;
+    m_pendingDamage = QRegion();
+
+    m_textureID = composeSurface(m_surface, damage, m_compositor->glData());
+    //composed from the buffer of the newest commit
+    contentChanged(commitSerial());
 }
 
 void QtWaylandMotorcarSurface::sendEvent(const motorcar::Event &event)
@@ -212,76 +293,125 @@ bool QtWaylandMotorcarSurface::valid()
 
 
 
-static GLuint textureFromImage(const QImage &image)
+struct wl_resource *QtWaylandMotorcarSurface::currentBufferResource() const
 {
-    GLuint texture = 0;
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
-    QImage tx = image.convertToFormat(QImage::Format_RGBA8888_Premultiplied);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, tx.width(), tx.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, tx.constBits());
-    glBindTexture(GL_TEXTURE_2D, 0);
-    return texture;
+    QtWayland::SurfaceBuffer *buffer = m_surface->handle()->currentSurfaceBuffer();
+    return buffer != NULL ? buffer->waylandBufferHandle() : NULL;
 }
 
-GLuint QtWaylandMotorcarSurface::composeSurface(QWaylandSurface *surface, bool *textureOwned, OpenGLData *glData)
+bool QtWaylandMotorcarSurface::uploadsAsynchronously() const
 {
-    GLuint texture = 0;
+    return m_compositor->glData()->m_uploadPool != NULL && m_surface != NULL &&
+            m_surface->type() == QWaylandSurface::Shm;
+}
 
-    QSize windowSize = surface->size();
-    surface->swapBuffers();
+void QtWaylandMotorcarSurface::startUpload()
+{
+    if(m_uploadInFlight){
+        //picked up by prepare() once the current upload has finished
+        return;
+    }
 
-    QOpenGLFunctions *functions = QOpenGLContext::currentContext()->functions();
-    functions->glBindFramebuffer(GL_FRAMEBUFFER, glData->m_surface_fbo);
+    m_surface->swapBuffers();
+    m_committed = false;
 
-    if (surface->type() == QWaylandSurface::Shm) {
-        texture = textureFromImage(surface->image());
-        *textureOwned = true;
-    } else if (surface->type() == QWaylandSurface::Texture) {
-        texture = surface->texture();
-        *textureOwned = false;
+    struct wl_resource *resource = currentBufferResource();
+    struct wl_shm_buffer *buffer = resource != NULL ? wl_shm_buffer_get(resource) : NULL;
+    if(buffer == NULL){
+        m_pendingDamage = QRegion();
+        return;
     }
 
-    functions->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
-                                       GL_TEXTURE_2D, texture, 0);
-    paintChildren(surface, surface,windowSize, glData);
-    functions->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
-                                       GL_TEXTURE_2D,0, 0);
+    QRect bounds(0, 0, wl_shm_buffer_get_width(buffer), wl_shm_buffer_get_height(buffer));
+    QRegion damage = m_pendingDamage.isEmpty() ? QRegion(bounds) : m_pendingDamage;
+    m_pendingDamage = QRegion();
+
+    //the back texture also has to catch up on what was uploaded to the front texture since it was last filled,
+    //after the swap the old front texture will in turn be missing this upload's damage
+    m_uploadJob.texture = &m_shmTextures[1 - m_frontTexture];
+    m_uploadJob.buffer = buffer;
+    //swapBuffers() picked the buffer of the newest commit, which later commits may follow before the upload finishes
+    m_uploadCommitSerial = commitSerial();
+    //resizes of the pool are deferred until the reference is dropped, so the worker's mapping stays valid
+    m_uploadJob.pool = wl_shm_buffer_ref_pool(buffer);
+    m_uploadJob.damage = damage + m_backDamage;
+    m_backDamage = damage;
+
+    OpenGLData *glData = m_compositor->glData();
+    glData->makeCurrent();
+    //the read fence has to cover frames the render thread has drawn with the texture as well
+    m_compositor->waitForDrawnFrames();
+    m_uploadJob.readFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+
+    //the client may destroy the buffer at any time, which has to wait for the worker to stop reading it
+    wl_resource_add_destroy_listener(resource, &m_bufferDestroyListener.listener);
+
+    m_uploadInFlight = true;
+    glData->m_uploadPool->submit(&m_uploadJob);
+}
 
-    functions->glBindFramebuffer(GL_FRAMEBUFFER, 0);
+void QtWaylandMotorcarSurface::finishUpload(bool wait)
+{
+    if(!m_uploadInFlight){
+        return;
+    }
 
+    TextureUploadPool *pool = m_compositor->glData()->m_uploadPool;
+    if(wait){
+        pool->wait(&m_uploadJob);
+    }else if(!pool->isFinished(&m_uploadJob)){
+        return;
+    }
+    m_uploadInFlight = false;
+    wl_list_remove(&m_bufferDestroyListener.listener.link);
+    wl_shm_pool_unref(m_uploadJob.pool);
+    m_uploadJob.pool = NULL;
+
+    m_compositor->glData()->makeCurrent();
+    glWaitSync(m_uploadJob.uploadFence, 0, GL_TIMEOUT_IGNORED);
+    glDeleteSync(m_uploadJob.uploadFence);
+    glDeleteSync(m_uploadJob.readFence);
+
+    m_frontTexture = 1 - m_frontTexture;
+    contentChanged(m_uploadCommitSerial);
+}
 
-    return texture;
+void QtWaylandMotorcarSurface::handleBufferDestroyed(wl_listener *listener, void *data)
+{
+    Q_UNUSED(data)
+    BufferDestroyListener *bufferListener = reinterpret_cast<BufferDestroyListener *>(listener);
+    bufferListener->surface->finishUpload(true);
 }
 
-void QtWaylandMotorcarSurface::paintChildren(QWaylandSurface *surface, QWaylandSurface *window, const QSize &windowSize, OpenGLData *glData) {
+GLuint QtWaylandMotorcarSurface::composeSurface(QWaylandSurface *surface, const QRegion &damage, OpenGLData *glData)
+{
+    GLuint texture = 0;
 
-    if (surface->subSurfaces().size() == 0)
-        return;
+    surface->swapBuffers();
 
-    QLinkedListIterator<QWaylandSurface *> i(surface->subSurfaces());
-    while (i.hasNext()) {
-        QWaylandSurface *subSurface = i.next();
-        QPointF p = subSurface->mapTo(window,QPointF(0,0));
-        QSize subSize = subSurface->size();
-        //subSurface->advanceBufferQueue();
-        subSurface->swapBuffers();
-        if (subSize.isValid()) {
-            GLuint texture = 0;
-            if (subSurface->type() == QWaylandSurface::Texture) {
-                texture = subSurface->texture();
-            } else if (surface->type() == QWaylandSurface::Shm) {
-                texture = textureFromImage(subSurface->image());
-            }
-            QRect geo(p.toPoint(),subSize);
-            if (texture > 0)
-                glData->m_textureBlitter->drawTexture(texture,geo,windowSize,0,window->isYInverted(),subSurface->isYInverted());
-            if (surface->type() == QWaylandSurface::Shm)
-                glDeleteTextures(1, &texture);
+    ShmSurfaceTexture &shmTexture = m_shmTextures[m_frontTexture];
+    if (surface->type() == QWaylandSurface::Shm) {
+        struct wl_resource *buffer = currentBufferResource();
+        if(buffer != NULL){
+            shmTexture.update(wl_shm_buffer_get(buffer), damage, glData->m_uploadBuffer);
+            m_backDamage += damage.isEmpty() ? QRegion(QRect(QPoint(0, 0), shmTexture.size())) : damage;
+        }
+        texture = shmTexture.texture();
+    } else if (surface->type() == QWaylandSurface::Texture) {
+        m_shmTextures[0].release();
+        m_shmTextures[1].release();
+        m_backDamage = QRegion();
+        if(glData->m_clientBufferCache != NULL){
+            texture = glData->m_clientBufferCache->texture(currentBufferResource());
+        }
+        if(texture == 0){
+            texture = surface->texture();
         }
-        paintChildren(subSurface,window,windowSize, glData);
     }
-}
 
+    return texture;
+}
 
 
 
@@ -292,5 +422,27 @@ QWaylandSurface *QtWaylandMotorcarSurface::surface() const
 
 void QtWaylandMotorcarSurface::setSurface(QWaylandSurface *surface)
 {
+    if(surface != m_surface){
+        finishUpload(true);
+        m_committed = true;
+        m_pendingDamage = QRegion();
+        m_backDamage = QRegion();
+        m_shmTextures[0].release();
+        m_shmTextures[1].release();
+    }
     m_surface = surface;
 }
+
+void QtWaylandMotorcarSurface::notifyCommitted()
+{
+    committed();
+    m_committed = true;
+    if(uploadsAsynchronously()){
+        startUpload();
+    }
+}
+
+void QtWaylandMotorcarSurface::addDamage(const QRegion &damage)
+{
+    m_pendingDamage += damage;
+}
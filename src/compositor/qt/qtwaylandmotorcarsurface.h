@@ -38,6 +38,7 @@
 #include <motorcar.h>
 #include <qt/opengldata.h>
 #include <qt/qtwaylandmotorcarcompositor.h>
+#include <qt/shmsurfacetexture.h>
 
 #include <qwaylandinput.h>
 #include <qwaylandsurface.h>
@@ -50,10 +51,12 @@ namespace qtmotorcar{
     {
     public:
         QtWaylandMotorcarSurface(QWaylandSurface *surface, QtWaylandMotorcarCompositor *compositor, motorcar::WaylandSurface::SurfaceType type);
-        ~QtWaylandMotorcarSurface(){}
+        ~QtWaylandMotorcarSurface();
 
         //inherited from WaylandSurface
         GLuint texture() override;
+        TextureFormat textureFormat() override;
+        GLuint planeTexture(int plane) override;
         ///Get the size of this surface in surface local coordinates
         glm::ivec2 size() override;
         ///Set the size of this surface in surface local coordinates
@@ -62,6 +65,7 @@ namespace qtmotorcar{
         glm::ivec2 position() override;
         ///return the parent surface
         WaylandSurface *parentSurface() override;
+        int stackingIndex() override;
 
         void prepare() override;      
         void sendEvent(const motorcar::Event &event) override;
@@ -71,15 +75,46 @@ namespace qtmotorcar{
         QWaylandSurface *surface() const;
         void setSurface(QWaylandSurface *surface);
 
+        ///record that the client committed a new buffer, called by the compositor
+        void notifyCommitted();
+        ///accumulate damage posted by the client since the last frame, called by the compositor
+        void addDamage(const QRegion &damage);
+
     private:
         QWaylandSurface *m_surface;
-        bool m_ownsTexture;
         GLuint m_textureID;
 
+        //shared memory contents are double buffered so the upload pool can fill one while the other is drawn
+        ShmSurfaceTexture m_shmTextures[2];
+        int m_frontTexture;
+        //region the back texture is missing relative to the front texture
+        QRegion m_backDamage;
+
+        TextureUploadJob m_uploadJob;
+        bool m_uploadInFlight;
+        //commitSerial() of the commit whose buffer the upload in flight holds
+        unsigned int m_uploadCommitSerial;
+        struct BufferDestroyListener{
+            struct wl_listener listener;
+            QtWaylandMotorcarSurface *surface;
+        } m_bufferDestroyListener;
+
+        bool m_committed;
+        QRegion m_pendingDamage;
+
         QtWaylandMotorcarCompositor *m_compositor;
 
-        GLuint composeSurface(QWaylandSurface *surface, bool *textureOwned, OpenGLData *glData);
-        void paintChildren(QWaylandSurface *surface, QWaylandSurface *window, const QSize &windowSize, OpenGLData *glData);
+        ///returns the wl_buffer resource currently attached to the surface, or NULL if there is none
+        struct wl_resource *currentBufferResource() const;
+        ///returns whether committed buffers are uploaded by the upload pool rather than during the frame
+        bool uploadsAsynchronously() const;
+        ///swaps in the committed buffer and hands its upload to the upload pool
+        void startUpload();
+        ///makes the texture filled by the in-flight upload the front texture once it has finished
+        /*if wait is true this blocks until the upload has finished, otherwise it returns immediately if it has not*/
+        void finishUpload(bool wait);
+        static void handleBufferDestroyed(struct wl_listener *listener, void *data);
+        GLuint composeSurface(QWaylandSurface *surface, const QRegion &damage, OpenGLData *glData);
         void computeSurfaceTransform(float ppcm);
 
 
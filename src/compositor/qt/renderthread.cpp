@@ -0,0 +1,107 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#include <qt/renderthread.h>
+#include <scenegraph/output/framerenderer.h>
+#include <profiling/framestatistics.h>
+#include <scenegraph/input/posepredictor.h>
+#include <gl/openglshader.h>
+
+#include <QtGui/private/qguiapplication_p.h>
+#include <qpa/qplatformintegration.h>
+
+using namespace qtmotorcar;
+
+RenderThread::RenderThread(QtWaylandMotorcarOpenGLContext *context, motorcar::GpuResourcePool *resourcePool, motorcar::FrameStatistics *frameStatistics,
+                           motorcar::FrameSnapshotBuffer *snapshots, int reader)
+    :m_context(context)
+    ,m_window(context->window())
+    ,m_resourcePool(resourcePool)
+    ,m_frameStatistics(frameStatistics)
+    ,m_snapshots(snapshots)
+    ,m_reader(reader)
+{
+    //a context can only be moved to another thread while it is not current
+    if(QOpenGLContext::currentContext() == m_window->context()){
+        m_window->context()->doneCurrent();
+    }
+    m_window->context()->moveToThread(this);
+    start();
+}
+
+RenderThread::~RenderThread()
+{
+    m_snapshots->stop();
+    wait();
+}
+
+bool RenderThread::isSupported()
+{
+    return QGuiApplicationPrivate::platformIntegration()->hasCapability(QPlatformIntegration::ThreadedOpenGL);
+}
+
+void RenderThread::run()
+{
+    m_window->makeCurrent();
+    //each reader draws on its own thread, so the reader index is a slot no other thread uses
+    motorcar::OpenGLShader::setDrawingThreadSlot(m_reader);
+
+    motorcar::FrameRenderer *renderer = new motorcar::FrameRenderer(m_resourcePool, m_context);
+
+    motorcar::FrameSnapshot *frame;
+    while((frame = m_snapshots->acquire(m_reader)) != NULL){
+        if(m_frameStatistics != NULL){
+            m_frameStatistics->beginFrame();
+        }
+        renderer->drawFrame(frame);
+
+        m_snapshots->setDrawnFence(m_reader, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+        //the fence is only guaranteed to signal once it has been flushed from this context
+        glFlush();
+
+        if(m_frameStatistics != NULL){
+            m_frameStatistics->endCpuWork();
+        }
+        m_window->swapBuffers();
+        //with vertical synchronization the swap returns once the frame is on its way to the screen
+        emit framePresented(frame->sequence, motorcar::PosePredictor::monotonicNanos());
+        if(m_frameStatistics != NULL){
+            m_frameStatistics->endFrame();
+        }
+    }
+
+    delete renderer;
+    m_window->context()->doneCurrent();
+    m_window->context()->moveToThread(QGuiApplication::instance()->thread());
+}
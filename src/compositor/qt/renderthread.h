@@ -0,0 +1,90 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#ifndef RENDERTHREAD_H
+#define RENDERTHREAD_H
+
+#include <qt/qtwaylandmotorcaropenglcontext.h>
+#include <scenegraph/output/framesnapshot.h>
+
+#include <QThread>
+
+namespace motorcar {
+class GpuResourcePool;
+class FrameStatistics;
+}
+
+namespace qtmotorcar{
+///Thread drawing the frame snapshots taken by the main thread into the window of one context
+/*The window's context is moved to this thread for as long as it runs, so the main thread must only use
+ * a context sharing objects with it from then on. Each published snapshot is drawn for the displays
+ * belonging to the context and the window's buffers swapped, so waiting for vertical blank no longer
+ * holds up the main thread, which keeps dispatching client requests and taking the next snapshot in the
+ * meantime. With several contexts there is one thread per context, each reading the same snapshots, so
+ * the displays are drawn concurrently and each swaps in step with its own screen.
+ *
+ * Must be created and destroyed on the gui thread*/
+class RenderThread : public QThread
+{
+    Q_OBJECT
+public:
+    ///starts drawing the snapshots published to the buffer as the given reader
+    /*frameStatistics may be NULL, as only one thread can record the compositor's frames*/
+    RenderThread(QtWaylandMotorcarOpenGLContext *context, motorcar::GpuResourcePool *resourcePool, motorcar::FrameStatistics *frameStatistics,
+                 motorcar::FrameSnapshotBuffer *snapshots, int reader);
+    ///stops the buffer, which ends every thread reading it, and waits for this one to finish
+    ~RenderThread();
+
+    ///returns whether the platform can make a context current on a thread other than the gui thread
+    static bool isSupported();
+
+signals:
+    ///emitted from the thread once the buffers showing the given frame have been swapped
+    /*the time is in nanoseconds on CLOCK_MONOTONIC, taken when the swap returned*/
+    void framePresented(quint32 frame, quint64 presentedNanos);
+
+protected:
+    void run() override;
+
+private:
+    QtWaylandMotorcarOpenGLContext *m_context;
+    QOpenGLWindow *m_window;
+    motorcar::GpuResourcePool *m_resourcePool;
+    motorcar::FrameStatistics *m_frameStatistics;
+    motorcar::FrameSnapshotBuffer *m_snapshots;
+    int m_reader;
+};
+}
+
+#endif // RENDERTHREAD_H
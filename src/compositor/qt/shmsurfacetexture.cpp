@@ -0,0 +1,262 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#include <qt/shmsurfacetexture.h>
+
+#include <QVector>
+
+#include <cstring>
+#include <iostream>
+
+using namespace qtmotorcar;
+
+//uploading many small rectangles costs more in call overhead than the pixels they save
+static const int MAX_DAMAGE_RECTS = 16;
+
+ShmSurfaceTexture::ShmSurfaceTexture()
+    :m_pool(NULL)
+    ,m_owner(NULL)
+    ,m_planeCount(0)
+    ,m_shmFormat(0)
+{
+    for(int i = 0; i < MAX_PLANES; i++){
+        m_textures[i] = 0;
+    }
+}
+
+ShmSurfaceTexture::~ShmSurfaceTexture()
+{
+    release();
+}
+
+void ShmSurfaceTexture::setResourcePool(motorcar::GpuResourcePool *pool, const void *owner)
+{
+    release();
+    m_pool = pool;
+    m_owner = owner;
+}
+
+GLuint ShmSurfaceTexture::texture(int plane) const
+{
+    if(plane < 0 || plane >= m_planeCount){
+        return 0;
+    }
+    return m_textures[plane];
+}
+
+QSize ShmSurfaceTexture::size() const
+{
+    return m_size;
+}
+
+motorcar::WaylandSurface::TextureFormat ShmSurfaceTexture::format() const
+{
+    switch(m_shmFormat){
+    case WL_SHM_FORMAT_XRGB8888:
+        return motorcar::WaylandSurface::TextureFormat::RGBX;
+    case WL_SHM_FORMAT_NV12:
+        return motorcar::WaylandSurface::TextureFormat::NV12;
+    case WL_SHM_FORMAT_YUV420:
+        return motorcar::WaylandSurface::TextureFormat::YUV420;
+    default:
+        return motorcar::WaylandSurface::TextureFormat::RGBA;
+    }
+}
+
+bool ShmSurfaceTexture::isSupportedFormat(uint32_t format)
+{
+    PlaneLayout planes[MAX_PLANES];
+    return planeLayouts(format, 0, 0, planes) > 0;
+}
+
+void ShmSurfaceTexture::update(wl_shm_buffer *buffer, const QRegion &damage, motorcar::PixelUnpackBufferRing *uploadBuffer)
+{
+    if(buffer == NULL){
+        return;
+    }
+
+    uint32_t shmFormat = wl_shm_buffer_get_format(buffer);
+    QSize size(wl_shm_buffer_get_width(buffer), wl_shm_buffer_get_height(buffer));
+    PlaneLayout planes[MAX_PLANES];
+    int planeCount = planeLayouts(shmFormat, size.height(), wl_shm_buffer_get_stride(buffer), planes);
+    if(planeCount == 0){
+        std::cout << "Warning: unsupported shm buffer format " << shmFormat << ", surface will not be updated" << std::endl;
+        return;
+    }
+
+    QRect bounds(QPoint(0, 0), size);
+    QRegion region = damage.intersected(bounds);
+
+    if(m_planeCount == 0 || size != m_size || shmFormat != m_shmFormat){
+        if(!allocate(size, shmFormat, planes, planeCount)){
+            return;
+        }
+        region = bounds;
+    }else if(region.isEmpty()){
+        region = bounds;
+    }
+
+    QVector<QRect> rects;
+    if(region.rectCount() > MAX_DAMAGE_RECTS){
+        rects.append(region.boundingRect());
+    }else{
+        rects = region.rects();
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    //the client may shrink the pool while we read from it, so the access has to be guarded against SIGBUS
+    wl_shm_buffer_begin_access(buffer);
+    const unsigned char *data = (const unsigned char *) wl_shm_buffer_get_data(buffer);
+    for(int p = 0; p < planeCount; p++){
+        const PlaneLayout &plane = planes[p];
+        int planeWidth = (size.width() + plane.subsampling - 1) / plane.subsampling;
+        int planeHeight = (size.height() + plane.subsampling - 1) / plane.subsampling;
+        QRect planeBounds(0, 0, planeWidth, planeHeight);
+
+        glBindTexture(GL_TEXTURE_2D, m_textures[p]);
+        for(int i = 0; i < rects.size(); i++){
+            const QRect &rect = rects[i];
+            //round outwards so that chroma samples shared with undamaged pixels are also refreshed
+            int left = rect.x() / plane.subsampling;
+            int top = rect.y() / plane.subsampling;
+            int right = (rect.x() + rect.width() + plane.subsampling - 1) / plane.subsampling;
+            int bottom = (rect.y() + rect.height() + plane.subsampling - 1) / plane.subsampling;
+            QRect planeRect = QRect(left, top, right - left, bottom - top).intersected(planeBounds);
+            if(!planeRect.isEmpty()){
+                uploadRect(data, plane, planeRect, uploadBuffer);
+            }
+        }
+    }
+    wl_shm_buffer_end_access(buffer);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void ShmSurfaceTexture::release()
+{
+    for(int i = 0; i < m_planeCount; i++){
+        m_pool->releaseTexture(m_textures[i]);
+    }
+    for(int i = 0; i < MAX_PLANES; i++){
+        m_textures[i] = 0;
+    }
+    m_planeCount = 0;
+    m_size = QSize();
+    m_shmFormat = 0;
+}
+
+int ShmSurfaceTexture::planeLayouts(uint32_t format, int height, int stride, PlaneLayout *planes)
+{
+    switch(format){
+    case WL_SHM_FORMAT_ARGB8888:
+    case WL_SHM_FORMAT_XRGB8888:
+        //little endian 32 bit ARGB is B, G, R, A in memory, which GL takes directly as BGRA
+        planes[0] = {1, 4, GL_RGBA8, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, 0, stride};
+        return 1;
+    case WL_SHM_FORMAT_NV12:
+        //full resolution luma followed by interleaved half resolution chroma with the same stride
+        planes[0] = {1, 1, GL_R8, GL_RED, GL_UNSIGNED_BYTE, 0, stride};
+        planes[1] = {2, 2, GL_RG8, GL_RG, GL_UNSIGNED_BYTE, (size_t) stride * height, stride};
+        return 2;
+    case WL_SHM_FORMAT_YUV420:
+        //full resolution luma followed by separate half resolution U and V planes with half the stride
+        planes[0] = {1, 1, GL_R8, GL_RED, GL_UNSIGNED_BYTE, 0, stride};
+        planes[1] = {2, 1, GL_R8, GL_RED, GL_UNSIGNED_BYTE, (size_t) stride * height, stride / 2};
+        planes[2] = {2, 1, GL_R8, GL_RED, GL_UNSIGNED_BYTE,
+                     (size_t) stride * height + (size_t) (stride / 2) * ((height + 1) / 2), stride / 2};
+        return 3;
+    default:
+        return 0;
+    }
+}
+
+bool ShmSurfaceTexture::allocate(const QSize &size, uint32_t shmFormat, const PlaneLayout *planes, int planeCount)
+{
+    release();
+
+    for(int p = 0; p < planeCount; p++){
+        int planeWidth = (size.width() + planes[p].subsampling - 1) / planes[p].subsampling;
+        int planeHeight = (size.height() + planes[p].subsampling - 1) / planes[p].subsampling;
+
+        m_textures[p] = m_pool->acquireTexture(m_owner, planes[p].internalFormat, glm::ivec2(planeWidth, planeHeight));
+        if(m_textures[p] == 0){
+            m_planeCount = p;
+            release();
+            return false;
+        }
+
+        glBindTexture(GL_TEXTURE_2D, m_textures[p]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    m_planeCount = planeCount;
+    m_size = size;
+    m_shmFormat = shmFormat;
+    return true;
+}
+
+void ShmSurfaceTexture::uploadRect(const unsigned char *data, const PlaneLayout &plane, const QRect &rect, motorcar::PixelUnpackBufferRing *uploadBuffer)
+{
+    const unsigned char *origin = data + plane.offset + (size_t) rect.y() * plane.stride + rect.x() * plane.bytesPerPixel;
+    size_t rowSize = (size_t) rect.width() * plane.bytesPerPixel;
+
+    void *staging = NULL;
+    GLintptr offset = 0;
+    if(uploadBuffer != NULL && uploadBuffer->allocate(rowSize * rect.height(), &staging, &offset)){
+        unsigned char *destination = (unsigned char *) staging;
+        if(rowSize == (size_t) plane.stride){
+            std::memcpy(destination, origin, rowSize * rect.height());
+        }else{
+            for(int row = 0; row < rect.height(); row++){
+                std::memcpy(destination + row * rowSize, origin + (size_t) row * plane.stride, rowSize);
+            }
+        }
+        uploadBuffer->unmap();
+        glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x(), rect.y(), rect.width(), rect.height(),
+                        plane.format, plane.type, (const GLvoid *) offset);
+        uploadBuffer->release();
+    }else{
+        //let GL walk the client rows itself rather than packing them first
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, plane.stride / plane.bytesPerPixel);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x(), rect.y(), rect.width(), rect.height(),
+                        plane.format, plane.type, origin);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    }
+}
@@ -0,0 +1,111 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#ifndef SHMSURFACETEXTURE_H
+#define SHMSURFACETEXTURE_H
+
+#include <QRegion>
+#include <QSize>
+
+#include <gl/pixelunpackbufferring.h>
+#include <gl/gpuresourcepool.h>
+#include <wayland/output/waylandsurface.h>
+
+#include <wayland-server.h>
+#include <GL/gl.h>
+
+namespace qtmotorcar{
+///Persistent textures holding the contents of a shared memory surface
+/*The client buffer is uploaded in its native layout: ARGB8888 and XRGB8888 are handed to GL as BGRA
+ * so no CPU side conversion happens, and the YUV formats (NV12, YUV420) are uploaded as one single or
+ * two channel texture per plane which the surface shader converts to RGB. format() reports which of
+ * these layouts the textures are in.
+ *
+ * The texture storage is taken from a resource pool (as immutable storage where the context supports it)
+ * and is only exchanged when the size or format of the client buffer changes, otherwise only the damaged
+ * region of each committed buffer is uploaded. If the pool refuses the storage the surface is not updated. When an upload buffer ring is passed to update() the
+ * pixels are staged in it so the transfer does not stall inside glTexSubImage2D.
+ *
+ * Must only be used while the compositor's OpenGL context is current*/
+class ShmSurfaceTexture
+{
+public:
+    static const int MAX_PLANES = 3;
+
+    ShmSurfaceTexture();
+    ~ShmSurfaceTexture();
+
+    ///sets the pool the textures are taken from and the owner they are charged to, must be called before update()
+    void setResourcePool(motorcar::GpuResourcePool *pool, const void *owner);
+
+    ///returns the texture holding the given plane, plane 0 is the only plane of RGB formats and luma of YUV formats
+    GLuint texture(int plane = 0) const;
+    QSize size() const;
+    motorcar::WaylandSurface::TextureFormat format() const;
+
+    ///returns whether buffers of the given wl_shm format can be uploaded
+    static bool isSupportedFormat(uint32_t format);
+
+    ///uploads the damaged part of the buffer, uploading all of it if the textures had to be (re)allocated
+    /*an empty damage region is treated as full damage, uploadBuffer may be NULL to upload from client memory*/
+    void update(struct wl_shm_buffer *buffer, const QRegion &damage, motorcar::PixelUnpackBufferRing *uploadBuffer = NULL);
+
+    ///returns the texture storage to the pool, the next update will acquire it again
+    void release();
+
+private:
+    struct PlaneLayout{
+        //number of luma pixels covered by one pixel of this plane in each direction
+        int subsampling;
+        int bytesPerPixel;
+        GLenum internalFormat, format, type;
+        size_t offset;
+        int stride;
+    };
+
+    motorcar::GpuResourcePool *m_pool;
+    const void *m_owner;
+    GLuint m_textures[MAX_PLANES];
+    int m_planeCount;
+    QSize m_size;
+    uint32_t m_shmFormat;
+
+    static int planeLayouts(uint32_t format, int height, int stride, PlaneLayout *planes);
+
+    bool allocate(const QSize &size, uint32_t shmFormat, const PlaneLayout *planes, int planeCount);
+    void uploadRect(const unsigned char *data, const PlaneLayout &plane, const QRect &rect, motorcar::PixelUnpackBufferRing *uploadBuffer);
+};
+}
+
+#endif // SHMSURFACETEXTURE_H
@@ -0,0 +1,184 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#include <qt/textureuploadpool.h>
+#include <gl/pixelunpackbufferring.h>
+
+#include <QThread>
+#include <QOffscreenSurface>
+#include <QMutexLocker>
+
+#include <iostream>
+
+using namespace qtmotorcar;
+
+class TextureUploadPool::Worker : public QThread
+{
+public:
+    Worker(TextureUploadPool *pool, QOpenGLContext *shareContext)
+        :m_pool(pool)
+        ,m_context(new QOpenGLContext())
+        ,m_surface(new QOffscreenSurface())
+    {
+        //offscreen surfaces have to be created on the gui thread
+        m_surface->setFormat(shareContext->format());
+        m_surface->create();
+
+        m_context->setFormat(shareContext->format());
+        m_context->setShareContext(shareContext);
+        m_context->create();
+        m_context->moveToThread(this);
+    }
+
+    ~Worker()
+    {
+        delete m_surface;
+    }
+
+    bool isValid() const
+    {
+        return m_surface->isValid() && m_context->isValid() && m_context->shareContext() != NULL;
+    }
+
+protected:
+    void run() override
+    {
+        m_context->makeCurrent(m_surface);
+
+        motorcar::PixelUnpackBufferRing *uploadBuffer = NULL;
+        if(motorcar::PixelUnpackBufferRing::isSupported()){
+            uploadBuffer = new motorcar::PixelUnpackBufferRing();
+        }
+
+        TextureUploadJob *job;
+        while((job = m_pool->takeJob()) != NULL){
+            glWaitSync(job->readFence, 0, GL_TIMEOUT_IGNORED);
+            job->texture->update(job->buffer, job->damage, uploadBuffer);
+            job->uploadFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            //the fence is only guaranteed to signal once it has been flushed from this context
+            glFlush();
+            m_pool->finishJob(job);
+        }
+
+        delete uploadBuffer;
+        m_context->doneCurrent();
+        delete m_context;
+    }
+
+private:
+    TextureUploadPool *m_pool;
+    QOpenGLContext *m_context;
+    QOffscreenSurface *m_surface;
+};
+
+TextureUploadPool::TextureUploadPool(QOpenGLContext *shareContext, int workerCount)
+    :m_stopping(false)
+    ,m_valid(true)
+{
+    for(int i = 0; i < workerCount; i++){
+        Worker *worker = new Worker(this, shareContext);
+        if(!worker->isValid()){
+            std::cout << "Warning: could not create shared context for texture upload worker" << std::endl;
+            m_valid = false;
+        }
+        m_workers.push_back(worker);
+    }
+
+    for(Worker *worker : m_workers){
+        worker->start();
+    }
+}
+
+TextureUploadPool::~TextureUploadPool()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_jobAvailable.wakeAll();
+    }
+    for(Worker *worker : m_workers){
+        worker->wait();
+        delete worker;
+    }
+}
+
+bool TextureUploadPool::isValid() const
+{
+    return m_valid;
+}
+
+void TextureUploadPool::submit(TextureUploadJob *job)
+{
+    QMutexLocker locker(&m_mutex);
+    job->finished = false;
+    job->uploadFence = NULL;
+    m_queue.push_back(job);
+    m_jobAvailable.wakeOne();
+}
+
+bool TextureUploadPool::isFinished(TextureUploadJob *job)
+{
+    QMutexLocker locker(&m_mutex);
+    return job->finished;
+}
+
+void TextureUploadPool::wait(TextureUploadJob *job)
+{
+    QMutexLocker locker(&m_mutex);
+    while(!job->finished){
+        m_jobFinished.wait(&m_mutex);
+    }
+}
+
+TextureUploadJob *TextureUploadPool::takeJob()
+{
+    QMutexLocker locker(&m_mutex);
+    while(m_queue.empty() && !m_stopping){
+        m_jobAvailable.wait(&m_mutex);
+    }
+    //jobs still queued when the pool is destroyed are finished first so nobody waits on them forever
+    if(m_queue.empty()){
+        return NULL;
+    }
+    TextureUploadJob *job = m_queue.front();
+    m_queue.pop_front();
+    return job;
+}
+
+void TextureUploadPool::finishJob(TextureUploadJob *job)
+{
+    QMutexLocker locker(&m_mutex);
+    job->finished = true;
+    m_jobFinished.wakeAll();
+}
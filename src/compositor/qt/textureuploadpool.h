@@ -0,0 +1,107 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#ifndef TEXTUREUPLOADPOOL_H
+#define TEXTUREUPLOADPOOL_H
+
+#include <qt/shmsurfacetexture.h>
+
+#include <QMutex>
+#include <QWaitCondition>
+#include <QRegion>
+#include <QtGui/QOpenGLContext>
+
+#include <wayland-server.h>
+#include <GL/gl.h>
+
+#include <deque>
+#include <vector>
+
+namespace qtmotorcar{
+///A single shared memory buffer upload handed to the TextureUploadPool
+/*The job is owned by whoever submits it and must stay alive, untouched, until the pool reports it finished*/
+struct TextureUploadJob
+{
+    ShmSurfaceTexture *texture;
+    struct wl_shm_buffer *buffer;
+    ///reference on the buffer's pool taken by the submitter, which keeps a wl_shm_pool.resize from remapping the
+    ///pool while the worker reads it, the submitter drops it once the job has finished
+    struct wl_shm_pool *pool;
+    QRegion damage;
+    ///created by the submitter once it is done drawing with the texture, the worker waits on it before uploading
+    GLsync readFence;
+    ///created by the worker once the upload is issued, the submitter waits on it before drawing with the texture
+    GLsync uploadFence;
+    ///guarded by the pool's lock
+    bool finished;
+};
+
+///Worker threads which upload shared memory buffers into textures off the render thread
+/*Each worker owns an OpenGL context sharing objects with the compositor's context, so the textures it
+ * fills can be drawn by the compositor directly. Jobs are independent of each other, the submitter is
+ * responsible for not submitting a job for a texture which is still being uploaded or drawn with.
+ *
+ * Must be created and destroyed on the thread which owns shareContext*/
+class TextureUploadPool
+{
+public:
+    TextureUploadPool(QOpenGLContext *shareContext, int workerCount = 2);
+    ~TextureUploadPool();
+
+    ///returns whether the worker contexts could be created, jobs must not be submitted otherwise
+    bool isValid() const;
+
+    void submit(TextureUploadJob *job);
+    ///returns whether the job has finished without blocking
+    bool isFinished(TextureUploadJob *job);
+    ///blocks until the job has finished
+    void wait(TextureUploadJob *job);
+
+private:
+    class Worker;
+
+    std::vector<Worker *> m_workers;
+    std::deque<TextureUploadJob *> m_queue;
+    QMutex m_mutex;
+    QWaitCondition m_jobAvailable, m_jobFinished;
+    bool m_stopping;
+    bool m_valid;
+
+    ///blocks until a job is available, returns NULL once the pool is being destroyed and the queue is empty
+    TextureUploadJob *takeJob();
+    void finishJob(TextureUploadJob *job);
+};
+}
+
+#endif // TEXTUREUPLOADPOOL_H
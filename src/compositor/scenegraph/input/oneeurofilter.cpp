@@ -0,0 +1,123 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#include <scenegraph/input/oneeurofilter.h>
+
+#include <cmath>
+
+using namespace motorcar;
+
+OneEuroFilter::OneEuroFilter(float positionMinCutoff, float positionBeta,
+                             float orientationMinCutoff, float orientationBeta, float derivativeCutoff)
+    :m_positionMinCutoff(positionMinCutoff)
+    ,m_positionBeta(positionBeta)
+    ,m_orientationMinCutoff(orientationMinCutoff)
+    ,m_orientationBeta(orientationBeta)
+    ,m_derivativeCutoff(derivativeCutoff)
+    ,m_initialized(false)
+    ,m_lastTimeNanos(0)
+    ,m_position(0)
+    ,m_linearVelocity(0)
+    ,m_orientation()
+    ,m_angularSpeed(0)
+{
+}
+
+void OneEuroFilter::filter(uint64_t timeNanos, const glm::vec3 &position, const glm::quat &orientation,
+                           glm::vec3 *filteredPosition, glm::quat *filteredOrientation)
+{
+    glm::quat target = glm::normalize(orientation);
+    if(!m_initialized || timeNanos <= m_lastTimeNanos){
+        if(!m_initialized){
+            m_initialized = true;
+            m_linearVelocity = glm::vec3(0);
+            m_angularSpeed = 0;
+        }
+        //without time passing there is no speed to adapt to, so take the sample as it is
+        m_lastTimeNanos = timeNanos;
+        m_position = position;
+        m_orientation = target;
+        *filteredPosition = m_position;
+        *filteredOrientation = m_orientation;
+        return;
+    }
+
+    float interval = (timeNanos - m_lastTimeNanos) / 1.0e9f;
+    m_lastTimeNanos = timeNanos;
+
+    glm::vec3 linearVelocity = (position - m_position) / interval;
+    m_linearVelocity = glm::mix(m_linearVelocity, linearVelocity, alpha(m_derivativeCutoff, interval));
+    float positionCutoff = m_positionMinCutoff + m_positionBeta * glm::length(m_linearVelocity);
+    m_position = glm::mix(m_position, position, alpha(positionCutoff, interval));
+
+    //take the shorter way around, q and -q being the same orientation
+    if(glm::dot(m_orientation, target) < 0.0f){
+        target = glm::quat(-target.w, -target.x, -target.y, -target.z);
+    }
+    float angle = 2.0f * std::acos(glm::clamp(glm::dot(m_orientation, target), -1.0f, 1.0f));
+    m_angularSpeed += alpha(m_derivativeCutoff, interval) * (angle / interval - m_angularSpeed);
+    float orientationCutoff = m_orientationMinCutoff + m_orientationBeta * m_angularSpeed;
+    m_orientation = glm::normalize(glm::slerp(m_orientation, target, alpha(orientationCutoff, interval)));
+
+    *filteredPosition = m_position;
+    *filteredOrientation = m_orientation;
+}
+
+void OneEuroFilter::reset()
+{
+    m_initialized = false;
+}
+
+void OneEuroFilter::setPositionParameters(float minCutoff, float beta)
+{
+    m_positionMinCutoff = minCutoff;
+    m_positionBeta = beta;
+}
+
+void OneEuroFilter::setOrientationParameters(float minCutoff, float beta)
+{
+    m_orientationMinCutoff = minCutoff;
+    m_orientationBeta = beta;
+}
+
+void OneEuroFilter::setDerivativeCutoff(float derivativeCutoff)
+{
+    m_derivativeCutoff = derivativeCutoff;
+}
+
+float OneEuroFilter::alpha(float cutoff, float interval)
+{
+    float timeConstant = 1.0f / (2.0f * (float) M_PI * cutoff);
+    return 1.0f / (1.0f + timeConstant / interval);
+}
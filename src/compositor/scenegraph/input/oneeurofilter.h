@@ -0,0 +1,84 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#ifndef ONEEUROFILTER_H
+#define ONEEUROFILTER_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <stdint.h>
+
+namespace motorcar {
+///Smooths the pose of a tracked device with a One Euro filter, a low pass filter whose cutoff rises with speed
+/*At rest the cutoff stays at the minimum cutoff, which removes sensor jitter, while fast motion raises it by beta
+ * times the speed so the filter lags behind as little as possible. Speed is itself low pass filtered at the derivative
+ * cutoff, so noise does not open the filter up. Position and orientation are filtered separately, the speeds being in
+ * meters and radians per second and all cutoffs in Hertz.
+ *
+ * See Casiez, Roussel and Vogel: "1 Euro Filter: A Simple Speed-based Low-pass Filter for Noisy Input in Interactive
+ * Systems", CHI 2012*/
+class OneEuroFilter
+{
+public:
+    OneEuroFilter(float positionMinCutoff = 1.0f, float positionBeta = 5.0f,
+                  float orientationMinCutoff = 1.0f, float orientationBeta = 0.5f, float derivativeCutoff = 1.0f);
+
+    ///filters a sample taken at the given time in nanoseconds, samples must be passed in time order
+    void filter(uint64_t timeNanos, const glm::vec3 &position, const glm::quat &orientation,
+                glm::vec3 *filteredPosition, glm::quat *filteredOrientation);
+    ///forgets the filter state, the next sample is passed through unchanged
+    void reset();
+
+    void setPositionParameters(float minCutoff, float beta);
+    void setOrientationParameters(float minCutoff, float beta);
+    void setDerivativeCutoff(float derivativeCutoff);
+
+private:
+    float m_positionMinCutoff, m_positionBeta;
+    float m_orientationMinCutoff, m_orientationBeta;
+    float m_derivativeCutoff;
+
+    bool m_initialized;
+    uint64_t m_lastTimeNanos;
+    glm::vec3 m_position, m_linearVelocity;
+    glm::quat m_orientation;
+    float m_angularSpeed;
+
+    ///smoothing factor of an exponential low pass filter with the given cutoff for the given sampling interval
+    static float alpha(float cutoff, float interval);
+};
+}
+
+#endif // ONEEUROFILTER_H
@@ -0,0 +1,183 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#include <scenegraph/input/posepredictor.h>
+
+#include <cmath>
+#include <time.h>
+
+using namespace motorcar;
+
+//a gap this long between samples means the tracker stalled, so velocities across it are meaningless
+#define POSE_PREDICTOR_MAX_SAMPLE_GAP_NANOS 100000000
+
+PosePredictor::PosePredictor(uint64_t maxPredictionNanos, size_t historySize)
+    :m_historySize(historySize < 2 ? 2 : historySize)
+    ,m_maxPredictionNanos(maxPredictionNanos)
+{
+}
+
+void PosePredictor::addSample(uint64_t timeNanos, const glm::vec3 &position, const glm::quat &orientation)
+{
+    if(!m_history.empty()){
+        uint64_t previousNanos = m_history.back().timeNanos;
+        if(timeNanos <= previousNanos){
+            //the tracker has not produced a new sample since the last one, keep the newer data only
+            m_history.back().position = position;
+            m_history.back().orientation = orientation;
+            return;
+        }
+        if(timeNanos - previousNanos > POSE_PREDICTOR_MAX_SAMPLE_GAP_NANOS){
+            m_history.clear();
+        }
+    }
+
+    Sample sample;
+    sample.timeNanos = timeNanos;
+    sample.position = position;
+    sample.orientation = glm::normalize(orientation);
+    m_history.push_back(sample);
+    if(m_history.size() > m_historySize){
+        m_history.pop_front();
+    }
+}
+
+void PosePredictor::addSample(uint64_t timeNanos, const glm::mat4 &transform)
+{
+    addSample(timeNanos, glm::vec3(transform[3]), glm::quat_cast(glm::mat3(transform)));
+}
+
+void PosePredictor::reset()
+{
+    m_history.clear();
+}
+
+bool PosePredictor::hasSamples() const
+{
+    return !m_history.empty();
+}
+
+void PosePredictor::predict(uint64_t targetNanos, glm::vec3 *position, glm::quat *orientation) const
+{
+    if(m_history.empty()){
+        *position = glm::vec3(0);
+        *orientation = glm::quat();
+        return;
+    }
+
+    const Sample &newest = m_history.back();
+    *position = newest.position;
+    *orientation = newest.orientation;
+    if(m_history.size() < 2 || targetNanos <= newest.timeNanos){
+        return;
+    }
+
+    uint64_t intervalNanos = targetNanos - newest.timeNanos;
+    if(intervalNanos > m_maxPredictionNanos){
+        intervalNanos = m_maxPredictionNanos;
+    }
+    float interval = intervalNanos / 1.0e9f;
+
+    *position += linearVelocity() * interval;
+
+    glm::vec3 angularVelocity = this->angularVelocity();
+    float speed = glm::length(angularVelocity);
+    if(speed > 0.0f){
+        //built by hand since the angle units of glm::angleAxis depend on GLM_FORCE_RADIANS
+        float halfAngle = speed * interval / 2.0f;
+        glm::vec3 axis = angularVelocity / speed * std::sin(halfAngle);
+        glm::quat rotation(std::cos(halfAngle), axis.x, axis.y, axis.z);
+        *orientation = glm::normalize(rotation * newest.orientation);
+    }
+}
+
+glm::mat4 PosePredictor::predictTransform(uint64_t targetNanos) const
+{
+    glm::vec3 position;
+    glm::quat orientation;
+    predict(targetNanos, &position, &orientation);
+
+    glm::mat4 transform = glm::mat4_cast(orientation);
+    transform[3] = glm::vec4(position, 1.0f);
+    return transform;
+}
+
+glm::vec3 PosePredictor::linearVelocity() const
+{
+    if(m_history.size() < 2){
+        return glm::vec3(0);
+    }
+    const Sample &oldest = m_history.front(), &newest = m_history.back();
+    float interval = (newest.timeNanos - oldest.timeNanos) / 1.0e9f;
+    return (newest.position - oldest.position) / interval;
+}
+
+glm::vec3 PosePredictor::angularVelocity() const
+{
+    if(m_history.size() < 2){
+        return glm::vec3(0);
+    }
+    const Sample &oldest = m_history.front(), &newest = m_history.back();
+    float interval = (newest.timeNanos - oldest.timeNanos) / 1.0e9f;
+
+    //rotation from the oldest to the newest orientation, taking the shorter way around
+    glm::quat delta = newest.orientation * glm::inverse(oldest.orientation);
+    if(delta.w < 0.0f){
+        delta = glm::quat(-delta.w, -delta.x, -delta.y, -delta.z);
+    }
+    glm::vec3 axis(delta.x, delta.y, delta.z);
+    float sinHalfAngle = glm::length(axis);
+    if(sinHalfAngle < 1.0e-6f){
+        return glm::vec3(0);
+    }
+    float angle = 2.0f * std::atan2(sinHalfAngle, delta.w);
+    return axis / sinHalfAngle * (angle / interval);
+}
+
+uint64_t PosePredictor::maxPredictionNanos() const
+{
+    return m_maxPredictionNanos;
+}
+
+void PosePredictor::setMaxPredictionNanos(uint64_t maxPredictionNanos)
+{
+    m_maxPredictionNanos = maxPredictionNanos;
+}
+
+uint64_t PosePredictor::monotonicNanos()
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t) time.tv_sec * 1000000000ull + time.tv_nsec;
+}
@@ -0,0 +1,97 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#ifndef POSEPREDICTOR_H
+#define POSEPREDICTOR_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <deque>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace motorcar {
+///Extrapolates the pose of a tracked device to the time its pixels will reach the eye
+/*Trackers feed every sample they read into the predictor, along with the time it was taken. The linear and
+ * angular velocity are estimated from the oldest and newest sample of a short history, which smooths sensor noise,
+ * and the newest pose is moved along them to the target time, usually Scene::predictedPresentationNanos().
+ *
+ * Extrapolation is limited to a maximum interval, as the constant velocity assumption only holds briefly, and the
+ * history is dropped when samples stop arriving for a while, so a device which stalled is not sent flying off
+ * once it comes back. All times are in nanoseconds on CLOCK_MONOTONIC, see monotonicNanos()*/
+class PosePredictor
+{
+public:
+    PosePredictor(uint64_t maxPredictionNanos = 50000000, size_t historySize = 4);
+
+    ///adds a sample taken at the given time, samples must be added in time order
+    void addSample(uint64_t timeNanos, const glm::vec3 &position, const glm::quat &orientation);
+    ///convenience overload for a rigid transform, scale is not supported
+    void addSample(uint64_t timeNanos, const glm::mat4 &transform);
+    ///forgets all samples, for example when the device was disconnected
+    void reset();
+
+    ///returns whether there is at least one sample to predict from
+    bool hasSamples() const;
+
+    ///computes the pose at the given time, returns the newest sample unchanged if there is not enough history
+    void predict(uint64_t targetNanos, glm::vec3 *position, glm::quat *orientation) const;
+    glm::mat4 predictTransform(uint64_t targetNanos) const;
+
+    ///velocity in meters per second
+    glm::vec3 linearVelocity() const;
+    ///rotation axis scaled by the rotation speed in radians per second
+    glm::vec3 angularVelocity() const;
+
+    uint64_t maxPredictionNanos() const;
+    void setMaxPredictionNanos(uint64_t maxPredictionNanos);
+
+    ///current time of CLOCK_MONOTONIC in nanoseconds, the clock all pose times are on
+    static uint64_t monotonicNanos();
+
+private:
+    struct Sample{
+        uint64_t timeNanos;
+        glm::vec3 position;
+        glm::quat orientation;
+    };
+
+    std::deque<Sample> m_history;
+    size_t m_historySize;
+    uint64_t m_maxPredictionNanos;
+};
+}
+
+#endif // POSEPREDICTOR_H
@@ -39,6 +39,13 @@
 
 
 using namespace motorcar;
+
+//motion is resent once the pointer moved this many meters or its axes turned by about this many radians
+static const float MOTION_POSITION_THRESHOLD = 0.0005f;
+static const float MOTION_ORIENTATION_THRESHOLD = 0.002f;
+//or the point it hits moved this many pixels on the surface
+static const float MOTION_SURFACE_THRESHOLD = 0.25f;
+
 SixDOFPointingDevice::SixDOFPointingDevice(Seat *seat, PhysicalNode *parent, const glm::mat4 &transform)
     :PhysicalNode(parent, transform)
     ,m_seat(seat)
@@ -49,6 +56,8 @@ SixDOFPointingDevice::SixDOFPointingDevice(Seat *seat, PhysicalNode *parent, con
     ,m_grabbedSurfaceNode(NULL)
     ,m_grabbedSurfaceNodeTransform()
     ,m_sixDofFocus(NULL)
+    ,m_motionSent(false)
+    ,m_motionSurfaceNode(NULL)
 {
     float vertices[]= {
         -0.05f, 0.0f, 0.0f,
@@ -77,23 +86,42 @@ SixDOFPointingDevice::SixDOFPointingDevice(Seat *seat, PhysicalNode *parent, con
     wl_array_add(&m_positionArray, sizeof(glm::vec3));
     wl_array_add(&m_orientationArray, sizeof(glm::mat3));
 
+    scene()->addSixDofPointingDevice(this);
+}
+
+SixDOFPointingDevice::~SixDOFPointingDevice()
+{
+    Scene *scene = this->scene();
+    if(scene != NULL){
+        scene->removeSixDofPointingDevice(this);
+    }
+    delete m_latestIntersection;
 }
 
 void SixDOFPointingDevice::handleFrameBegin(Scene *scene)
-{std::map<WaylandSurface *, WaylandSurfaceNode *> m_surfaceMap;
+{
     PhysicalNode::handleFrameBegin(scene);
 
     Geometry::Ray ray = Geometry::Ray(glm::vec3(0.0f,0.0f,0.0f), glm::vec3(0.0f,0.0f,-1.0f)).transform(worldTransform());
 
     Geometry::RaySurfaceIntersection *intersection = scene->intersectWithSurfaces(ray);
 
+    delete m_latestIntersection;
     this->m_latestIntersection = intersection;
 
     if(intersection != NULL){
         WaylandSurfaceNode *surfaceNode = intersection->surfaceNode;
 
-
-        mouseEvent(MouseEvent::Event::MOVE, MouseEvent::Button::NONE);
+        bool hitMoved = !m_motionSent || surfaceNode != m_motionSurfaceNode ||
+                glm::length(intersection->surfaceLocalCoordinates - m_motionSurfaceCoordinates) > MOTION_SURFACE_THRESHOLD;
+        //3D clients get the pose of the pointer, 2D surfaces only the point it hits
+        if(hitMoved || (surfaceNode->surface()->isMotorcarSurface() && poseMoved(worldTransform()))){
+            mouseEvent(MouseEvent::Event::MOVE, MouseEvent::Button::NONE);
+            m_motionSent = true;
+            m_motionTransform = worldTransform();
+            m_motionSurfaceNode = surfaceNode;
+            m_motionSurfaceCoordinates = intersection->surfaceLocalCoordinates;
+        }
 
         WaylandSurfaceNode *cursor = m_seat->pointer()->cursorNode();
         if(cursor){
@@ -117,7 +145,8 @@ void SixDOFPointingDevice::handleFrameBegin(Scene *scene)
                                                           m_seat, this->worldTransform()));
             m_sixDofFocus = NULL;
         }
-
+        //entering a surface again always sends motion
+        m_motionSent = false;
     }
 
     if(m_grabbedSurfaceNode != NULL){
@@ -125,6 +154,35 @@ void SixDOFPointingDevice::handleFrameBegin(Scene *scene)
     }
 }
 
+void SixDOFPointingDevice::handleFrameEnd(Scene *scene)
+{
+    PhysicalNode::handleFrameEnd(scene);
+
+    for(wl_client *client : m_batchedClients){
+        wl_resource *resource = resourceForClient(client);
+        if(resource != NULL && wl_resource_get_version(resource) >= MOTORCAR_SIX_DOF_POINTER_FRAME_SINCE_VERSION){
+            motorcar_six_dof_pointer_send_frame(resource);
+        }
+    }
+    m_batchedClients.clear();
+}
+
+bool SixDOFPointingDevice::poseMoved(const glm::mat4 &transform) const
+{
+    if(glm::length(glm::vec3(transform[3]) - glm::vec3(m_motionTransform[3])) > MOTION_POSITION_THRESHOLD){
+        return true;
+    }
+    //for small rotations the axes move by about the angle in radians
+    for(int axis = 0; axis < 3; axis++){
+        glm::vec3 current = glm::normalize(glm::vec3(transform[axis]));
+        glm::vec3 last = glm::normalize(glm::vec3(m_motionTransform[axis]));
+        if(glm::length(current - last) > MOTION_ORIENTATION_THRESHOLD){
+            return true;
+        }
+    }
+    return false;
+}
+
 
 
 
@@ -198,6 +256,10 @@ void SixDOFPointingDevice::sixDofPointerEvent(MotorcarSurfaceNode *surfaceNode,
 
     wl_resource *motorcarSurfaceResource = surfaceNode->resource();
     wl_resource *sixDofResource = this->resourceForClient(motorcarSurfaceResource->client);
+    if(sixDofResource == NULL){
+        return;
+    }
+    m_batchedClients.insert(motorcarSurfaceResource->client);
 
     glm::mat4 trans = event.transform();
     glm::mat3 orientation = glm::mat3(trans);
@@ -37,6 +37,7 @@
 
 #include <glm/gtc/type_ptr.hpp>
 #include <map>
+#include <set>
 
 
 #include <scenegraph/physicalnode.h>
@@ -59,11 +60,14 @@ class SixDOFPointingDevice : public PhysicalNode
 {
 public:
     SixDOFPointingDevice(Seat *seat, PhysicalNode *parent, const glm::mat4 &transform = glm::mat4());
-    virtual ~SixDOFPointingDevice() {}
+    virtual ~SixDOFPointingDevice();
 
 
     ///updates the current device state and moves any attaches surfaces
+    /*motion is only sent to the surface under the pointer when the pose or the hit point changed noticeably*/
     virtual void handleFrameBegin(Scene *scene) override;
+    ///ends the batch of events each client was sent during the frame
+    virtual void handleFrameEnd(Scene *scene) override;
 
     bool leftMouseDown() const;
     void setLeftMouseDown(bool leftMouseDown);
@@ -90,6 +94,8 @@ private:
 
     void mouseEvent(MouseEvent::Event event, MouseEvent::Button button);
     void sixDofPointerEvent(MotorcarSurfaceNode *surfaceNode, SixDofEvent event);
+    ///returns whether the pose differs enough from the one of the last motion to send motion again
+    bool poseMoved(const glm::mat4 &transform) const;
 
     Geometry::RaySurfaceIntersection *m_latestIntersection;
     bool m_leftMouseDown, m_rightMouseDown, m_middleMouseDown;
@@ -114,6 +120,14 @@ private:
 
     MotorcarSurfaceNode *m_sixDofFocus;
 
+    //state of the last motion, which is only resent once it changes noticeably
+    bool m_motionSent;
+    glm::mat4 m_motionTransform;
+    WaylandSurfaceNode *m_motionSurfaceNode;
+    glm::vec2 m_motionSurfaceCoordinates;
+    //clients which have been sent events since the last frame event
+    std::set<struct wl_client *> m_batchedClients;
+
 };
 }
 
@@ -0,0 +1,85 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#include <scenegraph/input/trackersamplequeue.h>
+
+using namespace motorcar;
+
+TrackerSample::TrackerSample()
+    :timeNanos(0)
+    ,position(0)
+    ,orientation()
+    ,buttons(0)
+{
+}
+
+
+
+TrackerSampleQueue::TrackerSampleQueue(size_t capacity)
+    :m_samples(capacity < 1 ? 1 : capacity)
+    ,m_head(0)
+    ,m_tail(0)
+    ,m_droppedSamples(0)
+{
+}
+
+bool TrackerSampleQueue::push(const TrackerSample &sample)
+{
+    size_t tail = m_tail.load(std::memory_order_relaxed);
+    if(tail - m_head.load(std::memory_order_acquire) >= m_samples.size()){
+        m_droppedSamples.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    m_samples[tail % m_samples.size()] = sample;
+    //publishes the sample written above
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+bool TrackerSampleQueue::pop(TrackerSample *sample)
+{
+    size_t head = m_head.load(std::memory_order_relaxed);
+    if(head == m_tail.load(std::memory_order_acquire)){
+        return false;
+    }
+    *sample = m_samples[head % m_samples.size()];
+    //hands the slot back to the producer only after it has been read
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+unsigned long TrackerSampleQueue::droppedSamples() const
+{
+    return m_droppedSamples.load(std::memory_order_relaxed);
+}
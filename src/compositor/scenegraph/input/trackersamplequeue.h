@@ -0,0 +1,88 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#ifndef TRACKERSAMPLEQUEUE_H
+#define TRACKERSAMPLEQUEUE_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <atomic>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace motorcar {
+///One reading of a tracked device, taken by the thread polling it
+struct TrackerSample
+{
+    TrackerSample();
+
+    ///when the sample was read, in nanoseconds on CLOCK_MONOTONIC
+    uint64_t timeNanos;
+    glm::vec3 position;
+    glm::quat orientation;
+    ///device specific button bitmask
+    uint32_t buttons;
+};
+
+///Lock-free queue handing samples from the thread polling a tracker to the main thread
+/*Exactly one thread may push and exactly one other thread may pop, neither ever blocks. The ring holds a fixed
+ * number of samples, if the consumer falls behind by more than that, for example while the compositor is not
+ * drawing, new samples are dropped and counted until it catches up*/
+class TrackerSampleQueue
+{
+public:
+    TrackerSampleQueue(size_t capacity = 64);
+
+    ///appends a sample, returns false and drops it if the queue is full, only called by the producer
+    bool push(const TrackerSample &sample);
+    ///removes the oldest sample into the given one, returns false if the queue is empty, only called by the consumer
+    bool pop(TrackerSample *sample);
+
+    ///number of samples dropped because the queue was full, may be called from any thread
+    unsigned long droppedSamples() const;
+
+private:
+    std::vector<TrackerSample> m_samples;
+    //positions count up forever, the slot of a position is the position modulo the capacity
+    std::atomic<size_t> m_head, m_tail;
+    std::atomic<unsigned long> m_droppedSamples;
+
+    TrackerSampleQueue(const TrackerSampleQueue &);
+    TrackerSampleQueue &operator=(const TrackerSampleQueue &);
+};
+}
+
+#endif // TRACKERSAMPLEQUEUE_H
@@ -33,6 +33,7 @@
 **
 ****************************************************************************/
 #include <scenegraph/output/display/display.h>
+#include <scenegraph/scene.h>
 
 using namespace motorcar;
 
@@ -42,56 +43,15 @@ Display::Display(OpenGLContext *glContext, glm::vec2 displayDimensions, Physical
     :PhysicalNode(parent, transform)
     ,m_glContext(glContext)
     ,m_dimensions(displayDimensions)
-
+    ,m_renderGraph(NULL)
+    ,m_frame(NULL)
+    ,m_snapshot(NULL)
+    ,m_outputTarget(-1)
+    ,m_sceneTarget(-1)
+    ,m_scratchTarget(-1)
+    ,m_scenePass(-1)
 {
     m_glContext->makeCurrent();
-
-    glm::ivec2 res = this->size();
-
-
-    glGenFramebuffers(1, &m_scratchFrameBuffer);
-    glBindFramebuffer(GL_FRAMEBUFFER, m_scratchFrameBuffer);
-
-    glGenTextures(1, &m_scratchColorBufferTexture);
-    glBindTexture(GL_TEXTURE_2D, m_scratchColorBufferTexture);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, res.x, res.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_scratchColorBufferTexture, 0);
-
-    glGenTextures(1, &m_scratchDepthBufferTexture);
-    glBindTexture(GL_TEXTURE_2D, m_scratchDepthBufferTexture);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, res.x, res.y, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, 0);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, m_scratchDepthBufferTexture, 0);
-
-
-
-    std::cout << "Checking Scratch Framebuffer:" << std::endl;
-    switch(glCheckFramebufferStatus(GL_FRAMEBUFFER)){
-            case(GL_FRAMEBUFFER_COMPLETE):
-                std::cout << "Framebuffer Complete" << std::endl;
-                break;
-            case(GL_FRAMEBUFFER_INCOMPLETE_ATTACHMENT):
-                std::cout << "Framebuffer Attachment Incomplete" << std::endl;
-                break;
-            case(GL_FRAMEBUFFER_INCOMPLETE_MISSING_ATTACHMENT):
-                std::cout << "Framebuffer Attachment Incomplete/Missing" << std::endl;
-                break;
-            case(GL_FRAMEBUFFER_UNSUPPORTED):
-                std::cout << "Framebuffer Unsupported" << std::endl;
-                break;
-            default:
-                std::cout << "Framebuffer is Incomplete for Unknown Reasons" << std::endl;
-                break;
-    }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
 }
 
 Display::~Display()
@@ -108,6 +68,7 @@ void Display::prepareForDraw()
 //        viewpoint->updateViewMatrix();
 //    }
     glContext()->makeCurrent();
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, activeFrameBuffer());
     //glClearColor(.7f, .85f, 1.f, 1.0f);
     glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
     glClearStencil(0.0);
@@ -117,6 +78,65 @@ void Display::prepareForDraw()
     glBlendFunc (GL_ONE,GL_ONE_MINUS_SRC_ALPHA);
 }
 
+void Display::declareRenderPasses(RenderGraph *graph, const FrameSnapshot *frame)
+{
+    m_renderGraph = graph;
+    m_frame = frame;
+    m_snapshot = frame->display(this);
+    m_outputTarget = graph->importTarget("default framebuffer", 0, m_snapshot->framebufferSize);
+    declareScenePass(graph, m_outputTarget);
+}
+
+void Display::declareScenePass(RenderGraph *graph, RenderGraph::Target target)
+{
+    m_sceneTarget = target;
+    m_scratchTarget = graph->createTarget("surface scratch", m_snapshot->size, RenderGraph::COLOR | RenderGraph::DEPTH_STENCIL, this);
+    m_scenePass = graph->addPass("scene", this);
+    graph->write(m_scenePass, m_sceneTarget);
+    graph->write(m_scenePass, m_scratchTarget);
+}
+
+void Display::executePass(RenderGraph *graph, RenderGraph::Pass pass)
+{
+    if(pass == m_scenePass){
+        prepareForDraw();
+        drawSceneItems();
+        finishDraw();
+    }
+}
+
+bool Display::trackerPose(glm::mat4 *trackerTransform, glm::quat *orientation) const
+{
+    return false;
+}
+
+bool Display::lateLatchOrientation(const FrameSnapshot *frame, glm::quat *orientation)
+{
+    return false;
+}
+
+void Display::drawSceneItems()
+{
+    glm::quat orientation;
+    if(!m_snapshot->tracked || !lateLatchOrientation(m_frame, &orientation)){
+        m_frame->drawItems(*m_snapshot);
+        return;
+    }
+
+    //the tracker turning from the snapshotted orientation to the new one carries every viewpoint below it along
+    glm::mat4 turn = glm::mat4_cast(glm::inverse(glm::normalize(orientation)) * m_snapshot->trackerOrientation);
+    glm::mat4 worldCorrection = m_snapshot->trackerTransform * turn * glm::inverse(m_snapshot->trackerTransform);
+
+    DisplaySnapshot latched = *m_snapshot;
+    for(ViewpointSnapshot &viewpoint : latched.viewpoints){
+        glm::mat4 viewMatrix = viewpoint.viewMatrix * worldCorrection;
+        viewpoint.lateLatchCorrection = viewMatrix * glm::inverse(viewpoint.viewMatrix);
+        viewpoint.lateLatched = true;
+        viewpoint.viewMatrix = viewMatrix;
+    }
+    m_frame->drawItems(latched);
+}
+
 
 
 void Display::addViewpoint(ViewPoint *v)
@@ -185,25 +205,25 @@ void Display::setGlContext(OpenGLContext *glContext)
 }
 
 
+GLuint Display::activeFrameBuffer() const
+{
+    return m_renderGraph == NULL ? 0 : m_renderGraph->framebuffer(m_sceneTarget);
+}
+
+GLuint Display::depthBufferTexture() const
+{
+    return m_renderGraph == NULL ? 0 : m_renderGraph->texture(m_sceneTarget, RenderGraph::DEPTH_STENCIL);
+}
+
 GLuint Display::scratchFrameBuffer() const
 {
-    return m_scratchFrameBuffer;
+    return m_renderGraph == NULL ? 0 : m_renderGraph->framebuffer(m_scratchTarget);
 }
 GLuint Display::scratchColorBufferTexture() const
 {
-    return m_scratchColorBufferTexture;
+    return m_renderGraph == NULL ? 0 : m_renderGraph->texture(m_scratchTarget, RenderGraph::COLOR);
 }
 GLuint Display::scratchDepthBufferTexture() const
 {
-    return m_scratchDepthBufferTexture;
+    return m_renderGraph == NULL ? 0 : m_renderGraph->texture(m_scratchTarget, RenderGraph::DEPTH_STENCIL);
 }
-
-
-
-
-
-
-
-
-
-
@@ -37,6 +37,8 @@
 #include <scenegraph/output/viewpoint.h>
 #include <scenegraph/physicalnode.h>
 #include <gl/openglcontext.h>
+#include <gl/rendergraph.h>
+#include <scenegraph/output/framesnapshot.h>
 #include <GL/gl.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -45,7 +47,7 @@
 
 namespace motorcar {
 class WaylandSurface;
-class Display : public PhysicalNode, public Geometry::Rectangle
+class Display : public PhysicalNode, public Geometry::Rectangle, public RenderGraph::Executor
 {
 public:
     Display(OpenGLContext *glContext, glm::vec2 displayDimensions, PhysicalNode *parent, const glm::mat4 &transform = glm::mat4());
@@ -55,6 +57,25 @@ public:
     virtual void prepareForDraw();
     virtual void finishDraw() {}
 
+    ///declares the passes drawing this display's snapshot of the frame into the frame's render graph
+    /*called on the thread drawing the frame, so only the snapshot may be used to find out about the scene
+     * and the display's state. The base display draws the scene straight into the default framebuffer in
+     * a single pass*/
+    virtual void declareRenderPasses(RenderGraph *graph, const FrameSnapshot *frame);
+    //inherited from RenderGraph::Executor
+    virtual void executePass(RenderGraph *graph, RenderGraph::Pass pass) override;
+
+    ///returns whether the viewpoints follow a tracker the display can sample while drawing, and the tracker's pose if so
+    /*called on the main thread when the frame is snapshotted, after the view matrices have been computed from the
+     * scene graph. The transform is the tracker's world transform and the orientation the one it was given relative
+     * to its parent, see lateLatchOrientation()*/
+    virtual bool trackerPose(glm::mat4 *trackerTransform, glm::quat *orientation) const;
+    ///samples the tracker's orientation once more right before the display's scene is drawn
+    /*called on the thread drawing the frame, so it may only use state which is safe to read from there. When it
+     * returns true the view matrices of the frame are rotated about the tracker from the orientation reported by
+     * trackerPose() to the returned one, so the scene is drawn with the newest orientation available*/
+    virtual bool lateLatchOrientation(const FrameSnapshot *frame, glm::quat *orientation);
+
 
     //for legacy mouse support
     //projects mouse position into worldpace based on implementation specific details
@@ -77,8 +98,10 @@ public:
     OpenGLContext *glContext() const;
     void setGlContext(OpenGLContext *glContext);
 
-    virtual GLuint activeFrameBuffer() const {return 0;}
-    virtual GLuint depthBufferTexture() const {return 0;}
+    //framebuffer the scene is drawn into and its depth texture (0 if it is the default framebuffer)
+    //these come from the render graph, so they are only valid while the frame is being drawn
+    GLuint activeFrameBuffer() const;
+    GLuint depthBufferTexture() const;
 
     GLuint scratchFrameBuffer() const;
     GLuint scratchColorBufferTexture() const;
@@ -91,7 +114,17 @@ private:
     OpenGLContext *m_glContext;
 
 protected:
-    GLuint m_scratchFrameBuffer, m_scratchColorBufferTexture, m_scratchDepthBufferTexture;
+    RenderGraph *m_renderGraph;
+    //the frame being drawn and this display's snapshot in it
+    const FrameSnapshot *m_frame;
+    const DisplaySnapshot *m_snapshot;
+    RenderGraph::Target m_outputTarget, m_sceneTarget, m_scratchTarget;
+    RenderGraph::Pass m_scenePass;
+
+    ///declares the pass drawing the scene graph into the given target, along with the scratch buffer surfaces composite through
+    void declareScenePass(RenderGraph *graph, RenderGraph::Target target);
+    ///draws the frame's items into the scene target, with the view matrices late latched if the display supports it
+    void drawSceneItems();
 
 
 
@@ -0,0 +1,129 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#include <scenegraph/output/display/mirrordisplay.h>
+
+using namespace motorcar;
+
+MirrorDisplay::MirrorDisplay(RenderToTextureDisplay *source, RenderToTextureDisplay::MirrorSource mirrorSource, OpenGLContext *glContext)
+    :Display(glContext, source->dimensions(), source)
+    ,m_mirror(source->mirror(mirrorSource))
+    ,m_mirrorPass(-1)
+    ,m_mirrorShader(new motorcar::OpenGLShader("motorcarmirror.vert", "motorcarmirror.frag"))
+{
+    h_aPosition_mirror = glGetAttribLocation(m_mirrorShader->handle(), "aPosition");
+    h_uScale_mirror = glGetUniformLocation(m_mirrorShader->handle(), "uScale");
+
+    if(h_aPosition_mirror < 0 || h_uScale_mirror < 0){
+       std::cout << "problem with mirror shader handles: " << h_aPosition_mirror << ", " << h_uScale_mirror << std::endl;
+    }
+
+    glUseProgram(m_mirrorShader->handle());
+    glUniform1i(glGetUniformLocation(m_mirrorShader->handle(), "uTexSampler"), 0);
+    glUseProgram(0);
+
+    const GLfloat vertexCoordinates[] ={
+       -1.0f, -1.0f, 0.0f,
+        1.0f, -1.0f, 0.0f,
+        1.0f,  1.0f, 0.0f,
+       -1.0f,  1.0f, 0.0f
+    };
+
+    glGenBuffers(1, &m_vertexCoordinates);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vertexCoordinates);
+    glBufferData(GL_ARRAY_BUFFER, 12 * sizeof(float), vertexCoordinates, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+MirrorDisplay::~MirrorDisplay()
+{
+    glDeleteBuffers(1, &m_vertexCoordinates);
+    delete m_mirrorShader;
+}
+
+void MirrorDisplay::declareRenderPasses(RenderGraph *graph, const FrameSnapshot *frame)
+{
+    m_renderGraph = graph;
+    m_frame = frame;
+    m_snapshot = frame->display(this);
+    m_outputTarget = graph->importTarget("default framebuffer", 0, m_snapshot->framebufferSize);
+    m_mirrorPass = graph->addPass("mirror", this);
+    graph->write(m_mirrorPass, m_outputTarget);
+}
+
+void MirrorDisplay::executePass(RenderGraph *graph, RenderGraph::Pass pass)
+{
+    if(pass != m_mirrorPass){
+        return;
+    }
+
+    glm::ivec2 framebufferSize = m_snapshot->framebufferSize;
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, graph->framebuffer(m_outputTarget));
+    glViewport(0, 0, framebufferSize.x, framebufferSize.y);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    if(m_mirror == NULL){
+        return;
+    }
+
+    glm::ivec2 size;
+    GLuint texture = m_mirror->beginRead(&size);
+    if(texture != 0){
+        //letterbox the image so it keeps its aspect ratio
+        float sourceAspect = (float) size.x / size.y, targetAspect = (float) framebufferSize.x / framebufferSize.y;
+        glm::vec2 scale = sourceAspect > targetAspect ? glm::vec2(1, targetAspect / sourceAspect) : glm::vec2(sourceAspect / targetAspect, 1);
+
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_STENCIL_TEST);
+        glDisable(GL_BLEND);
+
+        glUseProgram(m_mirrorShader->handle());
+        glUniform2fv(h_uScale_mirror, 1, glm::value_ptr(scale));
+
+        glEnableVertexAttribArray(h_aPosition_mirror);
+        glBindBuffer(GL_ARRAY_BUFFER, m_vertexCoordinates);
+        glVertexAttribPointer(h_aPosition_mirror, 3, GL_FLOAT, GL_FALSE, 0, 0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glDisableVertexAttribArray(h_aPosition_mirror);
+        glUseProgram(0);
+    }
+    m_mirror->endRead();
+}
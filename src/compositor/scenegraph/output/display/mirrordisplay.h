@@ -0,0 +1,73 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#ifndef MIRRORDISPLAY_H
+#define MIRRORDISPLAY_H
+
+#include <scenegraph/output/display/rendertotexturedisplay.h>
+#include <gl/openglshader.h>
+#include <gl/texturemailbox.h>
+
+namespace motorcar{
+///Shows what another display shows, in a window of its own, without drawing the scene again
+/*Every frame the source display copies its eye buffer or distorted output into a mailbox, which the mirror
+ * scales into its framebuffer keeping the aspect ratio, so a spectator view costs one copy and one textured
+ * quad per frame. The mirror has no viewpoints of its own and must not be used to pick with.
+ *
+ * It needs a context of its own sharing objects with the source's (see Compositor::createContext), and
+ * shows the newest image the source finished, so it may lag the source by a frame when they are drawn on
+ * different threads*/
+class MirrorDisplay : public Display
+{
+public:
+    ///creates a mirror of the given display, which is made the mirror's parent and must be part of the scene
+    MirrorDisplay(RenderToTextureDisplay *source, RenderToTextureDisplay::MirrorSource mirrorSource, OpenGLContext *glContext);
+    virtual ~MirrorDisplay();
+
+    //inherited from Display
+    virtual void declareRenderPasses(RenderGraph *graph, const FrameSnapshot *frame) override;
+    virtual void executePass(RenderGraph *graph, RenderGraph::Pass pass) override;
+
+private:
+    TextureMailbox *m_mirror;
+    RenderGraph::Pass m_mirrorPass;
+    GLuint m_vertexCoordinates;
+    OpenGLShader *m_mirrorShader;
+
+    //shader variable handles
+    GLint h_aPosition_mirror, h_uScale_mirror;
+};
+}
+
+#endif // MIRRORDISPLAY_H
@@ -35,6 +35,7 @@
 #include <scenegraph/output/display/rendertotexturedisplay.h>
 
 #include <gl/GLSLHelper.h>
+#include <scenegraph/scene.h>
 using namespace motorcar;
 
 
@@ -44,6 +45,10 @@ RenderToTextureDisplay::RenderToTextureDisplay(float scale, glm::vec4 distortion
     ,m_scale(scale)
     ,m_distortionK(distortionK)
     ,m_distortionShader(new motorcar::OpenGLShader("motorcarbarreldistortion.vert", "motorcarbarreldistortion.frag"))
+    ,m_eyeTarget(-1)
+    ,m_distortionPass(-1)
+    ,m_mirror(NULL)
+    ,m_mirrorSource(MirrorSource::DISTORTED_OUTPUT)
 {
 
     h_aPosition_distortion =  glGetAttribLocation(m_distortionShader->handle(), "aPosition");
@@ -83,107 +88,6 @@ RenderToTextureDisplay::RenderToTextureDisplay(float scale, glm::vec4 distortion
     glBufferData(GL_ARRAY_BUFFER, 12 * sizeof(float), vertexCoordinates, GL_STATIC_DRAW);
 
 
-    glm::ivec2 res = size();
-
-    std::cout << res.x << " , " << res.y <<std::endl;
-
-
-    glGenFramebuffers(1, &m_frameBuffer);
-    glBindFramebuffer(GL_FRAMEBUFFER, m_frameBuffer);
-
-    glGenTextures(1, &m_colorBufferTexture);
-    glBindTexture(GL_TEXTURE_2D, m_colorBufferTexture);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, res.x, res.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_colorBufferTexture, 0);
-
-//    glGenTextures(1, &m_depthBufferTexture);
-//    glBindTexture(GL_TEXTURE_2D, m_depthBufferTexture);
-//    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-//    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-//    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-//    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-//    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT16, res.x, res.y, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, 0);
-//    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_depthBufferTexture, 0);
-
-
-        glGenRenderbuffers(1, &m_depthBufferTexture);
-        glBindRenderbuffer(GL_RENDERBUFFER, m_depthBufferTexture);
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, res.x, res.y);
-        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depthBufferTexture);
-
-    std::cout << "Checking Distortion Framebuffer:" << std::endl;
-    switch(glCheckFramebufferStatus(GL_FRAMEBUFFER)){
-            case(GL_FRAMEBUFFER_COMPLETE):
-                std::cout << "Framebuffer Complete" << std::endl;
-                break;
-            case(GL_FRAMEBUFFER_INCOMPLETE_ATTACHMENT):
-                std::cout << "Framebuffer Attachment Incomplete" << std::endl;
-                break;
-            case(GL_FRAMEBUFFER_INCOMPLETE_MISSING_ATTACHMENT):
-                std::cout << "Framebuffer Attachment Incomplete/Missing" << std::endl;
-                break;
-            case(GL_FRAMEBUFFER_UNSUPPORTED):
-                std::cout << "Framebuffer Unsupported" << std::endl;
-                break;
-            default:
-                std::cout << "Framebuffer is Incomplete for Unknown Reasons" << std::endl;
-                break;
-    }
-
-
-    //generate new renderbuffers of correct size
-    glBindFramebuffer(GL_FRAMEBUFFER, m_scratchFrameBuffer);
-
-    glGenTextures(1, &m_scratchColorBufferTexture);
-    glBindTexture(GL_TEXTURE_2D, m_scratchColorBufferTexture);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, res.x, res.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_scratchColorBufferTexture, 0);
-
-    glGenTextures(1, &m_scratchDepthBufferTexture);
-    glBindTexture(GL_TEXTURE_2D, m_scratchDepthBufferTexture);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, res.x, res.y, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, 0);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, m_scratchDepthBufferTexture, 0);
-
-//    glBindRenderbuffer(GL_RENDERBUFFER, m_scratchColorBuffer);
-//    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA, res.x, res.y);
-//    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_scratchColorBuffer);
-
-//    glBindRenderbuffer(GL_RENDERBUFFER, m_scratchDepthBuffer);
-//    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, res.x, res.y);
-//    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_scratchDepthBuffer);
-
-    std::cout << "Checking Modified Scratch Framebuffer:" << std::endl;
-    switch(glCheckFramebufferStatus(GL_FRAMEBUFFER)){
-            case(GL_FRAMEBUFFER_COMPLETE):
-                std::cout << "Framebuffer Complete" << std::endl;
-                break;
-            case(GL_FRAMEBUFFER_INCOMPLETE_ATTACHMENT):
-                std::cout << "Framebuffer Attachment Incomplete" << std::endl;
-                break;
-            case(GL_FRAMEBUFFER_INCOMPLETE_MISSING_ATTACHMENT):
-                std::cout << "Framebuffer Attachment Incomplete/Missing" << std::endl;
-                break;
-            case(GL_FRAMEBUFFER_UNSUPPORTED):
-                std::cout << "Framebuffer Unsupported" << std::endl;
-                break;
-            default:
-                std::cout << "Framebuffer is Incomplete for Unknown Reasons" << std::endl;
-                break;
-    }
-
-
     glEnable(GL_TEXTURE_2D);
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
@@ -191,27 +95,78 @@ RenderToTextureDisplay::RenderToTextureDisplay(float scale, glm::vec4 distortion
 
 RenderToTextureDisplay::~RenderToTextureDisplay()
 {
-    glDeleteFramebuffers(1, &m_frameBuffer);
+    glDeleteBuffers(1, &m_surfaceTextureCoordinates);
+    glDeleteBuffers(1, &m_surfaceVertexCoordinates);
     delete m_distortionShader;
+    delete m_mirror;
 
 
 }
 
-void RenderToTextureDisplay::prepareForDraw()
+void RenderToTextureDisplay::declareRenderPasses(RenderGraph *graph, const FrameSnapshot *frame)
 {
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-    glClear (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    m_renderGraph = graph;
+    m_frame = frame;
+    m_snapshot = frame->display(this);
+    m_outputTarget = graph->importTarget("default framebuffer", 0, m_snapshot->framebufferSize);
+    m_eyeTarget = graph->createTarget("eye buffer", m_snapshot->size, RenderGraph::COLOR | RenderGraph::DEPTH_STENCIL, this);
+    declareScenePass(graph, m_eyeTarget);
+
+    m_distortionPass = graph->addPass("distortion", this);
+    graph->read(m_distortionPass, m_eyeTarget);
+    graph->write(m_distortionPass, m_outputTarget);
+}
 
+void RenderToTextureDisplay::executePass(RenderGraph *graph, RenderGraph::Pass pass)
+{
+    if(pass == m_scenePass){
+        prepareForDraw();
+        drawSceneItems();
+    }else if(pass == m_distortionPass){
+        finishDraw();
+        if(m_mirror != NULL){
+            copyToMirror();
+        }
+    }
+}
+
+TextureMailbox *RenderToTextureDisplay::mirror(MirrorSource source)
+{
+    if(m_mirror == NULL){
+        Scene *scene = this->scene();
+        if(scene == NULL){
+            std::cout << "Warning: cannot mirror a display which is not part of a scene" << std::endl;
+            return NULL;
+        }
+        m_mirror = new TextureMailbox(scene->resourcePool());
+    }
+    m_mirrorSource = source;
+    return m_mirror;
+}
 
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_frameBuffer);
-    Display::prepareForDraw();
+void RenderToTextureDisplay::copyToMirror()
+{
+    //the eye buffer is still alive here as the distortion pass is the last to read it
+    RenderGraph::Target source = m_mirrorSource == MirrorSource::EYE_BUFFER ? m_eyeTarget : m_outputTarget;
+    glm::ivec2 size = m_renderGraph->size(source);
+
+    GLuint texture = m_mirror->beginWrite(size);
+    if(texture != 0){
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, m_renderGraph->framebuffer(source));
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, size.x, size.y);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    }
+    m_mirror->endWrite();
 }
 
 void RenderToTextureDisplay::finishDraw()
 {
 
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_renderGraph->framebuffer(m_outputTarget));
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     glUseProgram(m_distortionShader->handle());
 
@@ -221,26 +176,24 @@ void RenderToTextureDisplay::finishDraw()
     glBindBuffer(GL_ARRAY_BUFFER, m_surfaceVertexCoordinates);
     glVertexAttribPointer(h_aPosition_distortion, 3, GL_FLOAT, GL_FALSE, 0, 0);
 
-    glBindTexture(GL_TEXTURE_2D, m_colorBufferTexture);
+    glBindTexture(GL_TEXTURE_2D, m_renderGraph->texture(m_eyeTarget, RenderGraph::COLOR));
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
 
-    float temp_scale = m_scale;
-    m_scale = 1;
-
-
-
+    //the viewports are laid out over the unscaled framebuffer rather than the eye buffer
+    glm::vec4 framebufferSize(m_snapshot->framebufferSize, m_snapshot->framebufferSize);
 
-    for(ViewPoint *viewpoint : viewpoints()){
+    for(const ViewpointSnapshot &viewpoint : m_snapshot->viewpoints){
 
-        viewpoint->viewport()->set();
+        glm::vec4 viewport = viewpoint.viewportParams * framebufferSize;
+        glViewport(viewport.x, viewport.y, viewport.z, viewport.w);
 
 
-        glUniform2fv(h_uLenseCenter, 1, glm::value_ptr(glm::vec2(viewpoint->centerOfFocus())));
-        glUniform4fv(h_uViewportParams, 1, glm::value_ptr(viewpoint->viewport()->viewportParams()));
+        glUniform2fv(h_uLenseCenter, 1, glm::value_ptr(glm::vec2(viewpoint.centerOfFocus)));
+        glUniform4fv(h_uViewportParams, 1, glm::value_ptr(viewpoint.viewportParams));
         glUniform4fv(h_uDistortionK, 1, glm::value_ptr(m_distortionK));
-        glUniform1f(h_uScaleFactor, temp_scale);
+        glUniform1f(h_uScaleFactor, m_scale);
 
 
 
@@ -248,8 +201,6 @@ void RenderToTextureDisplay::finishDraw()
 
     }
 
-    m_scale = temp_scale;
-
     glBindTexture(GL_TEXTURE_2D, 0);
 
 
@@ -272,13 +223,3 @@ glm::vec2 RenderToTextureDisplay::dimensions() const
 {
     return m_scale * Display::dimensions();
 }
-
-GLuint RenderToTextureDisplay::activeFrameBuffer() const
-{
-    return m_frameBuffer;
-}
-
-GLuint RenderToTextureDisplay::depthBufferTexture() const
-{
-    return m_depthBufferTexture;
-}
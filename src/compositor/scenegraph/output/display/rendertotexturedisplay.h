@@ -37,6 +37,7 @@
 
 #include <scenegraph/output/display/display.h>
 #include <gl/openglshader.h>
+#include <gl/texturemailbox.h>
 
 namespace motorcar{
 class RenderToTextureDisplay : public Display
@@ -45,21 +46,41 @@ public:
     RenderToTextureDisplay(float scale, glm::vec4 distortionK, OpenGLContext *glContext, glm::vec2 displayDimensions, PhysicalNode *parent, const glm::mat4 &transform = glm::mat4());
     virtual ~RenderToTextureDisplay();
 
+    ///image of the display which is copied for mirror displays
+    enum class MirrorSource{
+        ///the undistorted eye buffer, in the display's scaled resolution
+        EYE_BUFFER,
+        ///the distorted output, as shown on the display itself
+        DISTORTED_OUTPUT
+    };
+
+    ///returns the mailbox the given image is copied into at the end of every frame, creating it on first call
+    /*only one image can be mirrored, later calls return the same mailbox and change the image copied into it.
+     * Must be called before the compositor starts, returns NULL if the display is not part of a scene*/
+    TextureMailbox *mirror(MirrorSource source);
+
     //inherited from Display
-    virtual void prepareForDraw() override;
     virtual void finishDraw() override;
+    ///draws the scene into a transient eye buffer, then distorts it into the default framebuffer in a second pass
+    virtual void declareRenderPasses(RenderGraph *graph, const FrameSnapshot *frame) override;
+    virtual void executePass(RenderGraph *graph, RenderGraph::Pass pass) override;
 
 
     //inherited from Display, apply scaling factor to base class output
     virtual glm::ivec2 size() override;
     virtual glm::vec2 dimensions() const override;
 
-    virtual GLuint activeFrameBuffer() const override;
-    virtual GLuint depthBufferTexture() const override;
 private:
     float m_scale;
     glm::vec4 m_distortionK;
-    GLuint m_frameBuffer, m_colorBufferTexture, m_depthBufferTexture, m_surfaceTextureCoordinates, m_surfaceVertexCoordinates;
+    GLuint m_surfaceTextureCoordinates, m_surfaceVertexCoordinates;
+    RenderGraph::Target m_eyeTarget;
+    RenderGraph::Pass m_distortionPass;
+    TextureMailbox *m_mirror;
+    MirrorSource m_mirrorSource;
+
+    ///copies the mirrored image into the next texture of the mirror's mailbox, called at the end of the distortion pass
+    void copyToMirror();
     //shaders
     OpenGLShader *m_distortionShader;
 
@@ -42,11 +42,11 @@ Drawable::Drawable(SceneGraphNode *parent, const glm::mat4 &transform)
 {
 }
 
-void Drawable::handleFrameDraw(Scene *scene)
+void Drawable::handleFrameSnapshot(Scene *scene)
 {
-    VirtualNode::handleFrameDraw(scene);
+    VirtualNode::handleFrameSnapshot(scene);
     if(visible()){
-        this->draw(scene, scene->activeDisplay());
+        this->snapshot(scene, scene->frameSnapshot());
     }
 }
 
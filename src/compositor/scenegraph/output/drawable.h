@@ -36,6 +36,9 @@
 #define DRAWABLE_H
 #include <scenegraph/virtualnode.h>
 #include <scenegraph/output/viewpoint.h>
+#include <scenegraph/output/framesnapshot.h>
+
+#include <memory>
 
 namespace motorcar {
 class Drawable : public VirtualNode
@@ -44,17 +47,16 @@ public:
     Drawable(SceneGraphNode *parent, const glm::mat4 &transform = glm::mat4());
     virtual ~Drawable(){}
 
-    ///Draw this node for the current display
-    /* this method should contain all the openGL code needed to draw the node,
-     * implementations can assume that the correct context is current and the
-     * correct framebuffer is bound. If the framebuffer needs to be unbound
-     * the implementation must tell the display to rebind its framebuffer
-     * before drawing into it, do not assume drawing into the default
-     * framebuffer is safe*/
-    virtual void draw(Scene *scene, Display *display) = 0;
+    ///Add what is needed to draw this node to the frame being snapshotted
+    /* this method is called on the main thread with the compositor's context current and
+     * should add RenderItems to the frame which draw the node for every display. The items are
+     * drawn later, possibly on another thread while this node is being changed or deleted,
+     * so everything they need must be copied into them (see RenderItem). Uploads to textures
+     * the items sample can be done here*/
+    virtual void snapshot(Scene *scene, FrameSnapshot *frame) = 0;
 
-    ///Gets the active display from the scene and calls draw on it
-    virtual void handleFrameDraw(Scene *scene) override;
+    ///Gets the frame being snapshotted from the scene and calls snapshot on it
+    virtual void handleFrameSnapshot(Scene *scene) override;
 
     bool visible() const;
     void setVisible(bool visible);
@@ -0,0 +1,77 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#include <scenegraph/output/framerenderer.h>
+#include <scenegraph/output/display/display.h>
+
+#include <iostream>
+
+using namespace motorcar;
+
+FrameRenderer::FrameRenderer(GpuResourcePool *resourcePool, const OpenGLContext *context)
+    :m_renderGraph(resourcePool)
+    ,m_context(context)
+{
+}
+
+FrameRenderer::~FrameRenderer()
+{
+}
+
+void FrameRenderer::drawFrame(const FrameSnapshot *frame)
+{
+    //textures uploaded while the frame was snapshotted may still be in flight on the snapshotting context
+    if(frame->readyFence != 0){
+        glWaitSync(frame->readyFence, 0, GL_TIMEOUT_IGNORED);
+    }
+
+    m_renderGraph.reset();
+    for(const DisplaySnapshot &display : frame->displays){
+        if(m_context == NULL || display.context == m_context){
+            display.display->declareRenderPasses(&m_renderGraph, frame);
+        }
+    }
+    m_renderGraph.compile();
+    m_renderGraph.execute();
+
+    int error = glGetError();
+    if(error != GL_NO_ERROR){
+        std::cout <<  "OpenGL Error from frame drawing: " << error <<std::endl;
+    }
+}
+
+const OpenGLContext *FrameRenderer::context() const
+{
+    return m_context;
+}
@@ -0,0 +1,67 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#ifndef FRAMERENDERER_H
+#define FRAMERENDERER_H
+
+#include <scenegraph/output/framesnapshot.h>
+#include <gl/rendergraph.h>
+
+namespace motorcar {
+class GpuResourcePool;
+class OpenGLContext;
+///Draws frame snapshots to the displays they were taken for
+/*The renderer owns the render graph of the frame and the targets it allocates, which are framebuffer objects
+ * and therefore belong to the context the renderer is used with, so a renderer must only ever be used with
+ * one context, and be deleted with that context current. When displays are drawn in several contexts, each
+ * context has its own renderer drawing only the displays belonging to it*/
+class FrameRenderer
+{
+public:
+    ///creates a renderer for the displays drawn in the given context, or for every display if it is NULL
+    FrameRenderer(GpuResourcePool *resourcePool, const OpenGLContext *context = NULL);
+    ~FrameRenderer();
+
+    ///draws the snapshot, the snapshot and every display in it must stay alive until this returns
+    void drawFrame(const FrameSnapshot *frame);
+
+    const OpenGLContext *context() const;
+
+private:
+    RenderGraph m_renderGraph;
+    const OpenGLContext *m_context;
+};
+}
+
+#endif // FRAMERENDERER_H
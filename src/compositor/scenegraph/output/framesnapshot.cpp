@@ -0,0 +1,284 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#include <scenegraph/output/framesnapshot.h>
+#include <scenegraph/output/display/display.h>
+#include <scenegraph/output/viewpoint.h>
+#include <gl/viewport.h>
+
+#include <algorithm>
+
+using namespace motorcar;
+
+ViewpointSnapshot::ViewpointSnapshot(ViewPoint *viewpoint)
+    :viewpoint(viewpoint)
+    ,viewMatrix(viewpoint->viewMatrix())
+    ,projectionMatrix(viewpoint->projectionMatrix())
+    ,viewport(viewpoint->viewport()->offsetX(), viewpoint->viewport()->offsetY(),
+              viewpoint->viewport()->width(), viewpoint->viewport()->height())
+    ,viewportParams(viewpoint->viewport()->viewportParams())
+    ,clientColorViewportParams(viewpoint->clientColorViewport()->viewportParams())
+    ,clientDepthViewportParams(viewpoint->clientDepthViewport()->viewportParams())
+    ,centerOfFocus(viewpoint->centerOfFocus())
+    ,lateLatchCorrection()
+    ,lateLatched(false)
+{
+}
+
+void ViewpointSnapshot::setViewport() const
+{
+    glViewport(viewport.x, viewport.y, viewport.z, viewport.w);
+}
+
+
+
+DisplaySnapshot::DisplaySnapshot(Display *display)
+    :display(display)
+    ,context(display->glContext())
+    ,size(display->size())
+    ,framebufferSize(display->glContext()->defaultFramebufferSize())
+    ,tracked(false)
+    ,trackerTransform()
+    ,trackerOrientation()
+{
+    tracked = display->trackerPose(&trackerTransform, &trackerOrientation);
+    for(ViewPoint *viewpoint : display->viewpoints()){
+        viewpoints.push_back(ViewpointSnapshot(viewpoint));
+    }
+}
+
+const ViewpointSnapshot *DisplaySnapshot::viewpoint(const ViewPoint *viewpoint) const
+{
+    for(const ViewpointSnapshot &snapshot : viewpoints){
+        if(snapshot.viewpoint == viewpoint){
+            return &snapshot;
+        }
+    }
+    return NULL;
+}
+
+
+
+FrameSnapshot::FrameSnapshot()
+    :timestampMillis(0)
+    ,sequence(0)
+    ,predictedPresentationNanos(0)
+    ,readyFence(0)
+{
+}
+
+FrameSnapshot::~FrameSnapshot()
+{
+    clear();
+}
+
+void FrameSnapshot::clear()
+{
+    for(RenderItem *item : items){
+        delete item;
+    }
+    items.clear();
+    displays.clear();
+    if(readyFence != 0){
+        glDeleteSync(readyFence);
+        readyFence = 0;
+    }
+}
+
+void FrameSnapshot::drawItems(const DisplaySnapshot &display) const
+{
+    for(RenderItem *item : items){
+        item->draw(display);
+    }
+}
+
+const DisplaySnapshot *FrameSnapshot::display(const Display *display) const
+{
+    for(const DisplaySnapshot &snapshot : displays){
+        if(snapshot.display == display){
+            return &snapshot;
+        }
+    }
+    return NULL;
+}
+
+
+
+FrameSnapshotBuffer::FrameSnapshotBuffer(int readerCount)
+    :m_writing(NULL)
+    ,m_published(NULL)
+    ,m_publishedGeneration(0)
+    ,m_stopping(false)
+    ,m_drawing(readerCount, NULL)
+    ,m_acquiredGenerations(readerCount, 0)
+    ,m_drawnFences(readerCount, 0)
+    ,m_fencedGenerations(readerCount, 0)
+{
+    for(int i = 0; i < readerCount + 2; i++){
+        m_snapshots.push_back(new FrameSnapshot());
+    }
+}
+
+FrameSnapshotBuffer::~FrameSnapshotBuffer()
+{
+    for(GLsync fence : m_drawnFences){
+        if(fence != 0){
+            glDeleteSync(fence);
+        }
+    }
+    for(FrameSnapshot *snapshot : m_snapshots){
+        delete snapshot;
+    }
+}
+
+int FrameSnapshotBuffer::readerCount() const
+{
+    return m_drawing.size();
+}
+
+FrameSnapshot *FrameSnapshotBuffer::writeSnapshot()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(m_writing == NULL){
+        //with two more snapshots than readers there is always one neither published nor drawn
+        for(FrameSnapshot *snapshot : m_snapshots){
+            if(snapshot != m_published && std::find(m_drawing.begin(), m_drawing.end(), snapshot) == m_drawing.end()){
+                m_writing = snapshot;
+                break;
+            }
+        }
+    }
+    return m_writing;
+}
+
+void FrameSnapshotBuffer::publish()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(m_writing == NULL){
+        return;
+    }
+    m_published = m_writing;
+    m_writing = NULL;
+    m_publishedGeneration++;
+    m_snapshotPublished.notify_all();
+}
+
+unsigned long FrameSnapshotBuffer::writeGeneration()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_publishedGeneration + 1;
+}
+
+unsigned long FrameSnapshotBuffer::oldestGenerationInUse()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    unsigned long oldest = m_publishedGeneration + 1;
+    for(int reader = 0; reader < readerCount(); reader++){
+        unsigned long inUse;
+        if(isDrawing(reader)){
+            inUse = m_acquiredGenerations[reader];
+        }else{
+            //an idle reader next picks up the published snapshot, unless it already drew that one
+            inUse = m_acquiredGenerations[reader] == m_publishedGeneration ? m_publishedGeneration + 1 : m_publishedGeneration;
+        }
+
+        //the fence covers every frame the reader drew up to and including the generation it was set for
+        GLsync fence = m_drawnFences[reader];
+        if(fence != 0){
+            GLenum status = glClientWaitSync(fence, 0, 0);
+            if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED){
+                inUse = std::min(inUse, m_fencedGenerations[reader]);
+            }
+        }
+        oldest = std::min(oldest, inUse);
+    }
+    return oldest;
+}
+
+FrameSnapshot *FrameSnapshotBuffer::acquire(int reader)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while(m_acquiredGenerations[reader] == m_publishedGeneration && !m_stopping){
+        m_snapshotPublished.wait(lock);
+    }
+    if(m_stopping){
+        m_drawing[reader] = NULL;
+        m_frameFenced.notify_all();
+        return NULL;
+    }
+    m_drawing[reader] = m_published;
+    m_acquiredGenerations[reader] = m_publishedGeneration;
+    return m_published;
+}
+
+void FrameSnapshotBuffer::stop()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopping = true;
+    m_snapshotPublished.notify_all();
+    m_frameFenced.notify_all();
+}
+
+void FrameSnapshotBuffer::setDrawnFence(int reader, GLsync fence)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    //deletion is deferred by GL until nobody waits on the fence anymore
+    if(m_drawnFences[reader] != 0){
+        glDeleteSync(m_drawnFences[reader]);
+    }
+    m_drawnFences[reader] = fence;
+    m_fencedGenerations[reader] = m_acquiredGenerations[reader];
+    m_frameFenced.notify_all();
+}
+
+void FrameSnapshotBuffer::waitForDrawnFrames()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    //a frame still being drawn has no fence yet, and the commands it has not submitted cannot be waited for otherwise
+    for(int reader = 0; reader < readerCount(); reader++){
+        while(isDrawing(reader) && !m_stopping){
+            m_frameFenced.wait(lock);
+        }
+    }
+    for(GLsync fence : m_drawnFences){
+        if(fence != 0){
+            glWaitSync(fence, 0, GL_TIMEOUT_IGNORED);
+        }
+    }
+}
+
+bool FrameSnapshotBuffer::isDrawing(int reader) const
+{
+    return m_drawing[reader] != NULL && m_fencedGenerations[reader] != m_acquiredGenerations[reader];
+}
@@ -0,0 +1,213 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#ifndef FRAMESNAPSHOT_H
+#define FRAMESNAPSHOT_H
+
+#include <GL/gl.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+#include <stdint.h>
+
+namespace motorcar {
+class Display;
+class OpenGLContext;
+class ViewPoint;
+
+///Copy of the state of a viewpoint for one frame
+struct ViewpointSnapshot
+{
+    ViewpointSnapshot(ViewPoint *viewpoint);
+
+    ///identifies the viewpoint, must not be dereferenced while drawing
+    const ViewPoint *viewpoint;
+    glm::mat4 viewMatrix, projectionMatrix;
+    ///pixel rectangle (x, y, width, height) of the viewport in its display's scene target
+    glm::vec4 viewport;
+    ///normalized viewport rectangles as returned by ViewPort::viewportParams
+    glm::vec4 viewportParams, clientColorViewportParams, clientDepthViewportParams;
+    glm::vec4 centerOfFocus;
+    ///view space transform the display applied to the view matrix right before drawing, identity if it did not late latch
+    /*viewMatrix already includes it, items which reuse something computed for the view matrix the frame was
+     * snapshotted with can correct it by this*/
+    glm::mat4 lateLatchCorrection;
+    bool lateLatched;
+
+    ///calls glViewport with the viewport
+    void setViewport() const;
+};
+
+///Copy of the state of a display for one frame
+struct DisplaySnapshot
+{
+    DisplaySnapshot(Display *display);
+
+    ///the display drawing this snapshot, only its render pass methods may be called while drawing
+    Display *display;
+    ///the context the display is drawn in, displays of different contexts may be drawn concurrently
+    const OpenGLContext *context;
+    ///resolution of the display's scene target and of the framebuffer it is presented in
+    glm::ivec2 size, framebufferSize;
+    std::vector<ViewpointSnapshot> viewpoints;
+
+    ///whether the display's viewpoints follow a tracker whose orientation the display can sample again while drawing
+    bool tracked;
+    ///world transform of the tracker when the frame was snapshotted, and its orientation relative to its parent
+    glm::mat4 trackerTransform;
+    glm::quat trackerOrientation;
+
+    ///returns the snapshot of the given viewpoint of this display, NULL if it has none
+    const ViewpointSnapshot *viewpoint(const ViewPoint *viewpoint) const;
+};
+
+///Something to draw in a frame, holding copies of everything it needs from the scenegraph
+/*Items are created by drawables while the scene is snapshotted on the main thread and drawn later,
+ * possibly on another thread while the scenegraph is already being changed for the next frame. They
+ * must therefore not reference nodes or anything else the main thread may change or delete: state is
+ * copied into the item, and GL objects which belong to a node are held through a shared pointer so
+ * they stay alive for as long as a frame in flight needs them*/
+class RenderItem
+{
+public:
+    virtual ~RenderItem() {}
+
+    ///draws the item for every viewpoint of the display into the display's scene target
+    /*called with the drawing context current and the scene target bound, once for every display of the frame.
+     * If the framebuffer needs to be unbound the item must rebind the display's active framebuffer before
+     * drawing into it again*/
+    virtual void draw(const DisplaySnapshot &display) = 0;
+};
+
+///Immutable copy of the scene taken once per frame, which is all that is needed to draw the frame
+class FrameSnapshot
+{
+public:
+    FrameSnapshot();
+    ~FrameSnapshot();
+
+    ///deletes the items and fence of the previous frame so the snapshot can be filled again
+    void clear();
+
+    ///draws every item for the given display, in the order they were snapshotted
+    void drawItems(const DisplaySnapshot &display) const;
+
+    ///returns the snapshot of the given display, NULL if it is not part of this frame
+    const DisplaySnapshot *display(const Display *display) const;
+
+    long timestampMillis;
+    ///the Scene::frameSequence() of the frame the snapshot was taken for
+    uint32_t sequence;
+    ///the Scene::predictedPresentationNanos() of the frame
+    uint64_t predictedPresentationNanos;
+    std::vector<DisplaySnapshot> displays;
+    ///owned by the snapshot
+    std::vector<RenderItem *> items;
+    ///signalled once the GL work the main thread did preparing this frame (uploads, copies) has completed
+    GLsync readyFence;
+
+private:
+    FrameSnapshot(const FrameSnapshot &);
+    FrameSnapshot &operator=(const FrameSnapshot &);
+};
+
+///Hands snapshots from the thread taking them to the threads drawing them
+/*Every published snapshot is drawn by each of a fixed number of readers, one per drawing thread. Besides the
+ * one being filled and the most recently published one, every reader holds on to the snapshot it draws, so
+ * two more snapshots than readers are cycled. Publishing never blocks, a published snapshot which a reader has
+ * not picked up by the time the next one is published is simply skipped by it, so every reader always draws the
+ * newest frame. Snapshots are numbered by generation, the first one published being generation 1.
+ *
+ * The only time the taking thread waits for a reader is before overwriting a texture in place, which has to
+ * wait until the frame the reader is drawing has been submitted, as there is nothing to fence before that*/
+class FrameSnapshotBuffer
+{
+public:
+    FrameSnapshotBuffer(int readerCount = 1);
+    ~FrameSnapshotBuffer();
+
+    int readerCount() const;
+
+    ///returns the snapshot to fill for the next frame, owned by the taking thread until publish()
+    /*it is not held by any reader, so the items of the frame it was last used for can be deleted*/
+    FrameSnapshot *writeSnapshot();
+    ///makes the snapshot returned by writeSnapshot() the newest one
+    void publish();
+    ///returns the generation the snapshot returned by writeSnapshot() will be published as
+    unsigned long writeGeneration();
+    ///returns the oldest generation a reader may still sample textures for, now or once it acquires its next snapshot
+    /*resources the taking thread stopped using while filling a generation at most this one are no longer read
+     * by any frame, and may be reused or deleted*/
+    unsigned long oldestGenerationInUse();
+
+    ///returns the newest published snapshot, blocking until there is one the reader did not acquire before
+    /*the snapshot returned by the reader's previous call is given back, returns NULL once stop() has been called*/
+    FrameSnapshot *acquire(int reader);
+    ///wakes up and ends any acquire()
+    void stop();
+
+    ///sets the fence signalled once the reader's most recently acquired snapshot has been drawn, called by the drawing thread
+    void setDrawnFence(int reader, GLsync fence);
+    ///makes the current context wait for every frame any reader has acquired so far before executing further commands
+    /*must be called by the taking thread before it overwrites a texture frames in flight might sample. Blocks until
+     * the frames readers are still drawing have been submitted*/
+    void waitForDrawnFrames();
+
+private:
+    std::vector<FrameSnapshot *> m_snapshots;
+    FrameSnapshot *m_writing, *m_published;
+    unsigned long m_publishedGeneration;
+    bool m_stopping;
+
+    //indexed by reader
+    std::vector<FrameSnapshot *> m_drawing;
+    std::vector<unsigned long> m_acquiredGenerations;
+    std::vector<GLsync> m_drawnFences;
+    //the generation each reader's drawn fence was set for, the reader is drawing while it lags the acquired one
+    std::vector<unsigned long> m_fencedGenerations;
+
+    std::mutex m_mutex;
+    std::condition_variable m_snapshotPublished, m_frameFenced;
+
+    bool isDrawing(int reader) const;
+
+    FrameSnapshotBuffer(const FrameSnapshotBuffer &);
+    FrameSnapshotBuffer &operator=(const FrameSnapshotBuffer &);
+};
+}
+
+#endif // FRAMESNAPSHOT_H
@@ -43,6 +43,7 @@
 
 #include <scenegraph/output/display/display.h>
 #include <scenegraph/output/display/rendertotexturedisplay.h>
+#include <scenegraph/output/display/mirrordisplay.h>
 
 #include <scenegraph/output/wayland/waylandsurfacenode.h>
 
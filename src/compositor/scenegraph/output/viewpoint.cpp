@@ -36,6 +36,7 @@
 #include <scenegraph/output/display/display.h>
 #include <scenegraph/scene.h>
 #include <compositor.h>
+#include <windowmanager.h>
 
 
 
@@ -214,7 +215,9 @@ void ViewPoint::sendViewMatrixToClients()
     std::memcpy(m_viewArray.data, glm::value_ptr(this->viewMatrix()), m_viewArray.size);
 
     for(struct wl_resource *resource : m_resources){
-        motorcar_viewpoint_send_view_matrix(resource, &m_viewArray);
+        if(!receivesFrameState(resource)){
+            motorcar_viewpoint_send_view_matrix(resource, &m_viewArray);
+        }
     }
     //
 }
@@ -223,7 +226,9 @@ void ViewPoint::sendProjectionMatrixToClients()
 {
     std::memcpy(m_projectionArray.data, glm::value_ptr(this->projectionMatrix()), m_projectionArray.size);
     for(struct wl_resource *resource : m_resources){
-        motorcar_viewpoint_send_projection_matrix(resource, &m_projectionArray);
+        if(!receivesFrameState(resource)){
+            motorcar_viewpoint_send_projection_matrix(resource, &m_projectionArray);
+        }
     }
 
 }
@@ -231,6 +236,9 @@ void ViewPoint::sendProjectionMatrixToClients()
 void ViewPoint::sendViewPortToClients()
 {
     for(struct wl_resource *resource : m_resources){
+        if(receivesFrameState(resource)){
+            continue;
+        }
         motorcar_viewpoint_send_view_port(resource,
                                           m_clientColorViewport->offsetX(), m_clientColorViewport->offsetY(),
                                           m_clientColorViewport->width(), m_clientColorViewport->height(),
@@ -250,6 +258,22 @@ void ViewPoint::sendCurrentStateToSingleClient(wl_resource *resource)
                                        m_clientDepthViewport->width(), m_clientDepthViewport->height());
 }
 
+bool ViewPoint::receivesFrameState(wl_resource *resource)
+{
+    WindowManager *windowManager = scene()->windowManager();
+    return windowManager != NULL && windowManager->shell()->sendsFrameState(wl_resource_get_client(resource));
+}
+
+wl_resource *ViewPoint::resourceForClient(wl_client *client) const
+{
+    for(struct wl_resource *resource : m_resources){
+        if(wl_resource_get_client(resource) == client){
+            return resource;
+        }
+    }
+    return NULL;
+}
+
 
 wl_global *ViewPoint::global() const
 {
@@ -86,6 +86,8 @@ public:
     void sendProjectionMatrixToClients();
     void sendViewPortToClients();
     void sendCurrentStateToSingleClient(wl_resource *resource);
+    ///returns the resource through which the given client bound this viewpoint, or NULL if it has not
+    wl_resource *resourceForClient(wl_client *client) const;
 
     wl_global *global() const;
     void setGlobal(wl_global *global);
@@ -123,6 +125,9 @@ private:
     struct wl_global *m_global;
     std::vector<struct wl_resource*> m_resources;
 
+    ///returns whether the resource's client gets this viewpoint's state through motorcar_shell.frame_state instead
+    bool receivesFrameState(struct wl_resource *resource);
+
     static void destroy_func(struct wl_resource *resource);
 
     static void bind_func(struct wl_client *client, void *data,
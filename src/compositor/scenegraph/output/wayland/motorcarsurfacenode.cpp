@@ -35,19 +35,29 @@
 #include <scenegraph/output/wayland/motorcarsurfacenode.h>
 #include <scenegraph/output/display/display.h>
 #include <scenegraph/output/wireframenode.h>
+#include <scenegraph/scene.h>
+#include <wayland/output/presentationfeedback.h>
+#include <windowmanager.h>
 
 using namespace motorcar;
 
-MotorcarSurfaceNode::MotorcarSurfaceNode(WaylandSurface *surface, SceneGraphNode *parent, const glm::mat4 &transform, glm::vec3 dimensions)
-    :m_resource (NULL)
-    ,WaylandSurfaceNode(surface, parent, transform)
-    ,m_depthCompositedSurfaceShader(new motorcar::OpenGLShader(std::string("depthcompositedsurface.vert"), std::string("depthcompositedsurface.frag")))
-    ,m_depthCompositedSurfaceBlitter(new motorcar::OpenGLShader(std::string("depthcompositedsurfaceblitter.vert"), std::string("depthcompositedsurfaceblitter.frag")))
-    ,m_clippingShader(new motorcar::OpenGLShader(std::string("motorcarline.vert"), std::string("motorcarline.frag")))
-    ,m_dimensions(dimensions)
+//bounds are grown by this many pixels so that head motion between the client's frame and ours stays covered,
+//and are aligned to a coarse grid so they do not change, and have to be resent, for every small movement
+static const int VIEWPOINT_BOUNDS_MARGIN = 16;
+static const int VIEWPOINT_BOUNDS_ALIGNMENT = 32;
+//number of unacknowledged bounds kept around for clients which lag behind
+static const size_t MAX_SENT_VIEWPOINT_BOUNDS = 16;
+//spacing in pixels of the vertices displaced by client depth when reprojecting stale frames
+static const int REPROJECTION_GRID_SPACING = 8;
+//neighbouring grid vertices whose distances from the viewpoint differ by more than this factor belong to different surfaces
+static const float REPROJECTION_MAX_DEPTH_RATIO = 1.25f;
+
+MotorcarSurfaceNode::CompositingResources::CompositingResources()
+    :depthCompositedSurfaceShader(new motorcar::OpenGLShader(std::string("depthcompositedsurface.vert"), std::string("depthcompositedsurface.frag")))
+    ,depthCompositedSurfaceBlitter(new motorcar::OpenGLShader(std::string("depthcompositedsurfaceblitter.vert"), std::string("depthcompositedsurfaceblitter.frag")))
+    ,clippingShader(new motorcar::OpenGLShader(std::string("motorcarline.vert"), std::string("motorcarline.frag")))
+    ,reprojectionShader(new motorcar::OpenGLShader(std::string("depthcompositedsurfacereprojection.vert"), std::string("depthcompositedsurfacereprojection.frag")))
 {
-
-    std::cout << "creating MotorcarSurfaceNode" <<std::endl;
     const GLfloat vertexCoordinates[] ={
        -1.0f, -1.0f, 0.0f,
         1.0f, -1.0f, 0.0f,
@@ -57,30 +67,36 @@ MotorcarSurfaceNode::MotorcarSurfaceNode(WaylandSurface *surface, SceneGraphNode
 
 
 
-    glGenBuffers(1, &m_colorTextureCoordinates);
-    glGenBuffers(1, &m_depthTextureCoordinates);
+    glGenBuffers(1, &colorTextureCoordinates);
+    glGenBuffers(1, &depthTextureCoordinates);
 //    glBindBuffer(GL_ARRAY_BUFFER, m_surfaceTextureCoordinates);
 //    glBufferData(GL_ARRAY_BUFFER, 8 * sizeof(float), textureCoordinates, GL_STATIC_DRAW);
 
-    glGenBuffers(1, &m_surfaceVertexCoordinates);
-    glBindBuffer(GL_ARRAY_BUFFER, m_surfaceVertexCoordinates);
+    glGenBuffers(1, &surfaceVertexCoordinates);
+    glBindBuffer(GL_ARRAY_BUFFER, surfaceVertexCoordinates);
     glBufferData(GL_ARRAY_BUFFER, 12 * sizeof(float), vertexCoordinates, GL_STATIC_DRAW);
 
 
 
-    h_aPosition_depthcomposite =  glGetAttribLocation(m_depthCompositedSurfaceShader->handle(), "aPosition");
-    h_aColorTexCoord_depthcomposite =  glGetAttribLocation(m_depthCompositedSurfaceShader->handle(), "aColorTexCoord");
-    h_aDepthTexCoord_depthcomposite =  glGetAttribLocation(m_depthCompositedSurfaceShader->handle(), "aDepthTexCoord");
+    h_aPosition_depthcomposite =  glGetAttribLocation(depthCompositedSurfaceShader->handle(), "aPosition");
+    h_aColorTexCoord_depthcomposite =  glGetAttribLocation(depthCompositedSurfaceShader->handle(), "aColorTexCoord");
+    h_aDepthTexCoord_depthcomposite =  glGetAttribLocation(depthCompositedSurfaceShader->handle(), "aDepthTexCoord");
+    h_uDepthSource_depthcomposite =  glGetUniformLocation(depthCompositedSurfaceShader->handle(), "uDepthSource");
 
-    if(h_aPosition_depthcomposite < 0 || h_aColorTexCoord_depthcomposite < 0 || h_aDepthTexCoord_depthcomposite < 0 ){
-       std::cout << "problem with depth compositing shader handles: " << h_aPosition_depthcomposite << ", "<< h_aColorTexCoord_depthcomposite << ", " << h_aDepthTexCoord_depthcomposite << std::endl;
+    if(h_aPosition_depthcomposite < 0 || h_aColorTexCoord_depthcomposite < 0 || h_aDepthTexCoord_depthcomposite < 0 || h_uDepthSource_depthcomposite < 0){
+       std::cout << "problem with depth compositing shader handles: " << h_aPosition_depthcomposite << ", "<< h_aColorTexCoord_depthcomposite << ", " << h_aDepthTexCoord_depthcomposite << ", " << h_uDepthSource_depthcomposite << std::endl;
     }
 
+    glUseProgram(depthCompositedSurfaceShader->handle());
+    glUniform1i(glGetUniformLocation(depthCompositedSurfaceShader->handle(), "uTexSampler"), 0);
+    glUniform1i(glGetUniformLocation(depthCompositedSurfaceShader->handle(), "uDepthSampler"), 1);
+    glUseProgram(0);
+
 
-    h_aPosition_blit =  glGetAttribLocation(m_depthCompositedSurfaceBlitter->handle(), "aPosition");
-    h_aTexCoord_blit =  glGetAttribLocation(m_depthCompositedSurfaceBlitter->handle(), "aTexCoord");
-    h_uColorSampler_blit = glGetUniformLocation(m_depthCompositedSurfaceBlitter->handle(), "uColorSampler");
-    h_uDepthSampler_blit = glGetUniformLocation(m_depthCompositedSurfaceBlitter->handle(), "uDepthSampler");
+    h_aPosition_blit =  glGetAttribLocation(depthCompositedSurfaceBlitter->handle(), "aPosition");
+    h_aTexCoord_blit =  glGetAttribLocation(depthCompositedSurfaceBlitter->handle(), "aTexCoord");
+    h_uColorSampler_blit = glGetUniformLocation(depthCompositedSurfaceBlitter->handle(), "uColorSampler");
+    h_uDepthSampler_blit = glGetUniformLocation(depthCompositedSurfaceBlitter->handle(), "uDepthSampler");
 
     if(h_aPosition_blit < 0 || h_aTexCoord_blit < 0 || h_uColorSampler_blit < 0 || h_uDepthSampler_blit < 0 ){
        std::cout << "problem with depth blitting shader handles: " <<
@@ -88,23 +104,46 @@ MotorcarSurfaceNode::MotorcarSurfaceNode(WaylandSurface *surface, SceneGraphNode
     }
 
 
-    glUseProgram(m_depthCompositedSurfaceBlitter->handle());
+    glUseProgram(depthCompositedSurfaceBlitter->handle());
 
     glUniform1i(h_uColorSampler_blit, 0); //Texture unit 0 is for color maps.
     glUniform1i(h_uDepthSampler_blit, 1); //Texture unit 1 is for depth maps.
 
     glUseProgram(0);
 
-    h_aPosition_clipping =  glGetAttribLocation(m_clippingShader->handle(), "aPosition");
-    h_uColor_clipping =  glGetUniformLocation(m_clippingShader->handle(), "uColor");
-    h_uMVPMatrix_clipping  = glGetUniformLocation(m_clippingShader->handle(), "uMVPMatrix");
+    h_aPosition_clipping =  glGetAttribLocation(clippingShader->handle(), "aPosition");
+    h_uColor_clipping =  glGetUniformLocation(clippingShader->handle(), "uColor");
+    h_uMVPMatrix_clipping  = glGetUniformLocation(clippingShader->handle(), "uMVPMatrix");
 
     if(h_aPosition_clipping < 0 || h_uColor_clipping < 0 || h_uMVPMatrix_clipping < 0 ){
          std::cout << "problem with clipping shader handles: " << h_aPosition_clipping << ", "<< h_uColor_clipping << ", " << h_uMVPMatrix_clipping << std::endl;
     }
 
 
-    const GLfloat cuboidClippingVerts[8][3]= {
+    h_aGridCoord_reprojection = glGetAttribLocation(reprojectionShader->handle(), "aGridCoord");
+    h_uDepthSource_reprojection = glGetUniformLocation(reprojectionShader->handle(), "uDepthSource");
+    h_uColorViewport_reprojection = glGetUniformLocation(reprojectionShader->handle(), "uColorViewport");
+    h_uDepthViewport_reprojection = glGetUniformLocation(reprojectionShader->handle(), "uDepthViewport");
+    h_uReprojectionMatrix_reprojection = glGetUniformLocation(reprojectionShader->handle(), "uReprojectionMatrix");
+    h_uValidRegion_reprojection = glGetUniformLocation(reprojectionShader->handle(), "uValidRegion");
+    h_uGridStep_reprojection = glGetUniformLocation(reprojectionShader->handle(), "uGridStep");
+
+    if(h_aGridCoord_reprojection < 0 || h_uDepthSource_reprojection < 0 || h_uColorViewport_reprojection < 0 ||
+            h_uDepthViewport_reprojection < 0 || h_uReprojectionMatrix_reprojection < 0 || h_uValidRegion_reprojection < 0 ||
+            h_uGridStep_reprojection < 0){
+         std::cout << "problem with reprojection shader handles: " << h_aGridCoord_reprojection << ", " << h_uDepthSource_reprojection << ", "
+                   << h_uColorViewport_reprojection << ", " << h_uDepthViewport_reprojection << ", "
+                   << h_uReprojectionMatrix_reprojection << ", " << h_uValidRegion_reprojection << ", " << h_uGridStep_reprojection << std::endl;
+    }
+
+    glUseProgram(reprojectionShader->handle());
+    glUniform1i(glGetUniformLocation(reprojectionShader->handle(), "uTexSampler"), 0);
+    glUniform1i(glGetUniformLocation(reprojectionShader->handle(), "uDepthSampler"), 1);
+    glUniform1f(glGetUniformLocation(reprojectionShader->handle(), "uMaxDepthRatio"), REPROJECTION_MAX_DEPTH_RATIO);
+    glUseProgram(0);
+
+
+    const GLfloat cuboidVertices[8][3]= {
         { 0.5, 0.5 , 0.5},
         { 0.5, 0.5 , -0.5},
         { 0.5, -0.5 , 0.5},
@@ -115,7 +154,7 @@ MotorcarSurfaceNode::MotorcarSurfaceNode(WaylandSurface *surface, SceneGraphNode
         { -0.5, -0.5 , -0.5}
     };
 
-    const GLuint cuboidClippingIndices[12][3] = {
+    const GLuint cuboidIndices[12][3] = {
         { 0, 2, 1 },
         { 1, 2, 3 },
         { 4, 5, 6 },
@@ -130,15 +169,97 @@ MotorcarSurfaceNode::MotorcarSurfaceNode(WaylandSurface *surface, SceneGraphNode
         { 3, 7, 5 }
     };
 
-    glGenBuffers(1, &m_cuboidClippingVertices);
-    glBindBuffer(GL_ARRAY_BUFFER, m_cuboidClippingVertices);
-    glBufferData(GL_ARRAY_BUFFER, 8 * 3 * sizeof(float), cuboidClippingVerts, GL_STATIC_DRAW);
+    glGenBuffers(1, &cuboidClippingVertices);
+    glBindBuffer(GL_ARRAY_BUFFER, cuboidClippingVertices);
+    glBufferData(GL_ARRAY_BUFFER, 8 * 3 * sizeof(float), cuboidVertices, GL_STATIC_DRAW);
+
+
+    glGenBuffers(1, &cuboidClippingIndices);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cuboidClippingIndices);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, 12 * 3 * sizeof(unsigned int), cuboidIndices, GL_STATIC_DRAW);
+}
+
+MotorcarSurfaceNode::CompositingResources::~CompositingResources()
+{
+    glDeleteBuffers(1, &colorTextureCoordinates);
+    glDeleteBuffers(1, &depthTextureCoordinates);
+    glDeleteBuffers(1, &surfaceVertexCoordinates);
+    glDeleteBuffers(1, &cuboidClippingVertices);
+    glDeleteBuffers(1, &cuboidClippingIndices);
+    for(std::map<std::pair<int, int>, ReprojectionGrid>::value_type &grid : reprojectionGrids){
+        glDeleteBuffers(1, &grid.second.vertices);
+        glDeleteBuffers(1, &grid.second.indices);
+    }
+    delete depthCompositedSurfaceShader;
+    delete depthCompositedSurfaceBlitter;
+    delete clippingShader;
+    delete reprojectionShader;
+}
 
 
-    glGenBuffers(1, &m_cuboidClippingIndices);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_cuboidClippingIndices);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, 12 * 3 * sizeof(unsigned int), cuboidClippingIndices, GL_STATIC_DRAW);
 
+MotorcarSurfaceNode::CompositingResources::ReprojectionGrid MotorcarSurfaceNode::CompositingResources::reprojectionGrid(glm::ivec2 viewportSize)
+{
+    glm::ivec2 gridSize = glm::max((viewportSize + REPROJECTION_GRID_SPACING - 1) / REPROJECTION_GRID_SPACING, glm::ivec2(1));
+    std::pair<int, int> key(gridSize.x, gridSize.y);
+    std::map<std::pair<int, int>, ReprojectionGrid>::iterator existing = reprojectionGrids.find(key);
+    if(existing != reprojectionGrids.end()){
+        return existing->second;
+    }
+
+    std::vector<GLfloat> vertices;
+    vertices.reserve((gridSize.x + 1) * (gridSize.y + 1) * 2);
+    for(int y = 0; y <= gridSize.y; y++){
+        for(int x = 0; x <= gridSize.x; x++){
+            vertices.push_back((float) x / gridSize.x);
+            vertices.push_back((float) y / gridSize.y);
+        }
+    }
+
+    std::vector<GLuint> indices;
+    indices.reserve(gridSize.x * gridSize.y * 6);
+    for(int y = 0; y < gridSize.y; y++){
+        for(int x = 0; x < gridSize.x; x++){
+            GLuint corner = y * (gridSize.x + 1) + x;
+            GLuint above = corner + gridSize.x + 1;
+            indices.push_back(corner);
+            indices.push_back(corner + 1);
+            indices.push_back(above + 1);
+            indices.push_back(corner);
+            indices.push_back(above + 1);
+            indices.push_back(above);
+        }
+    }
+
+    ReprojectionGrid grid;
+    glGenBuffers(1, &grid.vertices);
+    glGenBuffers(1, &grid.indices);
+    glBindBuffer(GL_ARRAY_BUFFER, grid.vertices);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), &vertices[0], GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, grid.indices);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), &indices[0], GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    grid.indexCount = indices.size();
+    grid.size = gridSize;
+
+    reprojectionGrids[key] = grid;
+    return grid;
+}
+
+
+
+MotorcarSurfaceNode::MotorcarSurfaceNode(WaylandSurface *surface, SceneGraphNode *parent, const glm::mat4 &transform, glm::vec3 dimensions)
+    :m_resource (NULL)
+    ,WaylandSurfaceNode(surface, parent, transform)
+    ,m_compositingResources(std::make_shared<CompositingResources>())
+    ,m_dimensions(dimensions)
+    ,m_boundsSerial(0)
+    ,m_boundsAcked(false)
+    ,m_contentMatricesSerial(0)
+{
+
+    std::cout << "creating MotorcarSurfaceNode" <<std::endl;
 
     wl_array_init(&m_dimensionsArray);
     wl_array_init(&m_transformArray);
@@ -146,12 +267,26 @@ MotorcarSurfaceNode::MotorcarSurfaceNode(WaylandSurface *surface, SceneGraphNode
     wl_array_add(&m_dimensionsArray, sizeof(glm::vec3));
     wl_array_add(&m_transformArray, sizeof(glm::mat4));
 
+    wl_array_init(&m_boundsProjectionArray);
+    wl_array_add(&m_boundsProjectionArray, sizeof(glm::mat4));
+
     m_decorationsNode->setTransform(glm::scale(glm::mat4(), m_dimensions));
 
 
 
 }
 
+MotorcarSurfaceNode::~MotorcarSurfaceNode()
+{
+    for(PresentationFeedback *feedback : m_pendingFeedback){
+        delete feedback;
+    }
+    WindowManager *windowManager = scene() != NULL ? scene()->windowManager() : NULL;
+    if(windowManager != NULL){
+        windowManager->shell()->discardPresentationFeedback(this);
+    }
+}
+
 bool MotorcarSurfaceNode::computeLocalSurfaceIntersection(const Geometry::Ray &localRay, glm::vec2 &localIntersection, float &t)
 {
 
@@ -165,53 +300,123 @@ bool MotorcarSurfaceNode::computeLocalSurfaceIntersection(const Geometry::Ray &l
 
 
 
-void MotorcarSurfaceNode::drawFrameBufferContents(Display *display)
+///composites the client's buffer with the state the surface had at the time of the snapshot
+class MotorcarSurfaceNode::Item : public RenderItem
+{
+public:
+    Item(MotorcarSurfaceNode *node, Scene *scene);
+
+    virtual void draw(const DisplaySnapshot &display) override;
+
+private:
+    struct ViewpointState{
+        //bounds the client's buffer was drawn with, the full viewport is used if the client acknowledged none
+        bool hasBounds;
+        glm::ivec4 bounds;
+        //warps a buffer drawn for an older viewpoint state to the viewpoint's state in this frame
+        bool reproject;
+        glm::mat4 reprojection;
+        CompositingResources::ReprojectionGrid reprojectionGrid;
+    };
+
+    std::shared_ptr<WaylandSurfaceNode::Resources> m_surfaceResources;
+    std::shared_ptr<MotorcarSurfaceNode::CompositingResources> m_resources;
+
+    //world transform scaled to the window's dimensions
+    glm::mat4 m_modelMatrix;
+    GLuint m_texture, m_depthTexture, m_planeTextures[3];
+    WaylandSurface::TextureFormat m_format;
+    WaylandSurface::ClippingMode m_clippingMode;
+    bool m_depthCompositingEnabled;
+    std::map<const ViewPoint *, ViewpointState> m_viewpointStates;
+
+    void drawFrameBufferContents(const DisplaySnapshot &display);
+    void drawWindowBoundsStencil(const DisplaySnapshot &display);
+    void clipWindowBounds(const DisplaySnapshot &display);
+    ///draws the client's buffer for the viewpoint as a grid warped to the current viewpoint by the buffer's depth
+    void drawReprojected(const ViewpointState &state, glm::vec4 colorViewport, glm::vec4 depthViewport,
+                         glm::vec4 validRegion, bool separateDepth);
+};
+
+MotorcarSurfaceNode::Item::Item(MotorcarSurfaceNode *node, Scene *scene)
+    :m_surfaceResources(node->m_resources)
+    ,m_resources(node->m_compositingResources)
+    ,m_modelMatrix(node->worldTransform() * glm::scale(glm::mat4(), node->dimensions()))
+    ,m_texture(node->surface()->texture())
+    ,m_depthTexture(node->m_depthBuffer.texture())
+    ,m_format(node->surface()->textureFormat())
+    ,m_clippingMode(node->surface()->clippingMode())
+    ,m_depthCompositingEnabled(node->surface()->depthCompositingEnabled())
+{
+    m_planeTextures[0] = m_texture;
+    m_planeTextures[1] = node->surface()->planeTexture(1);
+    m_planeTextures[2] = node->surface()->planeTexture(2);
+    for(Display *display : scene->displays()){
+        for(ViewPoint *viewpoint : display->viewpoints()){
+            ViewpointState state;
+            ViewpointBounds::const_iterator bounds = node->m_ackedBounds.find(viewpoint);
+            state.hasBounds = node->m_boundsAcked && bounds != node->m_ackedBounds.end();
+            if(state.hasBounds){
+                state.bounds = bounds->second;
+            }
+            state.reproject = node->computeReprojectionMatrix(viewpoint, &state.reprojection);
+            //displays late latching their view matrices need the grid to warp the buffer by the correction as well
+            if(m_depthCompositingEnabled){
+                state.reprojectionGrid = m_resources->reprojectionGrid(glm::ivec2(viewpoint->viewport()->width(), viewpoint->viewport()->height()));
+            }
+            m_viewpointStates[viewpoint] = state;
+        }
+    }
+}
+
+void MotorcarSurfaceNode::Item::drawFrameBufferContents(const DisplaySnapshot &display)
 {
+    CompositingResources &r = *m_resources;
 
     glDepthFunc(GL_LEQUAL);
     glEnable(GL_DEPTH_TEST);
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, display->activeFrameBuffer());
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, display.display->activeFrameBuffer());
 
-    glBindFramebuffer(GL_READ_FRAMEBUFFER, display->scratchFrameBuffer());
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, display.display->scratchFrameBuffer());
 
     glStencilMask(0xFF);
 
 
 
-    glm::ivec2 res = display->size();
+    glm::ivec2 res = display.size;
     glBlitFramebuffer(0, 0, res.x - 1, res.y - 1, 0, 0, res.x - 1 , res.y - 1, GL_STENCIL_BUFFER_BIT, GL_NEAREST);
 
     glStencilMask(0x00);
     glStencilFunc(GL_EQUAL, 1, 0xFF);
 
-    glUseProgram(m_depthCompositedSurfaceBlitter->handle());
+    glUseProgram(r.depthCompositedSurfaceBlitter->handle());
 
     glActiveTexture(GL_TEXTURE0);
     glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, display->scratchColorBufferTexture());
+    glBindTexture(GL_TEXTURE_2D, display.display->scratchColorBufferTexture());
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
     glActiveTexture(GL_TEXTURE1);
     glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, display->scratchDepthBufferTexture());
+    glBindTexture(GL_TEXTURE_2D, display.display->scratchDepthBufferTexture());
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
-    glEnableVertexAttribArray(h_aPosition_blit);
-    glBindBuffer(GL_ARRAY_BUFFER, m_surfaceVertexCoordinates);
-    glVertexAttribPointer(h_aPosition_blit, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    glEnableVertexAttribArray(r.h_aPosition_blit);
+    glBindBuffer(GL_ARRAY_BUFFER, r.surfaceVertexCoordinates);
+    glVertexAttribPointer(r.h_aPosition_blit, 3, GL_FLOAT, GL_FALSE, 0, 0);
 
-    glEnableVertexAttribArray(h_aTexCoord_blit);
+    glEnableVertexAttribArray(r.h_aTexCoord_blit);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 
 
 
-    for(ViewPoint *viewpoint : display->viewpoints()){
+    for(const ViewpointSnapshot &viewpoint : display.viewpoints){
 
-        viewpoint->viewport()->set();
+        viewpoint.setViewport();
 
-        glm::vec4 vp = viewpoint->viewport()->viewportParams();
+        glm::vec4 vp = viewpoint.viewportParams;
 
         const GLfloat textureBlitCoordinates[] = {
             vp.x, vp.y,
@@ -221,7 +426,7 @@ void MotorcarSurfaceNode::drawFrameBufferContents(Display *display)
         };
 
 
-        glVertexAttribPointer(h_aTexCoord_blit, 2, GL_FLOAT, GL_FALSE, 0, textureBlitCoordinates);
+        glVertexAttribPointer(r.h_aTexCoord_blit, 2, GL_FLOAT, GL_FALSE, 0, textureBlitCoordinates);
 
 
         glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
@@ -230,8 +435,9 @@ void MotorcarSurfaceNode::drawFrameBufferContents(Display *display)
 
 }
 
-void MotorcarSurfaceNode::drawWindowBoundsStencil(Display *display)
+void MotorcarSurfaceNode::Item::drawWindowBoundsStencil(const DisplaySnapshot &display)
 {
+    CompositingResources &r = *m_resources;
     glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
     glDepthMask(GL_FALSE);
     glStencilFunc(GL_NEVER, 1, 0xFF);
@@ -239,29 +445,27 @@ void MotorcarSurfaceNode::drawWindowBoundsStencil(Display *display)
 
 
 
-    glUseProgram(m_clippingShader->handle());
-
-    glEnableVertexAttribArray(h_aPosition_clipping);
-    glBindBuffer(GL_ARRAY_BUFFER, m_cuboidClippingVertices);
-    glVertexAttribPointer(h_aPosition_clipping, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    glUseProgram(r.clippingShader->handle());
 
-    glUniform3f(h_uColor_clipping, 1.f, 0.f, 0.f);
+    glEnableVertexAttribArray(r.h_aPosition_clipping);
+    glBindBuffer(GL_ARRAY_BUFFER, r.cuboidClippingVertices);
+    glVertexAttribPointer(r.h_aPosition_clipping, 3, GL_FLOAT, GL_FALSE, 0, 0);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_cuboidClippingIndices);
+    glUniform3f(r.h_uColor_clipping, 1.f, 0.f, 0.f);
 
-    glm::mat4 modelMatrix = this->worldTransform() * glm::scale(glm::mat4(), this->dimensions());
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, r.cuboidClippingIndices);
 
     int numElements = 36;
 
-    for(ViewPoint *viewpoint : display->viewpoints()){
-        viewpoint->viewport()->set();
+    for(const ViewpointSnapshot &viewpoint : display.viewpoints){
+        viewpoint.setViewport();
 
-        glm::mat4 mvp = viewpoint->projectionMatrix() * viewpoint->viewMatrix() * modelMatrix;
-        glUniformMatrix4fv(h_uMVPMatrix_clipping, 1, GL_FALSE, glm::value_ptr(mvp));
+        glm::mat4 mvp = viewpoint.projectionMatrix * viewpoint.viewMatrix * m_modelMatrix;
+        glUniformMatrix4fv(r.h_uMVPMatrix_clipping, 1, GL_FALSE, glm::value_ptr(mvp));
         glDrawElements(GL_TRIANGLES, numElements,GL_UNSIGNED_INT, 0);
     }
 
-    glDisableVertexAttribArray(h_aPosition_clipping);
+    glDisableVertexAttribArray(r.h_aPosition_clipping);
 
     glUseProgram(0);
 
@@ -274,8 +478,9 @@ void MotorcarSurfaceNode::drawWindowBoundsStencil(Display *display)
     glStencilFunc(GL_EQUAL, 1, 0xFF);
 }
 
-void MotorcarSurfaceNode::clipWindowBounds(Display *display)
+void MotorcarSurfaceNode::Item::clipWindowBounds(const DisplaySnapshot &display)
 {
+    CompositingResources &r = *m_resources;
     glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
     glDepthMask(GL_FALSE);
     glStencilMask(0xFF);
@@ -284,36 +489,34 @@ void MotorcarSurfaceNode::clipWindowBounds(Display *display)
 
 
 
-    glUseProgram(m_clippingShader->handle());
+    glUseProgram(r.clippingShader->handle());
 
-    glEnableVertexAttribArray(h_aPosition_clipping);
-    glBindBuffer(GL_ARRAY_BUFFER, m_cuboidClippingVertices);
-    glVertexAttribPointer(h_aPosition_clipping, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    glEnableVertexAttribArray(r.h_aPosition_clipping);
+    glBindBuffer(GL_ARRAY_BUFFER, r.cuboidClippingVertices);
+    glVertexAttribPointer(r.h_aPosition_clipping, 3, GL_FLOAT, GL_FALSE, 0, 0);
 
-    glUniform3f(h_uColor_clipping, 1.f, 0.f, 0.f);
+    glUniform3f(r.h_uColor_clipping, 1.f, 0.f, 0.f);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_cuboidClippingIndices);
-
-    glm::mat4 modelMatrix = this->worldTransform() * glm::scale(glm::mat4(), this->dimensions());
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, r.cuboidClippingIndices);
 
     int numElements = 36;
 
 
-    if(this->surface()->clippingMode() == WaylandSurface::ClippingMode::CUBOID && this->surface()->depthCompositingEnabled()){
+    if(m_clippingMode == WaylandSurface::ClippingMode::CUBOID && m_depthCompositingEnabled){
         glCullFace(GL_FRONT);
 
-        for(ViewPoint *viewpoint : display->viewpoints()){
-            viewpoint->viewport()->set();
+        for(const ViewpointSnapshot &viewpoint : display.viewpoints){
+            viewpoint.setViewport();
 
-            glm::mat4 mvp = viewpoint->projectionMatrix() * viewpoint->viewMatrix() * modelMatrix;
-            glUniformMatrix4fv(h_uMVPMatrix_clipping, 1, GL_FALSE, glm::value_ptr(mvp));
+            glm::mat4 mvp = viewpoint.projectionMatrix * viewpoint.viewMatrix * m_modelMatrix;
+            glUniformMatrix4fv(r.h_uMVPMatrix_clipping, 1, GL_FALSE, glm::value_ptr(mvp));
             glDrawElements(GL_TRIANGLES, numElements,GL_UNSIGNED_INT, 0);
         }
 
         glCullFace(GL_BACK);
     }
 
-    if(!this->surface()->depthCompositingEnabled()){
+    if(!m_depthCompositingEnabled){
         glDepthMask(GL_TRUE);
         glStencilMask(0x00);
     }else{
@@ -321,17 +524,17 @@ void MotorcarSurfaceNode::clipWindowBounds(Display *display)
     }
 
 
-    for(ViewPoint *viewpoint : display->viewpoints()){
-        viewpoint->viewport()->set();
+    for(const ViewpointSnapshot &viewpoint : display.viewpoints){
+        viewpoint.setViewport();
 
-        glm::mat4 mvp = viewpoint->projectionMatrix() * viewpoint->viewMatrix() * modelMatrix;
-        glUniformMatrix4fv(h_uMVPMatrix_clipping, 1, GL_FALSE, glm::value_ptr(mvp));
+        glm::mat4 mvp = viewpoint.projectionMatrix * viewpoint.viewMatrix * m_modelMatrix;
+        glUniformMatrix4fv(r.h_uMVPMatrix_clipping, 1, GL_FALSE, glm::value_ptr(mvp));
         glDrawElements(GL_TRIANGLES, numElements,GL_UNSIGNED_INT, 0);
     }
 
     glDepthFunc(GL_LESS);
 
-    glDisableVertexAttribArray(h_aPosition_clipping);
+    glDisableVertexAttribArray(r.h_aPosition_clipping);
 
     glUseProgram(0);
 
@@ -352,13 +555,15 @@ void MotorcarSurfaceNode::clipWindowBounds(Display *display)
 
 
 
-void MotorcarSurfaceNode::draw(Scene *scene, Display *display)
+void MotorcarSurfaceNode::Item::draw(const DisplaySnapshot &display)
 {
+    CompositingResources &r = *m_resources;
+    const WaylandSurfaceNode::Resources &surface = *m_surfaceResources;
 
     glEnable(GL_STENCIL_TEST);
     //glDisable(GL_STENCIL_TEST);
 
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, display->scratchFrameBuffer());
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, display.display->scratchFrameBuffer());
     glClearColor(0.0, 0.0, 0.0, 0.0);
     glClearDepth(1.0);
     glClearStencil(0);
@@ -366,30 +571,48 @@ void MotorcarSurfaceNode::draw(Scene *scene, Display *display)
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
 
-    this->drawWindowBoundsStencil(display);
+    drawWindowBoundsStencil(display);
 
-    if(surface()->depthCompositingEnabled()){
-        glUseProgram(m_depthCompositedSurfaceShader->handle());
+    //with a separate depth buffer the color buffer holds only the color viewports, laid out like the display's
+    bool separateDepth = m_depthCompositingEnabled && m_depthTexture != 0;
+    int planeCount = m_format == WaylandSurface::TextureFormat::YUV420 ? 3 : m_format == WaylandSurface::TextureFormat::NV12 ? 2 : 1;
 
-        glEnableVertexAttribArray(h_aPosition_depthcomposite);
-        glBindBuffer(GL_ARRAY_BUFFER, m_surfaceVertexCoordinates);
-        glVertexAttribPointer(h_aPosition_depthcomposite, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    if(m_depthCompositingEnabled){
+        glUseProgram(r.depthCompositedSurfaceShader->handle());
 
-        glEnableVertexAttribArray(h_aColorTexCoord_depthcomposite);
+        glEnableVertexAttribArray(r.h_aPosition_depthcomposite);
+        glBindBuffer(GL_ARRAY_BUFFER, r.surfaceVertexCoordinates);
+        glVertexAttribPointer(r.h_aPosition_depthcomposite, 3, GL_FLOAT, GL_FALSE, 0, 0);
+
+        glEnableVertexAttribArray(r.h_aColorTexCoord_depthcomposite);
         glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glEnableVertexAttribArray(h_aDepthTexCoord_depthcomposite);
+        glEnableVertexAttribArray(r.h_aDepthTexCoord_depthcomposite);
         glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        glUniform1i(r.h_uDepthSource_depthcomposite, separateDepth ? 1 : 0);
+        if(separateDepth){
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, m_depthTexture);
+            glActiveTexture(GL_TEXTURE0);
+        }
     }else{
-        glUseProgram(m_surfaceShader->handle());
+        glUseProgram(surface.surfaceShader->handle());
 
-        glEnableVertexAttribArray(h_aPosition_surface);
-        glBindBuffer(GL_ARRAY_BUFFER, m_surfaceVertexCoordinates);
-        glVertexAttribPointer(h_aPosition_surface, 3, GL_FLOAT, GL_FALSE, 0, 0);
+        glEnableVertexAttribArray(surface.h_aPosition_surface);
+        glBindBuffer(GL_ARRAY_BUFFER, r.surfaceVertexCoordinates);
+        glVertexAttribPointer(surface.h_aPosition_surface, 3, GL_FLOAT, GL_FALSE, 0, 0);
 
-        glEnableVertexAttribArray(h_aTexCoord_surface);
+        glEnableVertexAttribArray(surface.h_aTexCoord_surface);
         glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-        glUniformMatrix4fv(h_uMVPMatrix_surface, 1, GL_FALSE, glm::value_ptr(glm::mat4(1)));
+        glUniformMatrix4fv(surface.h_uMVPMatrix_surface, 1, GL_FALSE, glm::value_ptr(glm::mat4(1)));
+        glUniform1i(surface.h_uTextureFormat_surface, m_format);
+        //the chroma planes of a multi planar buffer are sampled from the units after the luma plane's
+        for(int plane = 1; plane < planeCount; plane++){
+            glActiveTexture(GL_TEXTURE0 + plane);
+            glBindTexture(GL_TEXTURE_2D, m_planeTextures[plane]);
+        }
+        glActiveTexture(GL_TEXTURE0);
 
         glDisable(GL_DEPTH_TEST);
         glDepthMask(GL_FALSE);
@@ -397,28 +620,68 @@ void MotorcarSurfaceNode::draw(Scene *scene, Display *display)
 
 
 
-    GLuint texture = this->surface()->texture();
-
-    glBindTexture(GL_TEXTURE_2D, texture);
+    glBindTexture(GL_TEXTURE_2D, m_texture);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
 
     glm::vec4 vp;
-    for(ViewPoint *viewpoint : display->viewpoints()){
+    for(const ViewpointSnapshot &viewpoint : display.viewpoints){
 
-        viewpoint->viewport()->set();
+        viewpoint.setViewport();
 
-        if(surface()->depthCompositingEnabled()){
-            vp = viewpoint->clientColorViewport()->viewportParams();
+        //only the acknowledged bounds of the client buffer hold contents drawn for this frame
+        std::map<const ViewPoint *, ViewpointState>::const_iterator state = m_viewpointStates.find(viewpoint.viewpoint);
+        bool hasBounds = state != m_viewpointStates.end() && state->second.hasBounds;
+        if(hasBounds){
+            glm::ivec4 rect = state->second.bounds;
+            glEnable(GL_SCISSOR_TEST);
+            glScissor(viewpoint.viewport.x + rect.x, viewpoint.viewport.y + rect.y, rect.z, rect.w);
+        }
+
+        //the client drew for the view matrix the frame was snapshotted with, a late latched view turns the buffer with it
+        glm::mat4 lateLatchCorrection = viewpoint.projectionMatrix * viewpoint.lateLatchCorrection * glm::inverse(viewpoint.projectionMatrix);
+
+        //a buffer drawn for an older viewpoint state is warped to the current one so the window stays world locked
+        if(m_depthCompositingEnabled && state != m_viewpointStates.end() && (state->second.reproject || viewpoint.lateLatched)){
+            ViewpointState warp = state->second;
+            if(viewpoint.lateLatched){
+                warp.reprojection = lateLatchCorrection * (warp.reproject ? warp.reprojection : glm::mat4());
+            }
+            glDisable(GL_SCISSOR_TEST);
+            glm::vec4 colorViewport = separateDepth ? viewpoint.viewportParams : viewpoint.clientColorViewportParams;
+            glm::vec4 depthViewport = separateDepth ? colorViewport : viewpoint.clientDepthViewportParams;
+            glm::vec4 validRegion(0, 0, 1, 1);
+            if(hasBounds){
+                glm::vec4 rect = glm::vec4(state->second.bounds);
+                glm::vec2 viewportSize(viewpoint.viewport.z, viewpoint.viewport.w);
+                validRegion = glm::vec4(glm::vec2(rect.x, rect.y) / viewportSize, glm::vec2(rect.x + rect.z, rect.y + rect.w) / viewportSize);
+            }
+            drawReprojected(warp, colorViewport, depthViewport, validRegion, separateDepth);
+            continue;
+        }
+
+        if(separateDepth){
+            vp = viewpoint.viewportParams;
+            //the depth buffer has the same layout as the color buffer, whatever its resolution
+            const GLfloat clientTextureCoordinates[] = {
+                vp.x, 1 - vp.y,
+                vp.x + vp.z, 1 - vp.y,
+                vp.x + vp.z, 1 - (vp.y + vp.w),
+                vp.x, 1 - (vp.y + vp.w),
+            };
+            glVertexAttribPointer(r.h_aColorTexCoord_depthcomposite, 2, GL_FLOAT, GL_FALSE, 0, clientTextureCoordinates);
+            glVertexAttribPointer(r.h_aDepthTexCoord_depthcomposite, 2, GL_FLOAT, GL_FALSE, 0, clientTextureCoordinates);
+        }else if(m_depthCompositingEnabled){
+            vp = viewpoint.clientColorViewportParams;
             const GLfloat clientColorTextureCoordinates[] = {
                 vp.x, 1 - vp.y,
                 vp.x + vp.z, 1 - vp.y,
                 vp.x + vp.z, 1 - (vp.y + vp.w),
                 vp.x, 1 - (vp.y + vp.w),
             };
-            glVertexAttribPointer(h_aColorTexCoord_depthcomposite, 2, GL_FLOAT, GL_FALSE, 0, clientColorTextureCoordinates);
-            vp = viewpoint->clientDepthViewport()->viewportParams();
+            glVertexAttribPointer(r.h_aColorTexCoord_depthcomposite, 2, GL_FLOAT, GL_FALSE, 0, clientColorTextureCoordinates);
+            vp = viewpoint.clientDepthViewportParams;
 
             const GLfloat clientDepthTextureCoordinates[] = {
                 vp.x, 1 - vp.y,
@@ -426,38 +689,46 @@ void MotorcarSurfaceNode::draw(Scene *scene, Display *display)
                 vp.x + vp.z, 1 - (vp.y + vp.w),
                 vp.x, 1 - (vp.y + vp.w),
             };
-            glVertexAttribPointer(h_aDepthTexCoord_depthcomposite, 2, GL_FLOAT, GL_FALSE, 0, clientDepthTextureCoordinates);
+            glVertexAttribPointer(r.h_aDepthTexCoord_depthcomposite, 2, GL_FLOAT, GL_FALSE, 0, clientDepthTextureCoordinates);
 
         }else {
-            vp = viewpoint->viewport()->viewportParams();
+            vp = viewpoint.viewportParams;
             const GLfloat clientColorTextureCoordinates[] = {
                 vp.x, 1 - vp.y,
                 vp.x + vp.z, 1 - vp.y,
                 vp.x + vp.z, 1 - (vp.y + vp.w),
                 vp.x, 1 - (vp.y + vp.w),
             };
-            glVertexAttribPointer(h_aTexCoord_surface, 2, GL_FLOAT, GL_FALSE, 0, clientColorTextureCoordinates);
+            glVertexAttribPointer(surface.h_aTexCoord_surface, 2, GL_FLOAT, GL_FALSE, 0, clientColorTextureCoordinates);
+            //without depth the buffer can only be turned as a whole, which is exact for rotations about the eye
+            glUniformMatrix4fv(surface.h_uMVPMatrix_surface, 1, GL_FALSE, glm::value_ptr(lateLatchCorrection));
         }
 
         glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
 
+        glDisable(GL_SCISSOR_TEST);
     }
 
-    if(!this->surface()->depthCompositingEnabled()){
+    if(!m_depthCompositingEnabled){
+        for(int plane = 1; plane < planeCount; plane++){
+            glActiveTexture(GL_TEXTURE0 + plane);
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+        glActiveTexture(GL_TEXTURE0);
         glEnable(GL_DEPTH_TEST);
         glDepthMask(GL_TRUE);
     }
 
     clipWindowBounds(display);
 
-    this->drawFrameBufferContents(display);
+    drawFrameBufferContents(display);
 
 
 
-    glBindFramebuffer(GL_FRAMEBUFFER, display->activeFrameBuffer());
+    glBindFramebuffer(GL_FRAMEBUFFER, display.display->activeFrameBuffer());
 
-    glDisableVertexAttribArray(h_aPosition_depthcomposite);
-    glDisableVertexAttribArray(h_aColorTexCoord_depthcomposite);
+    glDisableVertexAttribArray(r.h_aPosition_depthcomposite);
+    glDisableVertexAttribArray(r.h_aColorTexCoord_depthcomposite);
 
     glActiveTexture(GL_TEXTURE1);
     glBindTexture(GL_TEXTURE_2D, 0);
@@ -472,6 +743,47 @@ void MotorcarSurfaceNode::draw(Scene *scene, Display *display)
 
 }
 
+void MotorcarSurfaceNode::Item::drawReprojected(const ViewpointState &state, glm::vec4 colorViewport, glm::vec4 depthViewport,
+                                                glm::vec4 validRegion, bool separateDepth)
+{
+    CompositingResources &r = *m_resources;
+    const CompositingResources::ReprojectionGrid &grid = state.reprojectionGrid;
+
+    //the depth compositing program's arrays point at client memory which must not be read by this draw
+    glDisableVertexAttribArray(r.h_aPosition_depthcomposite);
+    glDisableVertexAttribArray(r.h_aColorTexCoord_depthcomposite);
+    glDisableVertexAttribArray(r.h_aDepthTexCoord_depthcomposite);
+
+    glUseProgram(r.reprojectionShader->handle());
+    glUniform1i(r.h_uDepthSource_reprojection, separateDepth ? 1 : 0);
+    glUniform4fv(r.h_uColorViewport_reprojection, 1, glm::value_ptr(colorViewport));
+    glUniform4fv(r.h_uDepthViewport_reprojection, 1, glm::value_ptr(depthViewport));
+    glUniformMatrix4fv(r.h_uReprojectionMatrix_reprojection, 1, GL_FALSE, glm::value_ptr(state.reprojection));
+    glUniform4fv(r.h_uValidRegion_reprojection, 1, glm::value_ptr(validRegion));
+    glUniform2fv(r.h_uGridStep_reprojection, 1, glm::value_ptr(1.0f / glm::vec2(grid.size)));
+
+    glEnableVertexAttribArray(r.h_aGridCoord_reprojection);
+    glBindBuffer(GL_ARRAY_BUFFER, grid.vertices);
+    glVertexAttribPointer(r.h_aGridCoord_reprojection, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, grid.indices);
+
+    glDrawElements(GL_TRIANGLES, grid.indexCount, GL_UNSIGNED_INT, 0);
+
+    glDisableVertexAttribArray(r.h_aGridCoord_reprojection);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glUseProgram(r.depthCompositedSurfaceShader->handle());
+    glEnableVertexAttribArray(r.h_aPosition_depthcomposite);
+    glEnableVertexAttribArray(r.h_aColorTexCoord_depthcomposite);
+    glEnableVertexAttribArray(r.h_aDepthTexCoord_depthcomposite);
+}
+
+void MotorcarSurfaceNode::snapshot(Scene *scene, FrameSnapshot *frame)
+{
+    frame->items.push_back(new Item(this, scene));
+}
+
 void MotorcarSurfaceNode::computeSurfaceTransform(float ppcm)
 {
     m_surfaceTransform=glm::mat4();
@@ -502,8 +814,72 @@ void MotorcarSurfaceNode::handle_set_size_3d(struct wl_client *client,
 
 
 
+void MotorcarSurfaceNode::handle_ack_viewpoint_bounds(struct wl_client *client,
+                struct wl_resource *resource,
+                uint32_t serial){
+    MotorcarSurfaceNode *surfaceNode = static_cast<MotorcarSurfaceNode *> (resource->data);
+    std::deque<std::pair<uint32_t, ViewpointBounds> > &sent = surfaceNode->m_sentBounds;
+    std::deque<std::pair<uint32_t, ViewpointBounds> >::iterator it = sent.begin();
+    while(it != sent.end() && it->first != serial){
+        it++;
+    }
+    if(it == sent.end()){
+        std::cout << "Warning: client acknowledged unknown viewpoint bounds serial " << serial << std::endl;
+        return;
+    }
+    //the current buffer was drawn for the previous bounds, the client draws for these from its next commit on
+    unsigned int commitSerial = surfaceNode->surface()->commitSerial() + 1;
+    std::deque<std::pair<unsigned int, ViewpointBounds> > &pending = surfaceNode->m_pendingAckedBounds;
+    if(!pending.empty() && pending.back().first == commitSerial){
+        pending.back().second = it->second;
+    }else{
+        pending.push_back(std::make_pair(commitSerial, it->second));
+    }
+    //bounds older than these will not be used anymore
+    sent.erase(sent.begin(), it);
+}
+
+
+
+void MotorcarSurfaceNode::handle_set_depth_buffer(struct wl_client *client,
+                struct wl_resource *resource,
+                struct wl_resource *buffer,
+                uint32_t format){
+    MotorcarSurfaceNode *surfaceNode = static_cast<MotorcarSurfaceNode *> (resource->data);
+    if(buffer != NULL && !DepthBuffer::isSupportedBuffer(buffer)){
+        wl_resource_post_error(resource, MOTORCAR_SURFACE_ERROR_INVALID_DEPTH_BUFFER, "depth buffer must be a shared memory buffer");
+        return;
+    }
+    if(format != MOTORCAR_SURFACE_DEPTH_FORMAT_DEPTH_16 && format != MOTORCAR_SURFACE_DEPTH_FORMAT_DEPTH_24){
+        wl_resource_post_error(resource, MOTORCAR_SURFACE_ERROR_INVALID_DEPTH_FORMAT, "unknown depth format %u", format);
+        return;
+    }
+    DepthBuffer::Format depthFormat = format == MOTORCAR_SURFACE_DEPTH_FORMAT_DEPTH_24 ? DepthBuffer::Format::DEPTH24 : DepthBuffer::Format::DEPTH16;
+    if(buffer != NULL && !DepthBuffer::hasValidStride(buffer, depthFormat)){
+        wl_resource_post_error(resource, MOTORCAR_SURFACE_ERROR_INVALID_DEPTH_BUFFER, "depth buffer stride must be a multiple of the depth value size holding a full row");
+        return;
+    }
+    //like the color buffer, the depth buffer belongs to the client's next commit
+    surfaceNode->m_depthBuffer.attach(buffer, depthFormat, surfaceNode->surface()->commitSerial() + 1);
+}
+
+
+
+void MotorcarSurfaceNode::handle_presentation_feedback(struct wl_client *client,
+                struct wl_resource *resource,
+                uint32_t callback){
+    MotorcarSurfaceNode *surfaceNode = static_cast<MotorcarSurfaceNode *> (resource->data);
+    //the feedback is about the content of the next commit
+    surfaceNode->m_pendingFeedback.push_back(new PresentationFeedback(client, callback, surfaceNode, surfaceNode->surface()->commitSerial() + 1));
+}
+
+
+
 const static struct motorcar_surface_interface motorcarSurfaceInterface = {
-    MotorcarSurfaceNode::handle_set_size_3d
+    MotorcarSurfaceNode::handle_set_size_3d,
+    MotorcarSurfaceNode::handle_ack_viewpoint_bounds,
+    MotorcarSurfaceNode::handle_set_depth_buffer,
+    MotorcarSurfaceNode::handle_presentation_feedback
 };
 
 	/**
@@ -740,6 +1116,177 @@ void MotorcarSurfaceNode::handleWorldTransformChange(Scene *scene)
 }
 
 
+void MotorcarSurfaceNode::handleFrameBegin(Scene *scene)
+{
+    WaylandSurfaceNode::handleFrameBegin(scene);
+
+    //color content may reach the textures a commit or two late, depth has to follow the same commit
+    if(m_depthBuffer.hasPending()){
+        m_depthBuffer.latch(surface()->contentCommitSerial(), scene->resourcePool(), surface());
+    }
+
+    //the view matrices have not been updated for this frame yet, so they are still the ones the client last received
+    if(surface()->contentSerial() != m_contentMatricesSerial){
+        latchPresentationFeedback(scene);
+        latchAckedBounds();
+        m_contentMatrices.clear();
+        for(Display *display : scene->displays()){
+            for(ViewPoint *viewpoint : display->viewpoints()){
+                m_contentMatrices[viewpoint] = viewpoint->projectionMatrix() * viewpoint->viewMatrix() * this->worldTransform();
+            }
+        }
+        m_contentMatricesSerial = surface()->contentSerial();
+    }
+
+    if(m_resource == NULL || !surface()->isMotorcarSurface() ||
+            wl_resource_get_version(m_resource) < MOTORCAR_SURFACE_VIEWPOINT_BOUNDS_SINCE_VERSION){
+        return;
+    }
+
+    ViewpointBounds bounds;
+    for(Display *display : scene->displays()){
+        for(ViewPoint *viewpoint : display->viewpoints()){
+            bounds[viewpoint] = computeViewpointBounds(viewpoint);
+        }
+    }
+
+    ViewpointBounds lastSent = !m_sentBounds.empty() ? m_sentBounds.back().second :
+                               !m_pendingAckedBounds.empty() ? m_pendingAckedBounds.back().second : m_ackedBounds;
+    if(bounds != lastSent){
+        sendViewpointBounds(bounds);
+    }
+}
+
+void MotorcarSurfaceNode::latchPresentationFeedback(Scene *scene)
+{
+    if(scene->windowManager() == NULL){
+        return;
+    }
+    Shell *shell = scene->windowManager()->shell();
+    //content picked up by earlier frames is no longer shown once this frame is presented
+    shell->supersedePresentationFeedback(this, scene->frameSequence());
+
+    //earlier commits were replaced before any frame picked them up, later ones have not reached the textures yet
+    unsigned int commitSerial = surface()->contentCommitSerial();
+    std::vector<PresentationFeedback *>::iterator it = m_pendingFeedback.begin();
+    while(it != m_pendingFeedback.end()){
+        PresentationFeedback *feedback = *it;
+        if(feedback->commitSerial() > commitSerial){
+            it++;
+            continue;
+        }
+        if(feedback->commitSerial() == commitSerial){
+            feedback->latch(scene->frameSequence(), scene->predictedPresentationNanos());
+            shell->addPresentationFeedback(feedback);
+        }else{
+            delete feedback;
+        }
+        it = m_pendingFeedback.erase(it);
+    }
+}
+
+void MotorcarSurfaceNode::latchAckedBounds()
+{
+    unsigned int commitSerial = surface()->contentCommitSerial();
+    while(!m_pendingAckedBounds.empty() && m_pendingAckedBounds.front().first <= commitSerial){
+        m_ackedBounds = m_pendingAckedBounds.front().second;
+        m_boundsAcked = true;
+        m_pendingAckedBounds.pop_front();
+    }
+}
+
+bool MotorcarSurfaceNode::computeReprojectionMatrix(ViewPoint *viewpoint, glm::mat4 *reprojection) const
+{
+    std::map<ViewPoint *, glm::mat4>::const_iterator it = m_contentMatrices.find(viewpoint);
+    if(it == m_contentMatrices.end()){
+        return false;
+    }
+
+    *reprojection = viewpoint->projectionMatrix() * viewpoint->viewMatrix() * this->worldTransform() * glm::inverse(it->second);
+
+    for(int column = 0; column < 4; column++){
+        for(int row = 0; row < 4; row++){
+            float identity = column == row ? 1.0f : 0.0f;
+            if(glm::abs((*reprojection)[column][row] - identity) > 0.00001f){
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+glm::ivec4 MotorcarSurfaceNode::computeViewpointBounds(ViewPoint *viewpoint) const
+{
+    glm::ivec2 viewportSize = glm::ivec2(viewpoint->viewport()->width(), viewpoint->viewport()->height());
+    glm::ivec4 fullViewport(0, 0, viewportSize.x, viewportSize.y);
+
+    glm::mat4 mvp = viewpoint->projectionMatrix() * viewpoint->viewMatrix() * this->worldTransform() * glm::scale(glm::mat4(), this->dimensions());
+    glm::vec2 lower(1), upper(-1);
+    for(int i = 0; i < 8; i++){
+        glm::vec4 corner = mvp * glm::vec4(i & 1 ? 0.5f : -0.5f, i & 2 ? 0.5f : -0.5f, i & 4 ? 0.5f : -0.5f, 1);
+        if(corner.w <= 0.0001f){
+            //part of the window is behind the viewpoint, so its projection is unbounded
+            return fullViewport;
+        }
+        glm::vec2 ndc = glm::vec2(corner) / corner.w;
+        lower = glm::min(lower, ndc);
+        upper = glm::max(upper, ndc);
+    }
+
+    glm::vec2 pixelLower = (glm::clamp(lower, -1.0f, 1.0f) * 0.5f + 0.5f) * glm::vec2(viewportSize);
+    glm::vec2 pixelUpper = (glm::clamp(upper, -1.0f, 1.0f) * 0.5f + 0.5f) * glm::vec2(viewportSize);
+
+    glm::ivec2 alignment(VIEWPOINT_BOUNDS_ALIGNMENT);
+    glm::ivec2 start = glm::ivec2(glm::floor(pixelLower)) - VIEWPOINT_BOUNDS_MARGIN;
+    glm::ivec2 end = glm::ivec2(glm::ceil(pixelUpper)) + VIEWPOINT_BOUNDS_MARGIN;
+    start = glm::clamp((start / alignment) * alignment, glm::ivec2(0), viewportSize);
+    end = glm::clamp(((end + alignment - 1) / alignment) * alignment, glm::ivec2(0), viewportSize);
+
+    if(end.x <= start.x || end.y <= start.y){
+        //entirely off screen, keep a minimal region so the client still has a valid viewport to draw into
+        return glm::ivec4(0, 0, glm::min(alignment, viewportSize));
+    }
+    return glm::ivec4(start, end - start);
+}
+
+void MotorcarSurfaceNode::sendViewpointBounds(const ViewpointBounds &bounds)
+{
+    wl_client *client = wl_resource_get_client(m_resource);
+    m_boundsSerial++;
+
+    for(const std::pair<ViewPoint * const, glm::ivec4> &entry : bounds){
+        ViewPoint *viewpoint = entry.first;
+        wl_resource *viewpointResource = viewpoint->resourceForClient(client);
+        if(viewpointResource == NULL){
+            continue;
+        }
+
+        glm::ivec4 rect = entry.second;
+        glm::vec2 viewportSize = glm::vec2(viewpoint->viewport()->width(), viewpoint->viewport()->height());
+
+        //scales and offsets clip space so that the bounds fill the normalized device coordinate range
+        glm::mat4 crop;
+        crop[0][0] = viewportSize.x / rect.z;
+        crop[1][1] = viewportSize.y / rect.w;
+        crop[3][0] = (viewportSize.x - 2.0f * rect.x - rect.z) / rect.z;
+        crop[3][1] = (viewportSize.y - 2.0f * rect.y - rect.w) / rect.w;
+        glm::mat4 projection = crop * viewpoint->projectionMatrix();
+        std::memcpy(m_boundsProjectionArray.data, glm::value_ptr(projection), m_boundsProjectionArray.size);
+
+        ViewPort *color = viewpoint->clientColorViewport();
+        ViewPort *depth = viewpoint->clientDepthViewport();
+        motorcar_surface_send_viewpoint_bounds(m_resource, viewpointResource, m_boundsSerial,
+                                               color->offsetX() + rect.x, color->offsetY() + rect.y, rect.z, rect.w,
+                                               depth->offsetX() + rect.x, depth->offsetY() + rect.y, rect.z, rect.w,
+                                               &m_boundsProjectionArray);
+    }
+
+    m_sentBounds.push_back(std::make_pair(m_boundsSerial, bounds));
+    if(m_sentBounds.size() > MAX_SENT_VIEWPOINT_BOUNDS){
+        m_sentBounds.pop_front();
+    }
+}
+
 void MotorcarSurfaceNode::requestSize3D(const glm::vec3 &dimensions)
 {
     glm::vec3 dims(dimensions);
@@ -780,9 +1327,9 @@ wl_resource *MotorcarSurfaceNode::resource() const
 }
 
 
-void MotorcarSurfaceNode::configureResource(wl_client *client, uint32_t id)
+void MotorcarSurfaceNode::configureResource(wl_client *client, uint32_t id, int version)
 {
-    m_resource = wl_resource_create(client, &motorcar_surface_interface, motorcar_surface_interface.version, id);
+    m_resource = wl_resource_create(client, &motorcar_surface_interface, version, id);
     wl_resource_set_implementation(m_resource, &motorcarSurfaceInterface, this, 0);
     sendTransformToClient();
     requestSize3D(m_dimensions);
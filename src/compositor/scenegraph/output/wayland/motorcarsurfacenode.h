@@ -35,25 +35,36 @@
 #ifndef DEPTHCOMPOSITEDSURFACE_H
 #define DEPTHCOMPOSITEDSURFACE_H
 #include <scenegraph/output/wayland/waylandsurfacenode.h>
+#include <wayland/output/depthbuffer.h>
+
+#include <map>
+#include <deque>
+#include <vector>
 
 
 namespace motorcar {
+class PresentationFeedback;
 
 class MotorcarSurfaceNode : public WaylandSurfaceNode
 {
 public:
     MotorcarSurfaceNode(WaylandSurface *surface, SceneGraphNode *parent, const glm::mat4 &transform = glm::mat4(1), glm::vec3 dimensions = glm::vec3(1));
+    ///discards the presentation feedback of content which has not been presented yet
+    virtual ~MotorcarSurfaceNode();
 
 
 
 
 
-    ///extracts the depth and color information from the client surface, clips them against the surface boundaries, and composites with the scene
-    virtual void draw(Scene *scene, Display *display) override;
+    ///snapshots what is needed to extract the depth and color information from the client surface, clip them against the surface boundaries, and composite them with the scene
+    virtual void snapshot(Scene *scene, FrameSnapshot *frame) override;
     virtual void computeSurfaceTransform(float ppcm) override;
 
     void handleWorldTransformChange(Scene *scene) override;
 
+    ///computes the screen space bounds of the window in every viewpoint and sends them to the client if they changed
+    virtual void handleFrameBegin(Scene *scene) override;
+
 
     //returns the dimensions of the 3D window associated with this surface node
     glm::vec3 dimensions() const;
@@ -65,8 +76,21 @@ public:
                     struct wl_resource *resource,
                     struct wl_array *dimensions);
 
+    static void handle_ack_viewpoint_bounds(struct wl_client *client,
+                    struct wl_resource *resource,
+                    uint32_t serial);
+
+    static void handle_set_depth_buffer(struct wl_client *client,
+                    struct wl_resource *resource,
+                    struct wl_resource *buffer,
+                    uint32_t format);
+
+    static void handle_presentation_feedback(struct wl_client *client,
+                    struct wl_resource *resource,
+                    uint32_t callback);
+
     wl_resource *resource() const;
-    void configureResource(struct wl_client *client, uint32_t id);
+    void configureResource(struct wl_client *client, uint32_t id, int version);
     void configureResourceXDG(struct wl_client *client, uint32_t id);
 
 private:
@@ -75,25 +99,85 @@ private:
     void sendTransformToClient();
     void setDimensions(const glm::vec3 &dimensions);
 
-    OpenGLShader *m_depthCompositedSurfaceShader, *m_depthCompositedSurfaceBlitter, *m_clippingShader;
-    void drawFrameBufferContents(Display * display);
-    void drawWindowBoundsStencil(Display * display);
-    void clipWindowBounds(Display * display);
+    //rectangles (x, y, width, height) in viewport local pixels
+    typedef std::map<ViewPoint *, glm::ivec4> ViewpointBounds;
+
+    ///returns the pixels of the viewpoint's viewport the clipping volume can cover, rounded outwards
+    glm::ivec4 computeViewpointBounds(ViewPoint *viewpoint) const;
+    void sendViewpointBounds(const ViewpointBounds &bounds);
+
+    ///shaders and buffers used to composite the client's buffer, shared with the frames in flight which draw this node
+    class CompositingResources
+    {
+    public:
+        CompositingResources();
+        ~CompositingResources();
+
+        OpenGLShader *depthCompositedSurfaceShader, *depthCompositedSurfaceBlitter, *clippingShader, *reprojectionShader;
+
+        //attribute buffers
+        GLuint colorTextureCoordinates, depthTextureCoordinates, surfaceVertexCoordinates;
+        GLuint cuboidClippingVertices, cuboidClippingIndices;
+
+        //shader variable handles
+        GLint h_aPosition_depthcomposite, h_aColorTexCoord_depthcomposite, h_aDepthTexCoord_depthcomposite, h_uDepthSource_depthcomposite;
+
+        GLint h_aPosition_blit, h_aTexCoord_blit, h_uColorSampler_blit, h_uDepthSampler_blit;
+
+        GLint h_aPosition_clipping, h_uMVPMatrix_clipping, h_uColor_clipping;
+
+        GLint h_aGridCoord_reprojection, h_uDepthSource_reprojection, h_uColorViewport_reprojection, h_uDepthViewport_reprojection,
+            h_uReprojectionMatrix_reprojection, h_uValidRegion_reprojection, h_uGridStep_reprojection;
+
+        //grid of vertices spanning a viewport which is displaced by the client's depth when reprojecting
+        struct ReprojectionGrid
+        {
+            GLuint vertices, indices;
+            GLsizei indexCount;
+            glm::ivec2 size;
+        };
+        /*one grid per viewport size, built while snapshotting and never changed afterwards, so any
+         * number of drawing threads can read them*/
+        std::map<std::pair<int, int>, ReprojectionGrid> reprojectionGrids;
+
+        ///returns the grid for viewports of the given size, building it if there is none yet
+        ReprojectionGrid reprojectionGrid(glm::ivec2 viewportSize);
+    };
 
-    //attribute buffers
-    GLuint m_colorTextureCoordinates, m_depthTextureCoordinates,  m_surfaceVertexCoordinates;
-    GLuint m_cuboidClippingVertices, m_cuboidClippingIndices;
+    class Item;
 
-    //shader variable handles
-    GLint h_aPosition_depthcomposite, h_aColorTexCoord_depthcomposite, h_aDepthTexCoord_depthcomposite;
+    std::shared_ptr<CompositingResources> m_compositingResources;
 
-    GLint h_aPosition_blit, h_aTexCoord_blit, h_uColorSampler_blit, h_uDepthSampler_blit;
+    //projection * view * model matrices each viewpoint had when the client's current buffer was drawn
+    std::map<ViewPoint *, glm::mat4> m_contentMatrices;
+    unsigned int m_contentMatricesSerial;
 
-    GLint h_aPosition_clipping, h_uMVPMatrix_clipping, h_uColor_clipping;
+    ///computes the matrix taking clip space of the client's buffer to clip space of the viewpoint's current frame
+    /*returns false if the buffer was drawn for the current viewpoint state (or its state is unknown), so no reprojection is needed*/
+    bool computeReprojectionMatrix(ViewPoint *viewpoint, glm::mat4 *reprojection) const;
 
 
     struct wl_resource *m_resource;
-    struct wl_array m_dimensionsArray, m_transformArray;
+    struct wl_array m_dimensionsArray, m_transformArray, m_boundsProjectionArray;
+
+    //bounds sent to the client which it has not acknowledged yet, oldest first
+    std::deque<std::pair<uint32_t, ViewpointBounds> > m_sentBounds;
+    uint32_t m_boundsSerial;
+    //bounds the client's current buffer was drawn with, the full viewports are used until the client acknowledges any
+    ViewpointBounds m_ackedBounds;
+    bool m_boundsAcked;
+    //acknowledged bounds waiting for the content of the commit following the acknowledgement, keyed by that commit's serial
+    std::deque<std::pair<unsigned int, ViewpointBounds> > m_pendingAckedBounds;
+    ///makes the newest acknowledged bounds whose commit has reached the surface's textures the current ones
+    void latchAckedBounds();
+
+    //separate depth buffer attached by the client, latched with the color content of the commit it was attached for
+    DepthBuffer m_depthBuffer;
+
+    //feedback requested for commits whose content has not been picked up by a frame yet
+    std::vector<PresentationFeedback *> m_pendingFeedback;
+    ///hands the feedback of the content the surface picked up for this frame over to the shell, called when the content changed
+    void latchPresentationFeedback(Scene *scene);
 
 
     glm::vec3 m_dimensions;
@@ -0,0 +1,146 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#include <scenegraph/output/wayland/surfacebatch.h>
+
+#include <iostream>
+#include <wayland/output/waylandsurface.h>
+
+#include <glm/gtc/type_ptr.hpp>
+
+using namespace motorcar;
+
+SurfaceBatch::Program::Program()
+    :shader(new OpenGLShader(std::string("motorcarsurface.vert"), std::string("motorcarsurface.frag")))
+{
+    h_aPosition = glGetAttribLocation(shader->handle(), "aPosition");
+    h_aTexCoord = glGetAttribLocation(shader->handle(), "aTexCoord");
+    h_uMVPMatrix = glGetUniformLocation(shader->handle(), "uMVPMatrix");
+    h_uTextureFormat = glGetUniformLocation(shader->handle(), "uTextureFormat");
+
+    if(h_aPosition < 0 || h_aTexCoord < 0 || h_uMVPMatrix < 0 || h_uTextureFormat < 0){
+       std::cout << "problem with surface batch shader handles: " << h_aPosition << ", "<< h_aTexCoord << ", " << h_uMVPMatrix << ", " << h_uTextureFormat << std::endl;
+    }
+
+    glGenBuffers(1, &vertexBuffer);
+    glGenBuffers(1, &textureCoordinateBuffer);
+}
+
+SurfaceBatch::Program::~Program()
+{
+    glDeleteBuffers(1, &vertexBuffer);
+    glDeleteBuffers(1, &textureCoordinateBuffer);
+    delete shader;
+}
+
+SurfaceBatch::SurfaceBatch(std::shared_ptr<SurfaceBatch::Program> program, GLuint atlasTexture)
+    :m_program(program)
+    ,m_atlasTexture(atlasTexture)
+    ,m_vertexCount(0)
+{
+}
+
+void SurfaceBatch::addQuad(const glm::mat4 &transform, const glm::vec4 &textureCoordinates)
+{
+    //same corners as the surface node's triangle fan, split into two triangles
+    static const int corners[6][2] = {{0, 0}, {0, 1}, {1, 1}, {0, 0}, {1, 1}, {1, 0}};
+
+    for(int i = 0; i < 6; i++){
+        glm::vec4 vertex = transform * glm::vec4(corners[i][0], corners[i][1], 0, 1);
+        m_vertices.push_back(vertex.x);
+        m_vertices.push_back(vertex.y);
+        m_vertices.push_back(vertex.z);
+        m_textureCoordinates.push_back(textureCoordinates.x + corners[i][0] * textureCoordinates.z);
+        m_textureCoordinates.push_back(textureCoordinates.y + corners[i][1] * textureCoordinates.w);
+    }
+}
+
+void SurfaceBatch::upload()
+{
+    if(m_vertices.empty()){
+        return;
+    }
+
+    const Program &p = *m_program;
+    glBindBuffer(GL_ARRAY_BUFFER, p.vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, m_vertices.size() * sizeof(GLfloat), &m_vertices[0], GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, p.textureCoordinateBuffer);
+    glBufferData(GL_ARRAY_BUFFER, m_textureCoordinates.size() * sizeof(GLfloat), &m_textureCoordinates[0], GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    m_vertexCount = m_vertices.size() / 3;
+    m_vertices.clear();
+    m_textureCoordinates.clear();
+}
+
+void SurfaceBatch::draw(const DisplaySnapshot &display)
+{
+    if(m_vertexCount == 0){
+        return;
+    }
+
+    const Program &p = *m_program;
+    glUseProgram(p.shader->handle());
+    glUniform1i(p.h_uTextureFormat, WaylandSurface::TextureFormat::RGBA);
+
+    glEnableVertexAttribArray(p.h_aPosition);
+    glBindBuffer(GL_ARRAY_BUFFER, p.vertexBuffer);
+    glVertexAttribPointer(p.h_aPosition, 3, GL_FLOAT, GL_FALSE, 0, 0);
+
+    glEnableVertexAttribArray(p.h_aTexCoord);
+    glBindBuffer(GL_ARRAY_BUFFER, p.textureCoordinateBuffer);
+    glVertexAttribPointer(p.h_aTexCoord, 2, GL_FLOAT, GL_FALSE, 0, 0);
+
+    glBindTexture(GL_TEXTURE_2D, m_atlasTexture);
+
+    GLsizei vertexCount = m_vertexCount;
+    for(const ViewpointSnapshot &viewpoint : display.viewpoints){
+        viewpoint.setViewport();
+        glUniformMatrix4fv(p.h_uMVPMatrix, 1, GL_FALSE, glm::value_ptr(viewpoint.projectionMatrix * viewpoint.viewMatrix));
+        glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glDisableVertexAttribArray(p.h_aPosition);
+    glDisableVertexAttribArray(p.h_aTexCoord);
+
+    glUseProgram(0);
+}
+
+bool SurfaceBatch::empty() const
+{
+    return m_vertices.empty() && m_vertexCount == 0;
+}
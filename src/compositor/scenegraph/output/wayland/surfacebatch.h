@@ -0,0 +1,93 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#ifndef SURFACEBATCH_H
+#define SURFACEBATCH_H
+
+#include <gl/openglshader.h>
+#include <gl/textureatlas.h>
+#include <scenegraph/output/framesnapshot.h>
+
+#include <glm/glm.hpp>
+#include <GL/gl.h>
+
+#include <memory>
+#include <vector>
+
+namespace motorcar {
+///Collects the quads of atlas resident surfaces so they can be drawn together
+/*Surface nodes whose contents live in the scene's surface atlas add their quad to the batch of the frame
+ * being snapshotted instead of adding an item of their own, and the batch draws all collected quads with
+ * a single draw call per viewpoint once the rest of the frame's items have been drawn for the display*/
+class SurfaceBatch : public RenderItem
+{
+public:
+    ///shader and vertex buffers batches are drawn with, shared by the batches of all frames
+    /*the buffers are filled by the snapshotting thread, after it waited for the frames drawn so far*/
+    class Program
+    {
+    public:
+        Program();
+        ~Program();
+
+        OpenGLShader *shader;
+        GLint h_aPosition, h_aTexCoord, h_uMVPMatrix, h_uTextureFormat;
+        GLuint vertexBuffer, textureCoordinateBuffer;
+    };
+
+    SurfaceBatch(std::shared_ptr<Program> program, GLuint atlasTexture);
+
+    ///adds a unit quad transformed by the given matrix into world space, textured with the given atlas region
+    /*textureCoordinates are (s, t, width, height) as returned by TextureAtlas::textureCoordinates*/
+    void addQuad(const glm::mat4 &transform, const glm::vec4 &textureCoordinates);
+
+    ///copies the quads added so far into the program's vertex buffers, called once the frame is snapshotted
+    /*this way the buffers are only read while drawing, which may happen on several threads at once*/
+    void upload();
+
+    ///draws all quads added to the batch for every viewpoint of the display
+    virtual void draw(const DisplaySnapshot &display) override;
+
+    bool empty() const;
+
+private:
+    std::shared_ptr<Program> m_program;
+    GLuint m_atlasTexture;
+
+    std::vector<GLfloat> m_vertices, m_textureCoordinates;
+    GLsizei m_vertexCount;
+};
+}
+
+#endif // SURFACEBATCH_H
@@ -36,17 +36,116 @@
 #include <scenegraph/output/display/display.h>
 #include <gl/viewport.h>
 #include <scenegraph/output/wireframenode.h>
+#include <scenegraph/output/wayland/surfacebatch.h>
+#include <scenegraph/scene.h>
+#include <gl/textureatlas.h>
+#include <gl/mipmappedtexture.h>
 
-using namespace motorcar;
+#include <sstream>
 
-WaylandSurfaceNode::WaylandSurfaceNode(WaylandSurface *surface, SceneGraphNode *parent, const glm::mat4 &transform)
-    :Drawable(parent, transform)
-    ,m_surfaceShader(new motorcar::OpenGLShader(std::string("motorcarsurface.vert"), std::string("motorcarsurface.frag")))
+using namespace motorcar;
 
+//surfaces are switched to their mipmapped copy when more than this many texels fall on a pixel,
+//and back once fewer than MIPMAP_DISABLE_THRESHOLD do, so a surface near the boundary does not flip every frame.
+//The copy starts at half resolution, so it is only used around the point where bilinear sampling of the
+//source starts skipping texels, and is magnified by no more than 1.25 before the source takes over again
+static const float MIPMAP_ENABLE_THRESHOLD = 2.0f;
+static const float MIPMAP_DISABLE_THRESHOLD = 1.6f;
+
+//toplevel buffers are requested at one of these fractions of the size the client picked, the coarse steps
+//keep the number of resizes low. A surface moves to a lower level only if its footprint fits in that level
+//with some room to spare, and only after it has stayed there for a while, growing back reacts faster
+static const float LOD_LEVELS[] = {1.0f, 0.5f, 0.25f};
+static const int LOD_LEVEL_COUNT = 3;
+static const float LOD_DOWNSCALE_MARGIN = 0.8f;
+static const int LOD_DOWNSCALE_FRAMES = 120;
+static const int LOD_UPSCALE_FRAMES = 10;
+//clients are free to ignore resize requests, one not answered within this many frames is given up on
+static const int LOD_REQUEST_TIMEOUT_FRAMES = 300;
+
+//distance in meters between the parent surface and its bottom subsurface, and between stacked subsurfaces
+static const float SUBSURFACE_STACKING_OFFSET = 0.001f;
+
+///draws the surface with the texture and transform it had at the time of the snapshot
+class WaylandSurfaceNode::Item : public RenderItem
 {
+public:
+    Item(std::shared_ptr<WaylandSurfaceNode::Resources> resources, const glm::mat4 &modelMatrix, GLuint texture,
+         GLuint uPlaneTexture, GLuint vPlaneTexture, WaylandSurface::TextureFormat format, bool mipmapped)
+        :m_resources(resources)
+        ,m_modelMatrix(modelMatrix)
+        ,m_texture(texture)
+        ,m_format(format)
+        ,m_mipmapped(mipmapped)
+    {
+        m_planeTextures[0] = texture;
+        m_planeTextures[1] = uPlaneTexture;
+        m_planeTextures[2] = vPlaneTexture;
+    }
 
-     std::cout << std::endl << "constructing surface node " << this << std::endl;
+    virtual void draw(const DisplaySnapshot &display) override
+    {
+        const WaylandSurfaceNode::Resources &r = *m_resources;
+        glUseProgram(r.surfaceShader->handle());
+
+        glEnableVertexAttribArray(r.h_aPosition_surface);
+        glBindBuffer(GL_ARRAY_BUFFER, r.surfaceVertexCoordinates);
+        glVertexAttribPointer(r.h_aPosition_surface, 3, GL_FLOAT, GL_FALSE, 0, 0);
+
+        glEnableVertexAttribArray(r.h_aTexCoord_surface);
+        glBindBuffer(GL_ARRAY_BUFFER, r.surfaceTextureCoordinates);
+        glVertexAttribPointer(r.h_aTexCoord_surface, 2, GL_FLOAT, GL_FALSE, 0, 0);
+
+
+
+        int planeCount = m_format == WaylandSurface::TextureFormat::YUV420 ? 3 : m_format == WaylandSurface::TextureFormat::NV12 ? 2 : 1;
+        glUniform1i(r.h_uTextureFormat_surface, m_format);
+        for(int plane = 1; plane < planeCount; plane++){
+            glActiveTexture(GL_TEXTURE0 + plane);
+            glBindTexture(GL_TEXTURE_2D, m_planeTextures[plane]);
+        }
+        glActiveTexture(GL_TEXTURE0);
+
+        glBindTexture(GL_TEXTURE_2D, m_texture);
+
+        if(!m_mipmapped){
+            glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        }
 
+        for(const ViewpointSnapshot &viewpoint : display.viewpoints){
+            viewpoint.setViewport();
+            glUniformMatrix4fv(r.h_uMVPMatrix_surface, 1, GL_FALSE, glm::value_ptr(viewpoint.projectionMatrix * viewpoint.viewMatrix * m_modelMatrix));
+            glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        for(int plane = 1; plane < planeCount; plane++){
+            glActiveTexture(GL_TEXTURE0 + plane);
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+        glActiveTexture(GL_TEXTURE0);
+
+        glDisableVertexAttribArray(r.h_aPosition_surface);
+        glDisableVertexAttribArray(r.h_aTexCoord_surface);
+
+        glUseProgram(0);
+    }
+
+private:
+    std::shared_ptr<WaylandSurfaceNode::Resources> m_resources;
+    glm::mat4 m_modelMatrix;
+    GLuint m_texture, m_planeTextures[3];
+    WaylandSurface::TextureFormat m_format;
+    bool m_mipmapped;
+};
+
+
+
+WaylandSurfaceNode::Resources::Resources()
+    :surfaceShader(new motorcar::OpenGLShader(std::string("motorcarsurface.vert"), std::string("motorcarsurface.frag")))
+{
     static const GLfloat textureCoordinates[] = {
         0.0f, 0.0f,
         0.0f, 1.0f,
@@ -60,24 +159,60 @@ WaylandSurfaceNode::WaylandSurfaceNode(WaylandSurface *surface, SceneGraphNode *
         1.0f, 0.0f, 0.0f
     };
 
-    glGenBuffers(1, &m_surfaceTextureCoordinates);
-    glBindBuffer(GL_ARRAY_BUFFER, m_surfaceTextureCoordinates);
+    glGenBuffers(1, &surfaceTextureCoordinates);
+    glBindBuffer(GL_ARRAY_BUFFER, surfaceTextureCoordinates);
     glBufferData(GL_ARRAY_BUFFER, 8 * sizeof(float), textureCoordinates, GL_STATIC_DRAW);
 
-    glGenBuffers(1, &m_surfaceVertexCoordinates);
-    glBindBuffer(GL_ARRAY_BUFFER, m_surfaceVertexCoordinates);
+    glGenBuffers(1, &surfaceVertexCoordinates);
+    glBindBuffer(GL_ARRAY_BUFFER, surfaceVertexCoordinates);
     glBufferData(GL_ARRAY_BUFFER, 12 * sizeof(float), vertexCoordinates, GL_STATIC_DRAW);
 
 
 
-    h_aPosition_surface =  glGetAttribLocation(m_surfaceShader->handle(), "aPosition");
-    h_aTexCoord_surface =  glGetAttribLocation(m_surfaceShader->handle(), "aTexCoord");
-    h_uMVPMatrix_surface  = glGetUniformLocation(m_surfaceShader->handle(), "uMVPMatrix");
+    h_aPosition_surface =  glGetAttribLocation(surfaceShader->handle(), "aPosition");
+    h_aTexCoord_surface =  glGetAttribLocation(surfaceShader->handle(), "aTexCoord");
+    h_uMVPMatrix_surface  = glGetUniformLocation(surfaceShader->handle(), "uMVPMatrix");
+    h_uTextureFormat_surface  = glGetUniformLocation(surfaceShader->handle(), "uTextureFormat");
 
-    if(h_aPosition_surface < 0 || h_aTexCoord_surface < 0 || h_uMVPMatrix_surface < 0 ){
-       std::cout << "problem with surface shader handles: " << h_aPosition_surface << ", "<< h_aTexCoord_surface << ", " << h_uMVPMatrix_surface << std::endl;
+    if(h_aPosition_surface < 0 || h_aTexCoord_surface < 0 || h_uMVPMatrix_surface < 0 || h_uTextureFormat_surface < 0){
+       std::cout << "problem with surface shader handles: " << h_aPosition_surface << ", "<< h_aTexCoord_surface << ", " << h_uMVPMatrix_surface << ", " << h_uTextureFormat_surface << std::endl;
     }
 
+    //the planes of YUV surfaces are bound to the texture units following the luma texture
+    glUseProgram(surfaceShader->handle());
+    glUniform1i(glGetUniformLocation(surfaceShader->handle(), "uTexSampler"), 0);
+    glUniform1i(glGetUniformLocation(surfaceShader->handle(), "uTexSamplerU"), 1);
+    glUniform1i(glGetUniformLocation(surfaceShader->handle(), "uTexSamplerV"), 2);
+    glUseProgram(0);
+}
+
+WaylandSurfaceNode::Resources::~Resources()
+{
+    glDeleteBuffers(1, &surfaceTextureCoordinates);
+    glDeleteBuffers(1, &surfaceVertexCoordinates);
+    delete surfaceShader;
+}
+
+
+
+WaylandSurfaceNode::WaylandSurfaceNode(WaylandSurface *surface, SceneGraphNode *parent, const glm::mat4 &transform)
+    :Drawable(parent, transform)
+    ,m_atlas(NULL)
+    ,m_atlasGeneration(0)
+    ,m_atlasContentSerial(0)
+    ,m_mipmappedTexture(NULL)
+    ,m_mipmappedContentSerial(0)
+    ,m_lodScale(1)
+    ,m_pendingLodScale(1)
+    ,m_lodCandidateScale(1)
+    ,m_lodCandidateFrames(0)
+    ,m_lodRequestFrames(0)
+    ,m_resources(std::make_shared<Resources>())
+
+{
+
+     std::cout << std::endl << "constructing surface node " << this << std::endl;
+
     std::vector<float> decorationVertices;
     //iterate over corners of box
     for(int i = -1; i <= 1; i += 2){
@@ -109,6 +244,8 @@ WaylandSurfaceNode::WaylandSurfaceNode(WaylandSurface *surface, SceneGraphNode *
 
 WaylandSurfaceNode::~WaylandSurfaceNode()
 {
+    releaseAtlasRegion();
+    delete m_mipmappedTexture;
     std::cout << "deleting surfaceNode: " << this <<std::endl;
 }
 
@@ -136,7 +273,8 @@ glm::mat4 WaylandSurfaceNode::surfaceTransform() const
 void WaylandSurfaceNode::computeSurfaceTransform(float ppcm)
 {
     if(ppcm > 0){
-        float ppm = ppcm * 100.f;
+        //a client rendering at reduced resolution is drawn at the same physical size
+        float ppm = ppcm * levelOfDetailScale() * 100.f;
         glm::mat4 surfaceRotation = glm::rotate(glm::mat4(1), 180.f ,glm::vec3(0.0f, 0.0f, 1.0f));
         glm::mat4 surfaceScale = glm::scale(glm::mat4(1), glm::vec3( -m_surface->size().x / ppm,  m_surface->size().y / ppm, 1));
         glm::mat4 surfaceOffset = glm::translate(glm::mat4(1), glm::vec3(-0.5f, -0.5f, 0.0f));
@@ -146,6 +284,209 @@ void WaylandSurfaceNode::computeSurfaceTransform(float ppcm)
     }
 }
 
+void WaylandSurfaceNode::computeSubsurfaceTransform()
+{
+    WaylandSurfaceNode *parentSurfaceNode = dynamic_cast<WaylandSurfaceNode *>(parentNode());
+    if(parentSurfaceNode == NULL || parentSurfaceNode->surface()->size().x <= 0 || parentSurfaceNode->surface()->size().y <= 0){
+        return;
+    }
+    //place the center of this surface over the corresponding point of the parent surface, in front of it and of
+    //every sibling stacked below it so the depth test draws them in the client's order
+    glm::vec2 center = glm::vec2(m_surface->position()) + glm::vec2(m_surface->size()) / 2.0f;
+    float offset = SUBSURFACE_STACKING_OFFSET * (m_surface->stackingIndex() + 1);
+    glm::vec3 position = glm::vec3(parentSurfaceNode->surfaceTransform() *
+                                   glm::vec4(center / glm::vec2(parentSurfaceNode->surface()->size()), offset, 1));
+    setTransform(glm::translate(glm::mat4(), position));
+}
+
+bool WaylandSurfaceNode::usesAtlas() const
+{
+    //toplevels have decorations and motorcar surfaces draw themselves, neither are small enough to be worth it
+    glm::ivec2 size = m_surface->size();
+    return m_surface->type() != WaylandSurface::SurfaceType::TOPLEVEL && !m_surface->isMotorcarSurface() &&
+            m_surface->textureFormat() == WaylandSurface::TextureFormat::RGBA && m_surface->texture() != 0 &&
+            size.x > 0 && size.y > 0 && size.x <= MAX_ATLAS_SURFACE_SIZE && size.y <= MAX_ATLAS_SURFACE_SIZE;
+}
+
+void WaylandSurfaceNode::updateAtlasRegion(Scene *scene)
+{
+    if(!usesAtlas()){
+        releaseAtlasRegion();
+        return;
+    }
+
+    TextureAtlas *atlas = scene->surfaceAtlas();
+    if(atlas == NULL){
+        return;
+    }
+
+    glm::ivec2 size = m_surface->size();
+    bool stale = m_atlas == NULL || m_atlasGeneration != atlas->generation() ||
+            m_atlasRegion.z != size.x || m_atlasRegion.w != size.y;
+    if(stale){
+        releaseAtlasRegion();
+        if(!atlas->allocate(size, &m_atlasRegion)){
+            return;
+        }
+        m_atlas = atlas;
+        m_atlasGeneration = atlas->generation();
+    }
+
+    if(stale || m_atlasContentSerial != m_surface->contentSerial()){
+        m_atlas->copy(m_surface->texture(), m_atlasRegion);
+        m_atlasContentSerial = m_surface->contentSerial();
+    }
+}
+
+void WaylandSurfaceNode::releaseAtlasRegion()
+{
+    if(m_atlas != NULL){
+        m_atlas->free(m_atlasRegion, m_atlasGeneration);
+        m_atlas = NULL;
+    }
+}
+
+glm::vec2 WaylandSurfaceNode::projectedSize(Scene *scene) const
+{
+    static const glm::vec4 edgeMidpoints[] = {
+        glm::vec4(0.0f, 0.5f, 0, 1), glm::vec4(1.0f, 0.5f, 0, 1),
+        glm::vec4(0.5f, 0.0f, 0, 1), glm::vec4(0.5f, 1.0f, 0, 1)
+    };
+
+    glm::mat4 modelMatrix = this->worldTransform() * this->surfaceTransform();
+    glm::vec2 largest(0);
+    for(Display *display : scene->displays()){
+        for(ViewPoint *viewpoint : display->viewpoints()){
+            glm::mat4 mvp = viewpoint->projectionMatrix() * viewpoint->viewMatrix() * modelMatrix;
+            glm::vec2 halfViewport = glm::vec2(viewpoint->viewport()->width(), viewpoint->viewport()->height()) / 2.0f;
+
+            glm::vec2 points[4];
+            bool inFront = true;
+            for(int i = 0; i < 4 && inFront; i++){
+                glm::vec4 clip = mvp * edgeMidpoints[i];
+                inFront = clip.w > 0.0001f;
+                points[i] = glm::vec2(clip) / clip.w * halfViewport;
+            }
+            if(inFront){
+                largest = glm::max(largest, glm::vec2(glm::length(points[1] - points[0]), glm::length(points[3] - points[2])));
+            }
+        }
+    }
+    return largest;
+}
+
+void WaylandSurfaceNode::updateMipmaps(Scene *scene)
+{
+    //atlas regions have no mip chain of their own and motorcar surfaces are drawn at their native resolution
+    WaylandSurface::TextureFormat format = m_surface->textureFormat();
+    bool mipmappable = m_atlas == NULL && !m_surface->isMotorcarSurface() && m_surface->texture() != 0 &&
+            (format == WaylandSurface::TextureFormat::RGBA || format == WaylandSurface::TextureFormat::RGBX);
+    if(!mipmappable || !MipmappedTexture::isSupported()){
+        delete m_mipmappedTexture;
+        m_mipmappedTexture = NULL;
+        return;
+    }
+
+    glm::vec2 projected = projectedSize(scene);
+    if(projected.x > 0 && projected.y > 0){
+        glm::vec2 texelsPerPixel = glm::vec2(m_surface->size()) / projected;
+        float minification = glm::max(texelsPerPixel.x, texelsPerPixel.y);
+        if(m_mipmappedTexture == NULL && minification > MIPMAP_ENABLE_THRESHOLD){
+            std::ostringstream name;
+            name << "mipmaps of surface node " << this;
+            m_mipmappedTexture = new MipmappedTexture(scene->resourcePool(), name.str());
+            m_mipmappedContentSerial = m_surface->contentSerial() - 1;
+        }else if(m_mipmappedTexture != NULL && minification < MIPMAP_DISABLE_THRESHOLD){
+            delete m_mipmappedTexture;
+            m_mipmappedTexture = NULL;
+        }
+    }
+
+    //the chain is only regenerated when the client has committed new content
+    if(m_mipmappedTexture != NULL && (m_mipmappedContentSerial != m_surface->contentSerial() ||
+                                      m_mipmappedTexture->size() != m_surface->size())){
+        m_mipmappedTexture->update(m_surface->texture(), m_surface->size());
+        m_mipmappedContentSerial = m_surface->contentSerial();
+    }
+}
+
+float WaylandSurfaceNode::levelOfDetailScale() const
+{
+    if(m_surface->type() != WaylandSurface::SurfaceType::TOPLEVEL){
+        WaylandSurfaceNode *parentSurfaceNode = dynamic_cast<WaylandSurfaceNode *>(parentNode());
+        return parentSurfaceNode != NULL ? parentSurfaceNode->levelOfDetailScale() : 1.0f;
+    }
+    return m_lodScale;
+}
+
+void WaylandSurfaceNode::updateLevelOfDetail(Scene *scene)
+{
+    //motorcar surfaces are sized to the display and other surfaces are positioned in their parent's pixels
+    if(m_surface->type() != WaylandSurface::SurfaceType::TOPLEVEL || m_surface->isMotorcarSurface()){
+        return;
+    }
+
+    glm::ivec2 size = m_surface->size();
+    if(size.x <= 0 || size.y <= 0){
+        return;
+    }
+
+    if(m_pendingLodScale != m_lodScale && size == m_lodRequestedSize){
+        m_lodScale = m_pendingLodScale;
+        m_lodSize = size;
+    }else if(size != m_lodSize){
+        //the client resized itself rather than answering, so whatever it chose is its new full resolution
+        m_fullResolutionSize = size;
+        m_lodSize = size;
+        m_lodScale = 1.0f;
+        m_pendingLodScale = 1.0f;
+        m_lodCandidateFrames = 0;
+    }else if(m_pendingLodScale != m_lodScale){
+        if(++m_lodRequestFrames < LOD_REQUEST_TIMEOUT_FRAMES){
+            return;
+        }
+        //the buffer is still the size it had before the request, so it stays at its current level
+        std::cout << "Warning: surface " << m_surface << " did not answer the resize request, dropping it" << std::endl;
+        m_pendingLodScale = m_lodScale;
+    }
+
+    glm::vec2 projected = projectedSize(scene);
+    if(projected.x <= 0 || projected.y <= 0){
+        m_lodCandidateFrames = 0;
+        return;
+    }
+
+    //smallest level at which the buffer still has at least one texel per pixel on screen
+    glm::vec2 coverage = projected / glm::vec2(m_fullResolutionSize);
+    float requiredScale = glm::max(coverage.x, coverage.y);
+    float targetScale = LOD_LEVELS[0];
+    for(int i = 1; i < LOD_LEVEL_COUNT; i++){
+        float margin = LOD_LEVELS[i] < m_lodScale ? LOD_DOWNSCALE_MARGIN : 1.0f;
+        if(requiredScale <= LOD_LEVELS[i] * margin){
+            targetScale = LOD_LEVELS[i];
+        }
+    }
+
+    if(targetScale == m_lodScale){
+        m_lodCandidateFrames = 0;
+        return;
+    }
+    if(targetScale != m_lodCandidateScale){
+        m_lodCandidateScale = targetScale;
+        m_lodCandidateFrames = 0;
+    }
+    m_lodCandidateFrames++;
+    if(m_lodCandidateFrames < (targetScale < m_lodScale ? LOD_DOWNSCALE_FRAMES : LOD_UPSCALE_FRAMES)){
+        return;
+    }
+
+    m_lodRequestedSize = glm::max(glm::ivec2(glm::vec2(m_fullResolutionSize) * targetScale + 0.5f), glm::ivec2(1));
+    m_pendingLodScale = targetScale;
+    m_lodCandidateFrames = 0;
+    m_lodRequestFrames = 0;
+    m_surface->setSize(m_lodRequestedSize);
+}
+
 bool WaylandSurfaceNode::computeLocalSurfaceIntersection(const Geometry::Ray &localRay, glm::vec2 &localIntersection, float &t)
 {
     Geometry::Plane surfacePlane = Geometry::Plane(glm::vec3(0), glm::vec3(0.0f,0.0f,1.0f));
@@ -197,49 +538,35 @@ Geometry::RaySurfaceIntersection *WaylandSurfaceNode::intersectWithSurfaces(cons
     }
 }
 
-void WaylandSurfaceNode::draw(Scene *scene, Display *display)
+void WaylandSurfaceNode::snapshot(Scene *scene, FrameSnapshot *frame)
 {
-    //std::cout << "drawing surface node " << this <<std::endl;
-
-    GLuint texture = this->surface()->texture();
-
-    glUseProgram(m_surfaceShader->handle());
-
-    glEnableVertexAttribArray(h_aPosition_surface);
-    glBindBuffer(GL_ARRAY_BUFFER, m_surfaceVertexCoordinates);
-    glVertexAttribPointer(h_aPosition_surface, 3, GL_FLOAT, GL_FALSE, 0, 0);
-
-    glEnableVertexAttribArray(h_aTexCoord_surface);
-    glBindBuffer(GL_ARRAY_BUFFER, m_surfaceTextureCoordinates);
-    glVertexAttribPointer(h_aTexCoord_surface, 2, GL_FLOAT, GL_FALSE, 0, 0);
-
-
-
-    glBindTexture(GL_TEXTURE_2D, texture);
-
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    for(ViewPoint *viewpoint : display->viewpoints()){
-        viewpoint->viewport()->set();
-        glUniformMatrix4fv(h_uMVPMatrix_surface, 1, GL_FALSE, glm::value_ptr(viewpoint->projectionMatrix() * viewpoint->viewMatrix() *  this->worldTransform() * this->surfaceTransform()));
-        glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
-
+    //a region from an older generation may already have been handed to another surface
+    if(m_atlas != NULL && m_atlasGeneration == m_atlas->generation()){
+        scene->surfaceBatch()->addQuad(this->worldTransform() * this->surfaceTransform(), m_atlas->textureCoordinates(m_atlasRegion));
+        return;
     }
-    glBindTexture(GL_TEXTURE_2D, 0);
 
-    glDisableVertexAttribArray(h_aPosition_surface);
-    glDisableVertexAttribArray(h_aTexCoord_surface);
+    //the mip chain may be missing if the GPU memory budget did not allow for it
+    bool mipmapped = m_mipmappedTexture != NULL && m_mipmappedTexture->texture() != 0;
+    GLuint texture = mipmapped ? m_mipmappedTexture->texture() : this->surface()->texture();
 
-    glUseProgram(0);
+    frame->items.push_back(new Item(m_resources, this->worldTransform() * this->surfaceTransform(), texture,
+                                    this->surface()->planeTexture(1), this->surface()->planeTexture(2),
+                                    this->surface()->textureFormat(), mipmapped));
 }
 
 void WaylandSurfaceNode::handleFrameBegin(Scene *scene)
 {
     Drawable::handleFrameBegin(scene);
     if(visible()){
+        updateLevelOfDetail(scene);
         computeSurfaceTransform(8);
+        if(surface()->type() == WaylandSurface::SurfaceType::SUBSURFACE){
+            computeSubsurfaceTransform();
+        }
         surface()->prepare();
+        updateAtlasRegion(scene);
+        updateMipmaps(scene);
 
     }
 
@@ -42,6 +42,8 @@
 
 namespace motorcar {
 class WireframeNode;
+class TextureAtlas;
+class MipmappedTexture;
 class WaylandSurfaceNode : public Drawable
 {
 public:
@@ -52,12 +54,26 @@ public:
 
     ///computes surface transform
     virtual void computeSurfaceTransform(float ppcm);
+    ///positions this node relative to its parent surface node according to the subsurface position
+    void computeSubsurfaceTransform();
+
+    ///surfaces no larger than this in either dimension are drawn from the scene's surface atlas
+    static const int MAX_ATLAS_SURFACE_SIZE = 256;
+
+    ///returns the largest size in pixels this surface covers in any viewpoint of the scene's displays
+    /*measured across the middle of the surface along each of its axes, viewpoints the surface is behind
+     * are ignored, returns zero if it is not in front of any viewpoint*/
+    glm::vec2 projectedSize(Scene *scene) const;
+
+    ///returns the fraction of its full resolution this surface's client has been asked to render at
+    /*surfaces other than toplevels follow the scale of the surface they are attached to*/
+    float levelOfDetailScale() const;
 
     ///inhereted from SceneGraphNode
     virtual Geometry::RaySurfaceIntersection *intersectWithSurfaces(const Geometry::Ray &ray) override;
 
     ///inhereted from Drawable
-    virtual void draw(Scene *scene, Display *display) override;
+    virtual void snapshot(Scene *scene, FrameSnapshot *frame) override;
 
     ///prepares the surface and computes the surface transform
     virtual void handleFrameBegin(Scene *scene) override;
@@ -89,21 +105,62 @@ private:
 
     WaylandSurface *m_surface;
 
+    //region of the scene's surface atlas holding a copy of this surface, if m_atlas is not NULL
+    TextureAtlas *m_atlas;
+    glm::ivec4 m_atlasRegion;
+    unsigned int m_atlasGeneration, m_atlasContentSerial;
+
+    ///returns whether this surface should be drawn from the surface atlas rather than its own texture
+    bool usesAtlas() const;
+    ///moves the surface into or out of the atlas and copies its contents there when they changed
+    void updateAtlasRegion(Scene *scene);
+    void releaseAtlasRegion();
+
+    //mipmapped copy of the surface texture, only exists while the surface is minified on screen
+    MipmappedTexture *m_mipmappedTexture;
+    unsigned int m_mipmappedContentSerial;
+
+    ///creates or releases the mipmapped copy depending on how minified the surface is and refreshes it after commits
+    void updateMipmaps(Scene *scene);
+
+    //level of detail state, m_fullResolutionSize is the size the client chose for itself, m_lodSize the
+    //size of its buffer at m_lodScale, and the pending scale only takes effect once the client has committed
+    //a buffer of exactly m_lodRequestedSize
+    float m_lodScale, m_pendingLodScale;
+    glm::ivec2 m_fullResolutionSize, m_lodSize, m_lodRequestedSize;
+    float m_lodCandidateScale;
+    int m_lodCandidateFrames;
+    //frames the client has left the pending request unanswered
+    int m_lodRequestFrames;
+
+    ///asks the client for a smaller or larger buffer once the surface's footprint has settled at a different level
+    void updateLevelOfDetail(Scene *scene);
+
 
     bool m_mapped;
     bool m_damaged;
 
-
-    //attribute buffers
-    GLuint m_surfaceTextureCoordinates, m_surfaceVertexCoordinates;
+    class Item;
 
 protected:
 
+    ///surface shader and quad buffers, shared with the frames in flight which draw this node
+    class Resources
+    {
+    public:
+        Resources();
+        ~Resources();
+
+        OpenGLShader *surfaceShader;
+
+        //attribute buffers
+        GLuint surfaceTextureCoordinates, surfaceVertexCoordinates;
 
-    //shader variable handles
-    GLint h_aPosition_surface, h_aTexCoord_surface, h_uMVPMatrix_surface;
+        //shader variable handles
+        GLint h_aPosition_surface, h_aTexCoord_surface, h_uMVPMatrix_surface, h_uTextureFormat_surface;
+    };
 
-    OpenGLShader *m_surfaceShader;
+    std::shared_ptr<Resources> m_resources;
 
     glm::mat4 m_surfaceTransform;
     WireframeNode *m_decorationsNode;
@@ -47,50 +47,90 @@ using namespace motorcar;
 //    setSegments(segments);
 //}
 
-WireframeNode::WireframeNode(float *segments, int numSegments, glm::vec3 lineColor, SceneGraphNode *parent, const glm::mat4 &transform)
-    :Drawable(parent, transform)
-    ,m_segments(NULL)
-    ,m_numSegments(numSegments)
-    ,m_lineColor(lineColor)
-    ,m_lineShader(new motorcar::OpenGLShader(std::string("motorcarline.vert"), std::string("motorcarline.frag")))
+///draws the wireframe with the node's world transform and color at the time of the snapshot
+class WireframeNode::Item : public RenderItem
 {
-    m_segments = new float[numSegments * 2 * 3];
-    memcpy (m_segments, segments, numSegments * 2 * 3 * sizeof (float)) ;
+public:
+    Item(std::shared_ptr<WireframeNode::Resources> resources, const glm::mat4 &worldTransform, const glm::vec3 &lineColor)
+        :m_resources(resources)
+        ,m_worldTransform(worldTransform)
+        ,m_lineColor(lineColor)
+    {}
 
-    glGenBuffers(1, &m_lineVertexCoordinates);
-    h_aPosition_line =  glGetAttribLocation(m_lineShader->handle(), "aPosition");
-    h_uColor_line =  glGetUniformLocation(m_lineShader->handle(), "uColor");
-    h_uMVPMatrix_line  = glGetUniformLocation(m_lineShader->handle(), "uMVPMatrix");
+    virtual void draw(const DisplaySnapshot &display) override
+    {
+        const WireframeNode::Resources &r = *m_resources;
+        glUseProgram(r.lineShader->handle());
 
-    if(h_aPosition_line < 0 || h_uColor_line < 0 || h_uMVPMatrix_line < 0 ){
-       std::cout << "problem with line shader handles: " << h_aPosition_line << ", "<< h_uColor_line << ", " << h_uMVPMatrix_line << std::endl;
+        glEnableVertexAttribArray(r.h_aPosition_line);
+        glBindBuffer(GL_ARRAY_BUFFER, r.lineVertexCoordinates);
+        glVertexAttribPointer(r.h_aPosition_line, 3, GL_FLOAT, GL_FALSE, 0, 0);
+
+        glUniform3fv(r.h_uColor_line, 1, glm::value_ptr(m_lineColor));
+
+
+        for(const ViewpointSnapshot &viewpoint : display.viewpoints){
+            glUniformMatrix4fv(r.h_uMVPMatrix_line, 1, GL_FALSE, glm::value_ptr(viewpoint.projectionMatrix * viewpoint.viewMatrix *  m_worldTransform));
+            viewpoint.setViewport();
+            glDrawArrays(GL_LINES, 0, 2 * r.numSegments);
+
+        }
+        glDisableVertexAttribArray(r.h_aPosition_line);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        glUseProgram(0);
     }
 
-}
+private:
+    std::shared_ptr<WireframeNode::Resources> m_resources;
+    glm::mat4 m_worldTransform;
+    glm::vec3 m_lineColor;
+};
+
 
-void WireframeNode::draw(Scene *scene, Display *display)
+
+WireframeNode::Resources::Resources(float *segments, int numSegments)
+    :lineShader(new motorcar::OpenGLShader(std::string("motorcarline.vert"), std::string("motorcarline.frag")))
+    ,numSegments(numSegments)
 {
-    glUseProgram(m_lineShader->handle());
+    //the segments never change after construction, so they are uploaded once instead of every draw
+    glGenBuffers(1, &lineVertexCoordinates);
+    glBindBuffer(GL_ARRAY_BUFFER, lineVertexCoordinates);
+    glBufferData(GL_ARRAY_BUFFER, numSegments * 2 * 3 * sizeof(float), segments, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-    glEnableVertexAttribArray(h_aPosition_line);
-    glBindBuffer(GL_ARRAY_BUFFER, m_lineVertexCoordinates);
-    glVertexAttribPointer(h_aPosition_line, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    h_aPosition_line =  glGetAttribLocation(lineShader->handle(), "aPosition");
+    h_uColor_line =  glGetUniformLocation(lineShader->handle(), "uColor");
+    h_uMVPMatrix_line  = glGetUniformLocation(lineShader->handle(), "uMVPMatrix");
 
-    glBufferData(GL_ARRAY_BUFFER,  this->numSegments() * 2 * 3 * sizeof(float), this->segments(), GL_DYNAMIC_DRAW);
+    if(h_aPosition_line < 0 || h_uColor_line < 0 || h_uMVPMatrix_line < 0 ){
+       std::cout << "problem with line shader handles: " << h_aPosition_line << ", "<< h_uColor_line << ", " << h_uMVPMatrix_line << std::endl;
+    }
+}
 
-    glUniform3fv(h_uColor_line, 1, glm::value_ptr(this->lineColor()));
+WireframeNode::Resources::~Resources()
+{
+    glDeleteBuffers(1, &lineVertexCoordinates);
+    delete lineShader;
+}
 
 
-    for(ViewPoint *viewpoint : display->viewpoints()){
-        //Geometry::printMatrix(viewpoint->viewMatrix());
-        glUniformMatrix4fv(h_uMVPMatrix_line, 1, GL_FALSE, glm::value_ptr(viewpoint->projectionMatrix() * viewpoint->viewMatrix() *  this->worldTransform()));
-        viewpoint->viewport()->set();
-        glDrawArrays(GL_LINES, 0, 2 * this->numSegments());
 
-    }
-    glDisableVertexAttribArray(h_aPosition_line);
+WireframeNode::WireframeNode(float *segments, int numSegments, glm::vec3 lineColor, SceneGraphNode *parent, const glm::mat4 &transform)
+    :Drawable(parent, transform)
+    ,m_segments(NULL)
+    ,m_numSegments(numSegments)
+    ,m_lineColor(lineColor)
+{
+    m_segments = new float[numSegments * 2 * 3];
+    memcpy (m_segments, segments, numSegments * 2 * 3 * sizeof (float)) ;
+
+    m_resources = std::make_shared<Resources>(m_segments, numSegments);
+}
 
-    glUseProgram(0);
+void WireframeNode::snapshot(Scene *scene, FrameSnapshot *frame)
+{
+    frame->items.push_back(new Item(m_resources, this->worldTransform(), this->lineColor()));
 }
 
 
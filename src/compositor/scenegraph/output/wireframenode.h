@@ -47,7 +47,7 @@ public:
 
     WireframeNode(float *segments, int numSegments, glm::vec3 lineColor, SceneGraphNode *parent, const glm::mat4 &transform = glm::mat4());
 
-    virtual void draw(Scene *scene, Display *display) override;
+    virtual void snapshot(Scene *scene, FrameSnapshot *frame) override;
 
     glm::vec3 lineColor() const;
     void setLineColor(const glm::vec3 &lineColor);
@@ -60,11 +60,22 @@ private:
     int m_numSegments;
     glm::vec3 m_lineColor;
 
-    OpenGLShader *m_lineShader;
+    ///shader and segment buffer, shared with the frames in flight which draw this node
+    class Resources
+    {
+    public:
+        Resources(float *segments, int numSegments);
+        ~Resources();
 
-    GLuint m_lineVertexCoordinates;
+        OpenGLShader *lineShader;
+        GLuint lineVertexCoordinates;
+        GLint h_aPosition_line, h_uMVPMatrix_line, h_uColor_line;
+        int numSegments;
+    };
 
-    GLint h_aPosition_line, h_uMVPMatrix_line, h_uColor_line;
+    class Item;
+
+    std::shared_ptr<Resources> m_resources;
 };
 }
 
@@ -34,6 +34,12 @@
 ****************************************************************************/
 #include <scenegraph/scene.h>
 #include <windowmanager.h>
+#include <gl/textureatlas.h>
+#include <gl/gpuresourcepool.h>
+#include <scenegraph/output/framesnapshot.h>
+#include <scenegraph/input/posepredictor.h>
+
+#include <algorithm>
 
 using namespace motorcar;
 
@@ -43,7 +49,20 @@ Scene::Scene()
     ,m_trash(NULL)
     ,m_currentTimestampMillis(0)
     ,m_lastTimestepMillis(0)
-    ,m_activeDisplay(NULL)
+    ,m_frameSequence(0)
+    ,m_lastPresentedFrame(0)
+    ,m_frameStartNanos(0)
+    ,m_predictedPresentationNanos(0)
+    ,m_frameIntervalNanos(0)
+    ,m_presentationLatencyFrames(1)
+    ,m_refreshNanos(0)
+    ,m_presentationLatencyNanos(0)
+    ,m_lastPresentationNanos(0)
+    ,m_surfaceAtlas(NULL)
+    ,m_surfaceBatch(NULL)
+    ,m_surfaceAtlasSupported(true)
+    ,m_frameSnapshot(NULL)
+    ,m_resourcePool(new GpuResourcePool())
 {
 }
 
@@ -51,6 +70,15 @@ Scene::Scene()
 Scene::~Scene()
 {
     delete m_windowManager;
+    //nodes check for the window manager while they are destroyed
+    m_windowManager = NULL;
+    //surface nodes give their atlas regions back when they are destroyed, so they have to go before the atlas
+    while(!childNodes().empty()){
+        delete childNodes().front();
+    }
+    m_surfaceBatchProgram.reset();
+    delete m_surfaceAtlas;
+    delete m_resourcePool;
 }
 
 
@@ -76,31 +104,67 @@ Scene *Scene::scene()
 void Scene::prepareForFrame(long timeStampMillis)
 {
     this->setCurrentTimestampMillis(timeStampMillis);
+
+    uint64_t now = PosePredictor::monotonicNanos();
+    if(m_frameStartNanos != 0){
+        //smoothed, so a single late frame does not throw off the predictions of the next ones
+        uint64_t interval = now - m_frameStartNanos;
+        m_frameIntervalNanos = m_frameIntervalNanos == 0 ? interval : (7 * m_frameIntervalNanos + interval) / 8;
+    }
+    m_frameStartNanos = now;
+    m_frameSequence++;
+    m_frameStarts.push_back(std::make_pair(m_frameSequence, now));
+    //frames skipped by every display are never reported presented
+    while(m_frameStarts.size() > 16){
+        m_frameStarts.pop_front();
+    }
+    m_predictedPresentationNanos = refreshAtOrAfter(now + pipelineNanos());
+
     this->mapOntoSubTree(&SceneGraphNode::handleFrameBegin, this);
     for(Display *display : displays()){
         for(ViewPoint *viewpoint : display->viewpoints()){
             viewpoint->updateViewMatrix();
         }
     }
+    if(m_windowManager != NULL){
+        m_windowManager->shell()->sendFrameState(timeStampMillis + (m_predictedPresentationNanos - now) / 1000000);
+        m_windowManager->shell()->publishPoses();
+    }
 
 }
 
-void Scene::drawFrame()
+void Scene::snapshotFrame(FrameSnapshot *frame)
 {
+    frame->clear();
+    frame->timestampMillis = this->currentTimestampMillis();
+    frame->sequence = m_frameSequence;
+    frame->predictedPresentationNanos = m_predictedPresentationNanos;
     for(Display * display : this->displays()){
-        this->setActiveDisplay(display);
-        display->prepareForDraw();
-        this->mapOntoSubTree(&SceneGraphNode::handleFrameDraw, this);
-        display->finishDraw();
-
+        frame->displays.push_back(DisplaySnapshot(display));
     }
 
+    m_frameSnapshot = frame;
+    this->mapOntoSubTree(&SceneGraphNode::handleFrameSnapshot, this);
+    if(m_surfaceBatch != NULL){
+        if(m_surfaceBatch->empty()){
+            delete m_surfaceBatch;
+        }else{
+            m_surfaceBatch->upload();
+            frame->items.push_back(m_surfaceBatch);
+        }
+        m_surfaceBatch = NULL;
+    }
+    m_frameSnapshot = NULL;
 
+    //the frame may be drawn on another context, which must wait for the uploads made while snapshotting
+    frame->readyFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
 }
 
 void Scene::finishFrame()
 {
     this->mapOntoSubTree(&SceneGraphNode::handleFrameEnd, this);
+    m_resourcePool->endFrame();
 
     int error = glGetError();
     if(error != GL_NO_ERROR){
@@ -142,6 +206,22 @@ std::vector<Display *> Scene::displays() const
 {
     return m_displays;
 }
+
+void Scene::addSixDofPointingDevice(SixDOFPointingDevice *device)
+{
+    m_sixDofPointingDevices.push_back(device);
+}
+
+void Scene::removeSixDofPointingDevice(SixDOFPointingDevice *device)
+{
+    m_sixDofPointingDevices.erase(std::remove(m_sixDofPointingDevices.begin(), m_sixDofPointingDevices.end(), device),
+                                  m_sixDofPointingDevices.end());
+}
+
+std::vector<SixDOFPointingDevice *> Scene::sixDofPointingDevices() const
+{
+    return m_sixDofPointingDevices;
+}
 long Scene::currentTimestampMillis() const
 {
     return m_currentTimestampMillis;
@@ -158,14 +238,142 @@ long Scene::latestTimestampChange()
 {
     return m_currentTimestampMillis - m_lastTimestepMillis;
 }
-Display *Scene::activeDisplay() const
+uint32_t Scene::frameSequence() const
+{
+    return m_frameSequence;
+}
+
+uint64_t Scene::frameStartNanos() const
+{
+    return m_frameStartNanos;
+}
+
+uint64_t Scene::predictedPresentationNanos() const
+{
+    return m_predictedPresentationNanos;
+}
+
+uint64_t Scene::frameIntervalNanos() const
+{
+    return m_frameIntervalNanos;
+}
+
+float Scene::presentationLatencyFrames() const
+{
+    return m_presentationLatencyFrames;
+}
+
+void Scene::setPresentationLatencyFrames(float presentationLatencyFrames)
+{
+    m_presentationLatencyFrames = presentationLatencyFrames;
+}
+
+uint32_t Scene::refreshNanos() const
+{
+    return m_refreshNanos;
+}
+
+void Scene::setRefreshNanos(uint32_t refreshNanos)
+{
+    m_refreshNanos = refreshNanos;
+}
+
+bool Scene::framePresented(uint32_t frame, uint64_t presentedNanos)
+{
+    if(frame <= m_lastPresentedFrame){
+        return false;
+    }
+    m_lastPresentedFrame = frame;
+    m_lastPresentationNanos = presentedNanos;
+
+    while(!m_frameStarts.empty() && m_frameStarts.front().first < frame){
+        m_frameStarts.pop_front();
+    }
+    if(!m_frameStarts.empty() && m_frameStarts.front().first == frame && presentedNanos > m_frameStarts.front().second){
+        uint64_t latency = presentedNanos - m_frameStarts.front().second;
+        m_presentationLatencyNanos = m_presentationLatencyNanos == 0 ? latency : (7 * m_presentationLatencyNanos + latency) / 8;
+    }
+
+    if(m_windowManager != NULL){
+        m_windowManager->shell()->framePresented(frame, presentedNanos);
+    }
+    return true;
+}
+
+uint32_t Scene::lastPresentedFrame() const
+{
+    return m_lastPresentedFrame;
+}
+
+uint64_t Scene::lastPresentationNanos() const
+{
+    return m_lastPresentationNanos;
+}
+
+uint64_t Scene::frameDeadlineNanos(uint64_t *presentationNanos) const
+{
+    uint64_t pipeline = pipelineNanos();
+    uint64_t presentation = refreshAtOrAfter(PosePredictor::monotonicNanos() + pipeline);
+    if(presentationNanos != NULL){
+        *presentationNanos = presentation;
+    }
+    return presentation - pipeline;
+}
+
+uint64_t Scene::pipelineNanos() const
+{
+    if(m_presentationLatencyNanos == 0){
+        return (uint64_t) (m_frameIntervalNanos * m_presentationLatencyFrames);
+    }
+    //the measured latency includes waiting for the refresh, which on average takes half a refresh
+    uint64_t refreshWait = m_refreshNanos / 2;
+    return m_presentationLatencyNanos > refreshWait ? m_presentationLatencyNanos - refreshWait : 0;
+}
+
+uint64_t Scene::refreshAtOrAfter(uint64_t nanos) const
+{
+    if(m_refreshNanos == 0 || m_lastPresentationNanos == 0 || nanos <= m_lastPresentationNanos){
+        return nanos;
+    }
+    uint64_t refreshes = (nanos - m_lastPresentationNanos + m_refreshNanos - 1) / m_refreshNanos;
+    return m_lastPresentationNanos + refreshes * m_refreshNanos;
+}
+
+TextureAtlas *Scene::surfaceAtlas()
+{
+    if(m_surfaceAtlas == NULL && m_surfaceAtlasSupported){
+        m_surfaceAtlasSupported = TextureAtlas::isSupported();
+        if(m_surfaceAtlasSupported){
+            m_surfaceAtlas = new TextureAtlas(m_resourcePool);
+            if(m_surfaceAtlas->texture() == 0){
+                delete m_surfaceAtlas;
+                m_surfaceAtlas = NULL;
+                m_surfaceAtlasSupported = false;
+            }
+        }
+    }
+    return m_surfaceAtlas;
+}
+
+GpuResourcePool *Scene::resourcePool() const
+{
+    return m_resourcePool;
+}
+
+SurfaceBatch *Scene::surfaceBatch()
 {
-    return m_activeDisplay;
+    if(m_surfaceBatch == NULL){
+        if(m_surfaceBatchProgram == NULL){
+            m_surfaceBatchProgram = std::make_shared<SurfaceBatch::Program>();
+        }
+        m_surfaceBatch = new SurfaceBatch(m_surfaceBatchProgram, surfaceAtlas()->texture());
+    }
+    return m_surfaceBatch;
 }
 
-void Scene::setActiveDisplay(Display *activeDisplay)
+FrameSnapshot *Scene::frameSnapshot() const
 {
-    m_activeDisplay = activeDisplay;
+    return m_frameSnapshot;
 }
 
 
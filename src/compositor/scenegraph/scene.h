@@ -37,10 +37,19 @@
 
 #include <scenegraph/physicalnode.h>
 #include <scenegraph/output/display/display.h>
+#include <scenegraph/output/wayland/surfacebatch.h>
+
+#include <deque>
+#include <memory>
+#include <stdint.h>
 
 namespace motorcar {
 class WindowManager;
 class Compositor;
+class TextureAtlas;
+class GpuResourcePool;
+class FrameSnapshot;
+class SixDOFPointingDevice;
 class Scene : public PhysicalNode
 {
 public:
@@ -55,9 +64,16 @@ public:
     Scene *scene() override;
 
     void prepareForFrame(long timeStampMillis);
-    void drawFrame();
+    ///fills the given snapshot with everything needed to draw the current state of the scene graph
+    /*must be called on the main thread with the compositor's context current, after prepareForFrame.
+     * The snapshot can then be drawn by a FrameRenderer on any thread with a context sharing objects
+     * with the compositor's context, while the scenegraph moves on to the next frame*/
+    void snapshotFrame(FrameSnapshot *frame);
     void finishFrame();
 
+    ///the frame being snapshotted, NULL outside of snapshotFrame
+    FrameSnapshot *frameSnapshot() const;
+
 
     WindowManager *windowManager() const;
     void setWindowManager(WindowManager *windowManager);
@@ -68,8 +84,10 @@ public:
     void addDisplay(Display *display);
     std::vector<Display *> displays() const;
 
-    Display *activeDisplay() const;
-    void setActiveDisplay(Display *activeDisplay);
+    ///pointing devices register themselves on creation, so their poses can be shared with clients
+    void addSixDofPointingDevice(SixDOFPointingDevice *device);
+    void removeSixDofPointingDevice(SixDOFPointingDevice *device);
+    std::vector<SixDOFPointingDevice *> sixDofPointingDevices() const;
 
 
     long currentTimestampMillis() const;
@@ -77,16 +95,81 @@ public:
 
     long latestTimestampChange();
 
+    ///number of the current frame, incremented by prepareForFrame
+    uint32_t frameSequence() const;
+    ///CLOCK_MONOTONIC time at which the current frame was started by prepareForFrame, in nanoseconds
+    uint64_t frameStartNanos() const;
+    ///time at which the frame being prepared is expected to reach the display, in nanoseconds on CLOCK_MONOTONIC
+    /*estimated when the frame is started from the presentation latency, aligned to the refreshes of the display once
+     * presentations have been reported, so tracked nodes can predict their poses to it while handling the frame begin*/
+    uint64_t predictedPresentationNanos() const;
+    ///average time between the starts of recent frames, in nanoseconds
+    uint64_t frameIntervalNanos() const;
+
+    ///number of frame intervals between the start of a frame and its presentation, used until presentations are reported
+    /*depends on how the compositor pipelines drawing, one when frames are drawn and presented in the iteration that
+     * starts them, more when they are handed to a render thread first*/
+    float presentationLatencyFrames() const;
+    void setPresentationLatencyFrames(float presentationLatencyFrames);
+
+    ///time between two refreshes of the displays in nanoseconds, 0 if unknown
+    uint32_t refreshNanos() const;
+    void setRefreshNanos(uint32_t refreshNanos);
+
+    ///records that the given frame reached the display at the given time, called by the compositor on the main thread
+    /*reports the presentation to the clients that asked for feedback and tells them when to commit for the next
+     * refresh. Returns false if the frame or a newer one had already been reported, as happens when several
+     * displays present the same frame, in which case nothing is done*/
+    bool framePresented(uint32_t frame, uint64_t presentedNanos);
+    ///number of the newest frame reported presented, 0 if none has been
+    uint32_t lastPresentedFrame() const;
+    ///time at which the newest frame reported presented reached the display, 0 if none has been
+    uint64_t lastPresentationNanos() const;
+
+    ///returns the time until which content must be committed to be presented at the next refresh it can still make
+    /*that refresh is returned in presentationNanos, all times are in nanoseconds on CLOCK_MONOTONIC*/
+    uint64_t frameDeadlineNanos(uint64_t *presentationNanos) const;
+
+    ///atlas holding the contents of small surfaces, NULL if the context cannot support one
+    /*created on first use, so this must only be called while the compositor's context is current*/
+    TextureAtlas *surfaceAtlas();
+    ///quads of atlas resident surfaces collected while snapshotting the current frame
+    /*only valid during snapshotFrame, the batch is added to the frame after all other items*/
+    SurfaceBatch *surfaceBatch();
+    ///pool all long lived textures and render targets are taken from, tracking the video memory of each owner
+    GpuResourcePool *resourcePool() const;
+
 
 
 private:
     long m_currentTimestampMillis, m_lastTimestepMillis;
+    uint32_t m_frameSequence, m_lastPresentedFrame;
+    uint64_t m_frameStartNanos, m_predictedPresentationNanos, m_frameIntervalNanos;
+    float m_presentationLatencyFrames;
+    uint32_t m_refreshNanos;
+    //smoothed time from the start of a frame to its presentation, 0 until a presentation has been reported
+    uint64_t m_presentationLatencyNanos, m_lastPresentationNanos;
+    //starts of the frames which may still be reported presented, oldest first
+    std::deque<std::pair<uint32_t, uint64_t> > m_frameStarts;
+
+    ///time a frame needs from its start until it is ready to be shown at the next refresh
+    uint64_t pipelineNanos() const;
+    ///returns the first refresh of the display at or after the given time, or the time itself if refreshes are unknown
+    uint64_t refreshAtOrAfter(uint64_t nanos) const;
     WindowManager *m_windowManager;
     Compositor *m_compositor;
     Scene *m_trash;
 
     std::vector<Display *> m_displays;
-    Display *m_activeDisplay;
+    std::vector<SixDOFPointingDevice *> m_sixDofPointingDevices;
+
+    TextureAtlas *m_surfaceAtlas;
+    std::shared_ptr<SurfaceBatch::Program> m_surfaceBatchProgram;
+    SurfaceBatch *m_surfaceBatch;
+    bool m_surfaceAtlasSupported;
+
+    FrameSnapshot *m_frameSnapshot;
+    GpuResourcePool *m_resourcePool;
 
 };
 }
@@ -58,11 +58,11 @@ public:
      * this is the only place where it is safe to bind a different framebuffer without rebinding it to the current display's active framebuffer
      * the spcacial configuration of the scene should not be modified outside of this function*/
     virtual void handleFrameBegin(Scene *scene){}
-    ///draw the current node for the next frame
-    /* This function is called on ever node in the scenegraph once per display, and should be used to do drawing work for nodes that are drawable.
-     * The current active display can be accessed through the Scene and the node should draw content for every viewpoint in this display which
-     * it would like to be visible from (typically all of them)*/
-    virtual void handleFrameDraw(Scene *scene){}
+    ///snapshot the current node for the next frame
+    /* This function is called on every node in the scenegraph once per frame, after handleFrameBegin, and should be used by nodes that are drawable
+     * to add what they need to be drawn to the frame snapshot, which can be accessed through the Scene. The snapshot is drawn for every display
+     * and every viewpoint later on, possibly on another thread, so nothing may be drawn here directly*/
+    virtual void handleFrameSnapshot(Scene *scene){}
     ///cleanup after the current frame is finished
     /* this function is called once per frame on every node in the scenegraph, it should be used to clean up graphics resources to be ready for the
      * next frame. If a display does a second rendering pass it should be applied here*/
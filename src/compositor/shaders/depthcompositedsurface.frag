@@ -1,4 +1,7 @@
 uniform sampler2D uTexSampler;
+uniform sampler2D uDepthSampler;
+//0: depth is packed into the color buffer, 1: depth comes from a separate depth texture
+uniform int uDepthSource;
 
 varying vec2 vColorTexCoord;
 varying vec2 vDepthTexCoord;
@@ -13,7 +16,11 @@ float unpack_depth(vec4 rgba ) {
 void main(void)
 {
 
-    gl_FragDepth = unpack_depth(texture2D(uTexSampler, vDepthTexCoord));
+    if(uDepthSource == 1){
+        gl_FragDepth = texture2D(uDepthSampler, vDepthTexCoord).r;
+    }else{
+        gl_FragDepth = unpack_depth(texture2D(uTexSampler, vDepthTexCoord));
+    }
     gl_FragColor = texture2D(uTexSampler, vColorTexCoord);
 }
 
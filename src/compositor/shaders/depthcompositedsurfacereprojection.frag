@@ -0,0 +1,20 @@
+uniform sampler2D uTexSampler;
+
+//part of the viewport the client actually drew, as (left, bottom, right, top) in grid coordinates
+uniform vec4 uValidRegion;
+
+varying vec2 vColorTexCoord;
+varying vec2 vGridCoord;
+varying float vDiscontinuity;
+
+void main(void)
+{
+    //interpolates to nonzero across every triangle with a vertex at a discontinuity
+    if(vDiscontinuity > 0.0){
+        discard;
+    }
+    if(any(lessThan(vGridCoord, uValidRegion.xy)) || any(greaterThan(vGridCoord, uValidRegion.zw))){
+        discard;
+    }
+    gl_FragColor = texture2D(uTexSampler, vColorTexCoord);
+}
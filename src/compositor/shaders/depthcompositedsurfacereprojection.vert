@@ -0,0 +1,74 @@
+
+//position of the vertex in the viewpoint's viewport the client frame was drawn for, from 0 to 1
+attribute vec2 aGridCoord;
+
+uniform sampler2D uTexSampler;
+uniform sampler2D uDepthSampler;
+//0: depth is packed into the color buffer, 1: depth comes from a separate depth texture
+uniform int uDepthSource;
+
+//normalized viewports of the color and depth data in the client buffer
+uniform vec4 uColorViewport;
+uniform vec4 uDepthViewport;
+
+//maps clip space of the client frame to clip space of the current frame
+uniform mat4 uReprojectionMatrix;
+
+//distance between neighbouring grid vertices in grid coordinates
+uniform vec2 uGridStep;
+//largest ratio between the distances of neighbouring vertices which is still treated as one continuous surface
+uniform float uMaxDepthRatio;
+
+varying vec2 vColorTexCoord;
+varying vec2 vGridCoord;
+//nonzero for triangles spanning a depth discontinuity or the far plane, which are discarded
+varying float vDiscontinuity;
+
+
+float unpack_depth(vec4 rgba ) {
+  float depth = dot(rgba, vec4(1.0, 1.0/255.0, 1.0/65025.0, 1.0/160581375.0));
+  depth = (depth==0.0) ? 1.0 : depth;
+  return depth;
+}
+
+vec2 bufferCoord(vec4 viewport, vec2 gridCoord)
+{
+    return vec2(viewport.x + gridCoord.x * viewport.z, 1.0 - (viewport.y + gridCoord.y * viewport.w));
+}
+
+float sampleDepth(vec2 gridCoord)
+{
+    vec2 depthTexCoord = bufferCoord(uDepthViewport, clamp(gridCoord, 0.0, 1.0));
+    if(uDepthSource == 1){
+        return texture2DLod(uDepthSampler, depthTexCoord, 0.0).r;
+    }
+    return unpack_depth(texture2DLod(uTexSampler, depthTexCoord, 0.0));
+}
+
+//1 - depth is roughly proportional to the inverse of the eye distance, so this is the ratio of the distances
+float depthRatio(float a, float b)
+{
+    float nearA = max(1.0 - a, 0.000001);
+    float nearB = max(1.0 - b, 0.000001);
+    return max(nearA, nearB) / min(nearA, nearB);
+}
+
+void main(void)
+{
+    vColorTexCoord = bufferCoord(uColorViewport, aGridCoord);
+    vGridCoord = aGridCoord;
+
+    float depth = sampleDepth(aGridCoord);
+
+    /*a grid cell spanning an object's silhouette would be stretched between the object and whatever lies behind it
+     * once the viewpoint moves, so every triangle touching a vertex next to such a jump, or on the far plane where
+     * the client drew nothing, is dropped. This leaves a hole of up to one grid cell along silhouettes rather
+     * than a rubber sheet*/
+    float ratio = max(max(depthRatio(depth, sampleDepth(aGridCoord + vec2(uGridStep.x, 0.0))),
+                          depthRatio(depth, sampleDepth(aGridCoord - vec2(uGridStep.x, 0.0)))),
+                      max(depthRatio(depth, sampleDepth(aGridCoord + vec2(0.0, uGridStep.y))),
+                          depthRatio(depth, sampleDepth(aGridCoord - vec2(0.0, uGridStep.y)))));
+    vDiscontinuity = (depth >= 1.0 || ratio > uMaxDepthRatio) ? 1.0 : 0.0;
+
+    gl_Position = uReprojectionMatrix * vec4(aGridCoord * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+}
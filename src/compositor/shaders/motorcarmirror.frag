@@ -0,0 +1,7 @@
+uniform sampler2D uTexSampler;
+varying vec2 vTexCoord;
+
+void main(void)
+{
+    gl_FragColor = texture2D(uTexSampler, vTexCoord);
+}
@@ -0,0 +1,12 @@
+attribute vec3 aPosition;
+
+//fraction of the framebuffer the mirrored image covers on each axis, so its aspect ratio is kept
+uniform vec2 uScale;
+
+varying vec2 vTexCoord;
+
+void main(void)
+{
+    vTexCoord = aPosition.xy * 0.5 + 0.5;
+    gl_Position = vec4(aPosition.xy * uScale, 0, 1);
+}
@@ -1,9 +1,38 @@
 //precision highp float;
 
 uniform sampler2D uTexSampler;
+//chroma planes of YUV surfaces: interleaved UV for NV12, U and V for YUV420
+uniform sampler2D uTexSamplerU;
+uniform sampler2D uTexSamplerV;
+//matches motorcar::WaylandSurface::TextureFormat
+uniform int uTextureFormat;
 varying vec2 vTexCoord;
 
+const int RGBA = 0;
+const int RGBX = 1;
+const int NV12 = 2;
+const int YUV420 = 3;
+
+//BT.601 limited range
+vec3 yuvToRgb(float y, vec2 uv)
+{
+    y = 1.164 * (y - 0.0625);
+    uv = uv - 0.5;
+    return vec3(y + 1.596 * uv.y,
+                y - 0.391 * uv.x - 0.813 * uv.y,
+                y + 2.018 * uv.x);
+}
+
 void main(void)
 {
-    gl_FragColor = texture2D(uTexSampler, vTexCoord);
+    if(uTextureFormat == RGBX){
+        gl_FragColor = vec4(texture2D(uTexSampler, vTexCoord).rgb, 1.0);
+    }else if(uTextureFormat == NV12){
+        gl_FragColor = vec4(yuvToRgb(texture2D(uTexSampler, vTexCoord).r, texture2D(uTexSamplerU, vTexCoord).rg), 1.0);
+    }else if(uTextureFormat == YUV420){
+        vec2 uv = vec2(texture2D(uTexSamplerU, vTexCoord).r, texture2D(uTexSamplerV, vTexCoord).r);
+        gl_FragColor = vec4(yuvToRgb(texture2D(uTexSampler, vTexCoord).r, uv), 1.0);
+    }else{
+        gl_FragColor = texture2D(uTexSampler, vTexCoord);
+    }
 }
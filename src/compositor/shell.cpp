@@ -36,9 +36,28 @@
 #include <scenegraph/scene.h>
 #include <compositor.h>
 #include <windowmanager.h>
+#include <scenegraph/input/posepredictor.h>
+#include <scenegraph/input/sixdofpointingdevice.h>
+#include <wayland/output/posechannel.h>
+#include <wayland/output/presentationfeedback.h>
+
+#include <algorithm>
+#include <cstring>
+#include <unistd.h>
 
 using namespace motorcar;
 
+namespace {
+///layout of one viewpoint in the array sent by motorcar_shell.frame_state
+struct FrameStateRecord{
+    uint32_t viewpoint;
+    float view[16];
+    float projection[16];
+    int32_t colorViewport[4];
+    int32_t depthViewport[4];
+};
+}
+
 
 
 void get_motorcar_surface(struct wl_client *client,
@@ -77,7 +96,7 @@ void get_motorcar_surface(struct wl_client *client,
 
     MotorcarSurfaceNode *mcsn = static_cast<MotorcarSurfaceNode *> (shell->scene()->windowManager()->createSurface(surface));
 
-    mcsn->configureResource(client, id);
+    mcsn->configureResource(client, id, wl_resource_get_version(resource));
 
 
 }
@@ -153,7 +172,12 @@ void get_xdg_surface(struct wl_client *client,
 
 
 const static struct motorcar_shell_interface motorcarShellInterface = {
-    get_motorcar_surface
+    get_motorcar_surface,
+    Shell::handle_get_pose_channel
+};
+
+const static struct motorcar_pose_channel_interface motorcarPoseChannelInterface = {
+    Shell::handle_destroy_pose_channel
 };
 const static struct xdg_shell_interface xdgShellInterface = {
   //xdg_surface_interface_destroy,
@@ -191,12 +215,218 @@ Shell::Shell(Scene *scene)
 Shell::~Shell()
 {
     //todo: destroy the shell global
+    while(!m_poseChannels.empty()){
+        wl_resource_destroy(m_poseChannels.begin()->first);
+    }
+    for(PresentationFeedback *feedback : m_latchedFeedback){
+        delete feedback;
+    }
 }
 Scene *Shell::scene() const
 {
     return m_scene;
 }
 
+void Shell::sendFrameState(uint32_t presentationTime)
+{
+    struct wl_array state;
+    wl_array_init(&state);
+
+    for(FrameStateClient &frameStateClient : m_frameStateClients){
+        state.size = 0;
+        frameState(wl_resource_get_client(frameStateClient.resource), &state);
+
+        const char *data = static_cast<const char *>(state.data);
+        if(state.size == frameStateClient.sentState.size() &&
+                (state.size == 0 || std::memcmp(data, &frameStateClient.sentState[0], state.size) == 0)){
+            continue;
+        }
+        frameStateClient.sentState.assign(data, data + state.size);
+        frameStateClient.serial++;
+        motorcar_shell_send_frame_state(frameStateClient.resource, frameStateClient.serial, presentationTime,
+                                        sizeof(FrameStateRecord), &state);
+    }
+
+    wl_array_release(&state);
+}
+
+bool Shell::sendsFrameState(wl_client *client) const
+{
+    for(const FrameStateClient &frameStateClient : m_frameStateClients){
+        if(wl_resource_get_client(frameStateClient.resource) == client){
+            return true;
+        }
+    }
+    return false;
+}
+
+void Shell::publishPoses()
+{
+    uint64_t timestamp = PosePredictor::monotonicNanos();
+    //tracked nodes have been moved to their predicted poses for this frame
+    uint64_t poseTimestamp = m_scene->predictedPresentationNanos();
+    std::vector<PoseChannel::Pose> poses;
+
+    std::lock_guard<std::mutex> lock(m_poseChannelsMutex);
+    for(std::pair<wl_resource * const, PoseChannel *> &channel : m_poseChannels){
+        wl_client *client = wl_resource_get_client(channel.first);
+        poses.clear();
+
+        for(Display *display : m_scene->displays()){
+            for(ViewPoint *viewpoint : display->viewpoints()){
+                wl_resource *viewpointResource = viewpoint->resourceForClient(client);
+                if(viewpointResource != NULL){
+                    PoseChannel::Pose pose = {wl_resource_get_id(viewpointResource), MOTORCAR_POSE_CHANNEL_POSE_TYPE_VIEWPOINT,
+                                              poseTimestamp, viewpoint->viewMatrix(), viewpoint};
+                    poses.push_back(pose);
+                }
+            }
+        }
+        for(SixDOFPointingDevice *device : m_scene->sixDofPointingDevices()){
+            wl_resource *pointerResource = device->resourceForClient(client);
+            if(pointerResource != NULL){
+                PoseChannel::Pose pose = {wl_resource_get_id(pointerResource), MOTORCAR_POSE_CHANNEL_POSE_TYPE_SIX_DOF_POINTER,
+                                          poseTimestamp, device->worldTransform(), device};
+                poses.push_back(pose);
+            }
+        }
+
+        channel.second->publish(poses, timestamp);
+    }
+}
+
+void Shell::updatePose(const void *source, uint64_t poseTimestamp, const glm::mat4 &pose)
+{
+    uint64_t timestamp = PosePredictor::monotonicNanos();
+    std::lock_guard<std::mutex> lock(m_poseChannelsMutex);
+    for(std::pair<wl_resource * const, PoseChannel *> &channel : m_poseChannels){
+        channel.second->updatePose(source, poseTimestamp, pose, timestamp);
+    }
+}
+
+void Shell::addPresentationFeedback(PresentationFeedback *feedback)
+{
+    m_latchedFeedback.push_back(feedback);
+}
+
+void Shell::supersedePresentationFeedback(const void *owner, uint32_t frame)
+{
+    for(PresentationFeedback *feedback : m_latchedFeedback){
+        if(feedback->owner() == owner){
+            feedback->supersede(frame);
+        }
+    }
+}
+
+void Shell::discardPresentationFeedback(const void *owner)
+{
+    std::vector<PresentationFeedback *>::iterator it = m_latchedFeedback.begin();
+    while(it != m_latchedFeedback.end()){
+        if((*it)->owner() == owner){
+            delete *it;
+            it = m_latchedFeedback.erase(it);
+        }else{
+            it++;
+        }
+    }
+}
+
+void Shell::framePresented(uint32_t frame, uint64_t presentedNanos)
+{
+    uint32_t refresh = m_scene->refreshNanos();
+
+    std::vector<PresentationFeedback *>::iterator it = m_latchedFeedback.begin();
+    while(it != m_latchedFeedback.end()){
+        if((*it)->framePresented(frame, presentedNanos, refresh)){
+            delete *it;
+            it = m_latchedFeedback.erase(it);
+        }else{
+            it++;
+        }
+    }
+
+    uint64_t presentation;
+    uint64_t deadline = m_scene->frameDeadlineNanos(&presentation);
+    for(FrameStateClient &frameStateClient : m_frameStateClients){
+        if(wl_resource_get_version(frameStateClient.resource) >= MOTORCAR_SHELL_FRAME_TIMING_SINCE_VERSION){
+            motorcar_shell_send_frame_timing(frameStateClient.resource, (uint32_t) (deadline >> 32), (uint32_t) deadline,
+                                             (uint32_t) (presentation >> 32), (uint32_t) presentation, refresh);
+        }
+    }
+}
+
+void Shell::frameState(wl_client *client, wl_array *state) const
+{
+    for(Display *display : m_scene->displays()){
+        for(ViewPoint *viewpoint : display->viewpoints()){
+            wl_resource *viewpointResource = viewpoint->resourceForClient(client);
+            if(viewpointResource == NULL){
+                continue;
+            }
+
+            FrameStateRecord *record = static_cast<FrameStateRecord *>(wl_array_add(state, sizeof(FrameStateRecord)));
+            record->viewpoint = wl_resource_get_id(viewpointResource);
+            std::memcpy(record->view, glm::value_ptr(viewpoint->viewMatrix()), sizeof(record->view));
+            std::memcpy(record->projection, glm::value_ptr(viewpoint->projectionMatrix()), sizeof(record->projection));
+
+            ViewPort *color = viewpoint->clientColorViewport();
+            ViewPort *depth = viewpoint->clientDepthViewport();
+            const int32_t colorViewport[4] = {(int32_t) color->offsetX(), (int32_t) color->offsetY(), (int32_t) color->width(), (int32_t) color->height()};
+            const int32_t depthViewport[4] = {(int32_t) depth->offsetX(), (int32_t) depth->offsetY(), (int32_t) depth->width(), (int32_t) depth->height()};
+            std::memcpy(record->colorViewport, colorViewport, sizeof(colorViewport));
+            std::memcpy(record->depthViewport, depthViewport, sizeof(depthViewport));
+        }
+    }
+}
+
+void Shell::handle_get_pose_channel(wl_client *client, wl_resource *resource, uint32_t id)
+{
+    Shell *shell = static_cast<Shell *>(resource->data);
+
+    PoseChannel *channel = new PoseChannel();
+    int fd = channel->isValid() ? channel->readOnlyFd() : -1;
+    if(fd < 0){
+        delete channel;
+        wl_resource_post_no_memory(resource);
+        return;
+    }
+
+    struct wl_resource *channelResource = wl_resource_create(client, &motorcar_pose_channel_interface, 1, id);
+    wl_resource_set_implementation(channelResource, &motorcarPoseChannelInterface, shell, Shell::destroy_pose_channel_func);
+    {
+        std::lock_guard<std::mutex> lock(shell->m_poseChannelsMutex);
+        shell->m_poseChannels[channelResource] = channel;
+    }
+
+    //the fd is duplicated into the message, the read only descriptor is only needed to send it
+    motorcar_pose_channel_send_region(channelResource, fd, channel->size());
+    close(fd);
+}
+
+void Shell::handle_destroy_pose_channel(wl_client *client, wl_resource *resource)
+{
+    wl_resource_destroy(resource);
+}
+
+void Shell::destroy_pose_channel_func(wl_resource *resource)
+{
+    Shell *shell = static_cast<Shell *>(resource->data);
+    std::lock_guard<std::mutex> lock(shell->m_poseChannelsMutex);
+    std::map<struct wl_resource *, PoseChannel *>::iterator it = shell->m_poseChannels.find(resource);
+    if(it != shell->m_poseChannels.end()){
+        delete it->second;
+        shell->m_poseChannels.erase(it);
+    }
+}
+
+void Shell::destroy_func(struct wl_resource *resource)
+{
+    Shell *shell = static_cast<Shell *>(resource->data);
+    shell->m_frameStateClients.erase(std::remove_if(shell->m_frameStateClients.begin(), shell->m_frameStateClients.end(),
+                                                    [resource](const FrameStateClient &client){ return client.resource == resource; }),
+                                     shell->m_frameStateClients.end());
+}
+
 
 
 
@@ -206,7 +436,14 @@ void Shell::bind_func(struct wl_client *client, void *data,
 {
     std::cout << "Shell Bind function Called" <<std::endl;
     struct wl_resource *resource = wl_resource_create(client, &motorcar_shell_interface, version, id);
-    wl_resource_set_implementation(resource, &motorcarShellInterface, data, 0);
+    wl_resource_set_implementation(resource, &motorcarShellInterface, data, Shell::destroy_func);
+
+    if(version >= MOTORCAR_SHELL_FRAME_STATE_SINCE_VERSION){
+        FrameStateClient frameStateClient;
+        frameStateClient.resource = resource;
+        frameStateClient.serial = 0;
+        static_cast<Shell *>(data)->m_frameStateClients.push_back(frameStateClient);
+    }
 }
 
 void Shell::bind_func2(struct wl_client *client, void *data,
@@ -42,9 +42,15 @@
 
 #include <scenegraph/output/viewpoint.h>
 
+#include <map>
+#include <mutex>
+#include <vector>
+
 
 namespace motorcar {
 class Scene;
+class PoseChannel;
+class PresentationFeedback;
 class Shell
 {
 public:
@@ -53,9 +59,59 @@ public:
 
     Scene *scene() const;
 
+    ///sends a frame_state event to every client whose viewpoint state changed since the last one it was sent
+    /*called once per frame after the viewpoints have been updated, presentationTime is the time in milliseconds
+     * at which the frame is expected to be presented*/
+    void sendFrameState(uint32_t presentationTime);
+    ///returns whether the client receives viewpoint state through frame_state instead of the viewpoint events
+    bool sendsFrameState(wl_client *client) const;
+
+    ///writes the current poses of the viewpoints and pointers each client has bound into its pose channels
+    void publishPoses();
+    ///replaces the pose of the given viewpoint or pointer in every pose channel it was last published into
+    /*may be called from any thread, so trackers polled on their own thread can hand clients a pose as soon as
+     * it is measured rather than at the next frame. poseTimestamp is when the pose holds, on CLOCK_MONOTONIC*/
+    void updatePose(const void *source, uint64_t poseTimestamp, const glm::mat4 &pose);
+
+    ///takes over feedback whose content has been picked up by a frame, until a frame showing it is presented
+    void addPresentationFeedback(PresentationFeedback *feedback);
+    ///marks the content of the owner's feedback as replaced by content picked up by the given frame
+    void supersedePresentationFeedback(const void *owner, uint32_t frame);
+    ///reports all of the owner's feedback as discarded, called when its surface goes away
+    void discardPresentationFeedback(const void *owner);
+    ///reports the feedback the frame's presentation concerns and sends frame_timing to every client which supports it
+    /*called by the scene once per presented frame, before the frame callbacks are done*/
+    void framePresented(uint32_t frame, uint64_t presentedNanos);
+
+    static void handle_get_pose_channel(struct wl_client *client,
+                                        struct wl_resource *resource,
+                                        uint32_t id);
+    static void handle_destroy_pose_channel(struct wl_client *client,
+                                            struct wl_resource *resource);
+
 private:
+    struct FrameStateClient{
+        struct wl_resource *resource;
+        uint32_t serial;
+        ///records of the last frame_state sent, to skip frames in which nothing changed
+        std::vector<char> sentState;
+    };
+
     Scene *m_scene;
     struct wl_display *m_display;
+    std::vector<FrameStateClient> m_frameStateClients;
+    std::map<struct wl_resource *, PoseChannel *> m_poseChannels;
+    //guards m_poseChannels against updatePose() from other threads
+    std::mutex m_poseChannelsMutex;
+    //feedback whose content has been picked up by a frame, in the order it was picked up
+    std::vector<PresentationFeedback *> m_latchedFeedback;
+
+    ///fills the array with the frame_state record of every viewpoint the client has bound
+    void frameState(wl_client *client, struct wl_array *state) const;
+
+    static void destroy_func(struct wl_resource *resource);
+    static void destroy_pose_channel_func(struct wl_resource *resource);
+
     static void bind_func(struct wl_client *client, void *data,
                           uint32_t version, uint32_t id);
     static void bind_func2(struct wl_client *client, void *data,
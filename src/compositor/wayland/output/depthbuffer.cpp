@@ -0,0 +1,213 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#include <wayland/output/depthbuffer.h>
+
+#include <iostream>
+
+using namespace motorcar;
+
+DepthBuffer::DepthBuffer()
+    :m_pool(NULL)
+    ,m_texture(0)
+    ,m_size(0)
+    ,m_format(Format::DEPTH16)
+{
+}
+
+DepthBuffer::~DepthBuffer()
+{
+    for(Pending &pending : m_pending){
+        forget(pending);
+    }
+    releaseTexture();
+}
+
+bool DepthBuffer::isSupportedBuffer(wl_resource *buffer)
+{
+    return buffer != NULL && wl_shm_buffer_get(buffer) != NULL;
+}
+
+bool DepthBuffer::hasValidStride(wl_resource *buffer, Format format)
+{
+    struct wl_shm_buffer *shmBuffer = wl_shm_buffer_get(buffer);
+    int stride = wl_shm_buffer_get_stride(shmBuffer);
+    int bpp = bytesPerPixel(format);
+    //the upload reads rows of stride / bpp values, so anything else would read past the row or skew it
+    return stride % bpp == 0 && stride >= wl_shm_buffer_get_width(shmBuffer) * bpp;
+}
+
+int DepthBuffer::bytesPerPixel(Format format)
+{
+    return format == Format::DEPTH24 ? 4 : 2;
+}
+
+void DepthBuffer::attach(wl_resource *buffer, Format format, unsigned int commitSerial)
+{
+    if(!m_pending.empty() && m_pending.back().commitSerial == commitSerial){
+        //replaced before it was committed, so the client never handed it over
+        forget(m_pending.back());
+        m_pending.pop_back();
+    }
+
+    m_pending.push_back(Pending());
+    Pending &pending = m_pending.back();
+    pending.depthBuffer = this;
+    pending.buffer = buffer;
+    pending.format = format;
+    pending.commitSerial = commitSerial;
+    pending.destroyListener.notify = DepthBuffer::handlePendingBufferDestroyed;
+    if(buffer != NULL){
+        wl_resource_add_destroy_listener(buffer, &pending.destroyListener);
+    }else{
+        wl_list_init(&pending.destroyListener.link);
+    }
+}
+
+bool DepthBuffer::hasPending() const
+{
+    return !m_pending.empty();
+}
+
+void DepthBuffer::latch(unsigned int commitSerial, GpuResourcePool *pool, const void *owner)
+{
+    std::list<Pending>::iterator latched = m_pending.end();
+    for(std::list<Pending>::iterator it = m_pending.begin(); it != m_pending.end() && it->commitSerial <= commitSerial; it++){
+        latched = it;
+    }
+    if(latched == m_pending.end()){
+        return;
+    }
+
+    std::list<Pending>::iterator it = m_pending.begin();
+    while(it != latched){
+        //its commit's content was replaced before it reached the textures
+        if(it->buffer != NULL){
+            wl_buffer_send_release(it->buffer);
+        }
+        forget(*it);
+        it = m_pending.erase(it);
+    }
+
+    struct wl_resource *buffer = latched->buffer;
+    Format format = latched->format;
+    forget(*latched);
+    m_pending.erase(latched);
+
+    if(buffer == NULL){
+        releaseTexture();
+        return;
+    }
+    upload(buffer, format, pool, owner);
+}
+
+void DepthBuffer::upload(wl_resource *buffer, Format format, GpuResourcePool *pool, const void *owner)
+{
+    struct wl_shm_buffer *shmBuffer = wl_shm_buffer_get(buffer);
+    glm::ivec2 size(wl_shm_buffer_get_width(shmBuffer), wl_shm_buffer_get_height(shmBuffer));
+    GLenum internalFormat = format == Format::DEPTH24 ? GL_DEPTH_COMPONENT24 : GL_DEPTH_COMPONENT16;
+    GLenum type = format == Format::DEPTH24 ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
+
+    if(m_texture == 0 || size != m_size || format != m_format){
+        releaseTexture();
+        m_pool = pool;
+        m_texture = pool->acquireTexture(owner, internalFormat, size);
+        if(m_texture == 0){
+            //drawn without separate depth until a buffer fits, the client still gets its buffer back
+            wl_buffer_send_release(buffer);
+            return;
+        }
+        glBindTexture(GL_TEXTURE_2D, m_texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+        m_size = size;
+        m_format = format;
+    }
+    glBindTexture(GL_TEXTURE_2D, m_texture);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, wl_shm_buffer_get_stride(shmBuffer) / bytesPerPixel(format));
+    wl_shm_buffer_begin_access(shmBuffer);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size.x, size.y, GL_DEPTH_COMPONENT, type, wl_shm_buffer_get_data(shmBuffer));
+    wl_shm_buffer_end_access(shmBuffer);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    //the contents have been copied, so the client may reuse the buffer right away
+    wl_buffer_send_release(buffer);
+}
+
+GLuint DepthBuffer::texture() const
+{
+    return m_texture;
+}
+
+glm::ivec2 DepthBuffer::size() const
+{
+    return m_size;
+}
+
+void DepthBuffer::releaseTexture()
+{
+    if(m_texture != 0){
+        m_pool->releaseTexture(m_texture);
+        m_texture = 0;
+    }
+    m_size = glm::ivec2(0);
+}
+
+void DepthBuffer::forget(Pending &pending)
+{
+    wl_list_remove(&pending.destroyListener.link);
+    wl_list_init(&pending.destroyListener.link);
+}
+
+void DepthBuffer::handlePendingBufferDestroyed(wl_listener *listener, void *data)
+{
+    Pending *pending = wl_container_of(listener, pending, destroyListener);
+    DepthBuffer *depthBuffer = pending->depthBuffer;
+    std::cout << "Warning: client destroyed a pending depth buffer before it was used" << std::endl;
+    //the resource's destroy signal is being emitted, which tolerates listeners being removed and freed
+    wl_list_remove(&pending->destroyListener.link);
+    for(std::list<Pending>::iterator it = depthBuffer->m_pending.begin(); it != depthBuffer->m_pending.end(); it++){
+        if(&*it == pending){
+            depthBuffer->m_pending.erase(it);
+            break;
+        }
+    }
+}
@@ -0,0 +1,117 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#ifndef DEPTHBUFFER_H
+#define DEPTHBUFFER_H
+
+#include <gl/gpuresourcepool.h>
+
+#include <wayland-server.h>
+#include <wayland-server-protocol.h>
+#include <glm/glm.hpp>
+#include <GL/gl.h>
+
+#include <list>
+
+namespace motorcar {
+///Depth texture holding the contents of the depth buffer a motorcar client attached to its surface
+/*Clients attach a shared memory buffer of depth values alongside their color buffer. It is held as pending
+ * until the color content of the commit it was attached for reaches the surface's textures, then its contents
+ * are uploaded into a depth texture, which the compositor samples directly when depth compositing, and the
+ * buffer is released back to the client. Color content may lag behind the client's commits, so buffers of
+ * several commits can be pending at once.
+ *
+ * Must only be used while the compositor's OpenGL context is current*/
+class DepthBuffer
+{
+public:
+    ///Layout of the depth values in the attached buffer, matches motorcar_surface.depth_format
+    /*DEPTH16 stores a 16 bit unsigned normalized value per pixel, DEPTH24 a 32 bit unsigned normalized
+     * value of which at least 24 bits are kept*/
+    enum Format{
+        DEPTH16,
+        DEPTH24
+    };
+
+    DepthBuffer();
+    ~DepthBuffer();
+
+    ///returns whether the buffer can be attached as a depth buffer, only shared memory buffers can
+    static bool isSupportedBuffer(struct wl_resource *buffer);
+    ///returns whether the rows of the shared memory buffer are whole multiples of the format's values, each holding the full width
+    static bool hasValidStride(struct wl_resource *buffer, Format format);
+
+    ///sets the buffer to use from the commit with the given WaylandSurface::commitSerial() on, NULL removes the depth buffer
+    /*attaching again for the same commit replaces the buffer attached before*/
+    void attach(struct wl_resource *buffer, Format format, unsigned int commitSerial);
+    ///returns whether there are attached buffers whose commit's content has not been latched yet
+    bool hasPending() const;
+    ///uploads the newest buffer attached for a commit up to the given one, or releases the texture if NULL was attached
+    /*the given serial is the commit whose color content the surface's textures now hold. Buffers of earlier commits
+     * were never shown and are only released to the client. The texture is taken from the pool and charged to owner,
+     * if the pool's budget is exhausted the depth buffer is dropped*/
+    void latch(unsigned int commitSerial, GpuResourcePool *pool, const void *owner);
+
+    ///returns the depth texture, 0 if no depth buffer is attached
+    GLuint texture() const;
+    glm::ivec2 size() const;
+
+private:
+    struct Pending{
+        struct wl_listener destroyListener;
+        DepthBuffer *depthBuffer;
+        struct wl_resource *buffer;
+        Format format;
+        unsigned int commitSerial;
+    };
+    //oldest first, list nodes do not move so the listeners stay valid
+    std::list<Pending> m_pending;
+
+    GpuResourcePool *m_pool;
+    GLuint m_texture;
+    glm::ivec2 m_size;
+    Format m_format;
+
+    static int bytesPerPixel(Format format);
+    void releaseTexture();
+    ///uploads the buffer into the texture and releases it to the client
+    void upload(struct wl_resource *buffer, Format format, GpuResourcePool *pool, const void *owner);
+
+    ///stops listening for the destruction of the entry's buffer, the entry still has to be erased
+    static void forget(Pending &pending);
+    static void handlePendingBufferDestroyed(struct wl_listener *listener, void *data);
+};
+}
+
+#endif // DEPTHBUFFER_H
@@ -0,0 +1,261 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#include <wayland/output/posechannel.h>
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <string>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+#ifndef MFD_ALLOW_SEALING
+#define MFD_ALLOW_SEALING 0x0002U
+#endif
+
+using namespace motorcar;
+
+namespace {
+//layouts of the region as documented in motorcar_pose_channel
+struct RegionHeader{
+    std::atomic<uint32_t> sequence;
+    uint32_t recordCount;
+    uint32_t recordStride;
+    uint32_t reserved0;
+    uint64_t timestampNanos;
+    uint64_t reserved1;
+};
+
+struct RegionRecord{
+    uint32_t objectId;
+    uint32_t type;
+    uint64_t timestampNanos;
+    float pose[16];
+};
+
+static_assert(sizeof(RegionHeader) == 32, "pose channel header must match the protocol layout");
+static_assert(sizeof(RegionRecord) == 80, "pose channel record must match the protocol layout");
+
+///returns an anonymous file of the given size, or -1 on failure
+int createAnonymousFile(size_t size)
+{
+    int fd = -1;
+#ifdef SYS_memfd_create
+    fd = syscall(SYS_memfd_create, "motorcar-poses", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+#endif
+    bool sealable = fd >= 0;
+
+    if(fd < 0){
+        //kernels without memfd, use an unlinked file in the runtime directory instead
+        const char *runtimeDir = getenv("XDG_RUNTIME_DIR");
+        if(runtimeDir == NULL){
+            std::cout << "Warning: cannot create pose channel, XDG_RUNTIME_DIR is not set" << std::endl;
+            return -1;
+        }
+        std::string path = std::string(runtimeDir) + "/motorcar-poses-XXXXXX";
+        std::vector<char> name(path.begin(), path.end());
+        name.push_back('\0');
+        fd = mkstemp(&name[0]);
+        if(fd < 0){
+            std::cout << "Warning: cannot create pose channel file: " << strerror(errno) << std::endl;
+            return -1;
+        }
+        unlink(&name[0]);
+        fcntl(fd, F_SETFD, fcntl(fd, F_GETFD) | FD_CLOEXEC);
+    }
+
+    if(ftruncate(fd, size) < 0){
+        std::cout << "Warning: cannot resize pose channel: " << strerror(errno) << std::endl;
+        close(fd);
+        return -1;
+    }
+
+#ifdef F_ADD_SEALS
+    if(sealable){
+        //clients must not be able to shrink the file under the compositor's mapping
+        fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL);
+    }
+#else
+    (void) sealable;
+#endif
+    return fd;
+}
+}
+
+PoseChannel::PoseChannel(size_t capacity)
+    :m_fd(-1)
+    ,m_data(NULL)
+    ,m_size(sizeof(RegionHeader) + capacity * sizeof(RegionRecord))
+    ,m_capacity(capacity)
+    ,m_warnedCapacity(false)
+{
+    m_fd = createAnonymousFile(m_size);
+    if(m_fd < 0){
+        return;
+    }
+
+    void *data = mmap(NULL, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if(data == MAP_FAILED){
+        std::cout << "Warning: cannot map pose channel: " << strerror(errno) << std::endl;
+        close(m_fd);
+        m_fd = -1;
+        return;
+    }
+    m_data = data;
+
+    //the file starts out zeroed, which is an empty region with an even sequence
+    RegionHeader *header = new (m_data) RegionHeader();
+    header->recordStride = sizeof(RegionRecord);
+}
+
+PoseChannel::~PoseChannel()
+{
+    if(m_data != NULL){
+        munmap(m_data, m_size);
+    }
+    if(m_fd >= 0){
+        close(m_fd);
+    }
+}
+
+bool PoseChannel::isValid() const
+{
+    return m_data != NULL;
+}
+
+size_t PoseChannel::size() const
+{
+    return m_size;
+}
+
+int PoseChannel::readOnlyFd() const
+{
+    if(m_fd < 0){
+        return -1;
+    }
+    //reopening through proc gives a descriptor of the same file which can only be mapped read only
+    std::string path = "/proc/self/fd/" + std::to_string(m_fd);
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0){
+        std::cout << "Warning: cannot open pose channel read only: " << strerror(errno) << std::endl;
+    }
+    return fd;
+}
+
+void PoseChannel::publish(const std::vector<Pose> &poses, uint64_t timestampNanos)
+{
+    if(m_data == NULL){
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    size_t count = poses.size();
+    if(count > m_capacity){
+        if(!m_warnedCapacity){
+            std::cout << "Warning: pose channel can hold " << m_capacity << " poses, dropping "
+                      << count - m_capacity << std::endl;
+            m_warnedCapacity = true;
+        }
+        count = m_capacity;
+    }
+
+    RegionHeader *header = static_cast<RegionHeader *>(m_data);
+    RegionRecord *records = reinterpret_cast<RegionRecord *>(header + 1);
+
+    //an odd sequence tells readers a write is in progress, the fence keeps the data stores after it
+    uint32_t sequence = header->sequence.load(std::memory_order_relaxed);
+    header->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    header->recordCount = count;
+    header->timestampNanos = timestampNanos;
+    for(size_t i = 0; i < count; i++){
+        records[i].objectId = poses[i].objectId;
+        records[i].type = poses[i].type;
+        records[i].timestampNanos = poses[i].timestampNanos;
+        std::memcpy(records[i].pose, glm::value_ptr(poses[i].pose), sizeof(records[i].pose));
+    }
+
+    header->sequence.store(sequence + 2, std::memory_order_release);
+
+    m_sources.clear();
+    for(size_t i = 0; i < count; i++){
+        m_sources.push_back(poses[i].source);
+    }
+}
+
+void PoseChannel::updatePose(const void *source, uint64_t poseTimestampNanos, const glm::mat4 &pose, uint64_t timestampNanos)
+{
+    if(m_data == NULL || source == NULL){
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    std::vector<size_t> indices;
+    for(size_t i = 0; i < m_sources.size(); i++){
+        if(m_sources[i] == source){
+            indices.push_back(i);
+        }
+    }
+    if(indices.empty()){
+        return;
+    }
+
+    RegionHeader *header = static_cast<RegionHeader *>(m_data);
+    RegionRecord *records = reinterpret_cast<RegionRecord *>(header + 1);
+
+    uint32_t sequence = header->sequence.load(std::memory_order_relaxed);
+    header->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    header->timestampNanos = timestampNanos;
+    for(size_t i : indices){
+        records[i].timestampNanos = poseTimestampNanos;
+        std::memcpy(records[i].pose, glm::value_ptr(pose), sizeof(records[i].pose));
+    }
+
+    header->sequence.store(sequence + 2, std::memory_order_release);
+}
@@ -0,0 +1,98 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#ifndef POSECHANNEL_H
+#define POSECHANNEL_H
+
+#include <glm/glm.hpp>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <mutex>
+#include <vector>
+
+namespace motorcar {
+///Shared memory region into which the newest poses are published for one client, see motorcar_pose_channel
+/*The region is created anonymously (as a memfd where the kernel supports it, sealed against resizing) and only
+ * handed to the client through read only file descriptors, so the client can map it but not write into it or
+ * shrink it under the compositor's mapping.
+ *
+ * Poses are written under a sequence lock, so publishing never waits for readers, and readers retry the rare
+ * read which overlapped a write. Writers are serialized, so tracking threads may update single poses between
+ * the frames which publish all of them*/
+class PoseChannel
+{
+public:
+    ///one record of the region, type is a motorcar_pose_channel_pose_type
+    struct Pose{
+        uint32_t objectId;
+        uint32_t type;
+        uint64_t timestampNanos;
+        glm::mat4 pose;
+        //identifies the record to updatePose(), not written into the region
+        const void *source;
+    };
+
+    ///creates a region with room for the given number of poses
+    PoseChannel(size_t capacity = 64);
+    ~PoseChannel();
+
+    ///returns whether the region could be created, if not nothing can be published
+    bool isValid() const;
+    ///size of the region in bytes
+    size_t size() const;
+    ///returns a new read only file descriptor of the region, which the caller must close, or -1 on failure
+    int readOnlyFd() const;
+
+    ///replaces the poses in the region, poses beyond the capacity are dropped
+    ///timestamps are on CLOCK_MONOTONIC, see PosePredictor::monotonicNanos()
+    void publish(const std::vector<Pose> &poses, uint64_t timestampNanos);
+    ///replaces the pose of the records last published with the given source, if there are any
+    void updatePose(const void *source, uint64_t poseTimestampNanos, const glm::mat4 &pose, uint64_t timestampNanos);
+
+private:
+    int m_fd;
+    void *m_data;
+    size_t m_size, m_capacity;
+    //sources of the records in the region, in order
+    std::vector<const void *> m_sources;
+    std::mutex m_writeMutex;
+    bool m_warnedCapacity;
+
+    PoseChannel(const PoseChannel &);
+    PoseChannel &operator=(const PoseChannel &);
+};
+}
+
+#endif // POSECHANNEL_H
@@ -0,0 +1,135 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#include <wayland/output/presentationfeedback.h>
+
+#include <motorcar-server-protocol.h>
+
+using namespace motorcar;
+
+PresentationFeedback::PresentationFeedback(wl_client *client, uint32_t id, const void *owner, unsigned int commitSerial)
+    :m_resource(wl_resource_create(client, &motorcar_presentation_feedback_interface, 1, id))
+    ,m_owner(owner)
+    ,m_commitSerial(commitSerial)
+    ,m_latched(false)
+    ,m_superseded(false)
+    ,m_frame(0)
+    ,m_supersededFrame(0)
+    ,m_predictedPresentationNanos(0)
+{
+    if(m_resource == NULL){
+        wl_client_post_no_memory(client);
+        return;
+    }
+    //the interface has no requests
+    wl_resource_set_implementation(m_resource, NULL, this, PresentationFeedback::destroy_func);
+}
+
+PresentationFeedback::~PresentationFeedback()
+{
+    discard();
+}
+
+wl_resource *PresentationFeedback::resource() const
+{
+    return m_resource;
+}
+
+const void *PresentationFeedback::owner() const
+{
+    return m_owner;
+}
+
+unsigned int PresentationFeedback::commitSerial() const
+{
+    return m_commitSerial;
+}
+
+void PresentationFeedback::latch(uint32_t frame, uint64_t predictedPresentationNanos)
+{
+    m_latched = true;
+    m_frame = frame;
+    m_predictedPresentationNanos = predictedPresentationNanos;
+}
+
+bool PresentationFeedback::isLatched() const
+{
+    return m_latched;
+}
+
+void PresentationFeedback::supersede(uint32_t frame)
+{
+    if(!m_superseded){
+        m_superseded = true;
+        m_supersededFrame = frame;
+    }
+}
+
+bool PresentationFeedback::framePresented(uint32_t frame, uint64_t presentedNanos, uint32_t refreshNanos)
+{
+    if(m_resource == NULL){
+        return true;
+    }
+    if(!m_latched || frame < m_frame){
+        return false;
+    }
+    //the presented frame already shows the newer content
+    if(m_superseded && frame >= m_supersededFrame){
+        discard();
+        return true;
+    }
+
+    uint32_t flags = 0;
+    //frames picking up content may be skipped by the displays in favour of newer ones, which then present it late
+    if(frame == m_frame && presentedNanos <= m_predictedPresentationNanos + refreshNanos / 2){
+        flags |= MOTORCAR_PRESENTATION_FEEDBACK_KIND_ON_TIME;
+    }
+    motorcar_presentation_feedback_send_presented(m_resource, (uint32_t) (presentedNanos >> 32), (uint32_t) presentedNanos,
+                                                  refreshNanos, frame, flags);
+    wl_resource_destroy(m_resource);
+    return true;
+}
+
+void PresentationFeedback::discard()
+{
+    if(m_resource != NULL){
+        motorcar_presentation_feedback_send_discarded(m_resource);
+        wl_resource_destroy(m_resource);
+    }
+}
+
+void PresentationFeedback::destroy_func(wl_resource *resource)
+{
+    static_cast<PresentationFeedback *>(resource->data)->m_resource = NULL;
+}
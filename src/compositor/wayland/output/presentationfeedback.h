@@ -0,0 +1,93 @@
+/****************************************************************************
+**This file is part of the Motorcar 3D windowing framework
+**
+**
+**Copyright (C) 2014 Forrest Reiling
+**
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+**
+****************************************************************************/
+#ifndef PRESENTATIONFEEDBACK_H
+#define PRESENTATIONFEEDBACK_H
+
+#include <wayland-server.h>
+
+#include <stdint.h>
+
+namespace motorcar {
+///One motorcar_presentation_feedback object, following the content of one commit until it is presented or discarded
+/*Feedback starts out pending, until the commit following its creation reaches the surface's textures. The surface node
+ * then latches it with the frame that picked the content up, and from then on it waits for a frame showing the content
+ * to be presented. Content which newer content replaces before that is discarded.
+ *
+ * Whoever holds the feedback deletes it once it has been reported, deleting it earlier reports it as discarded. If the
+ * client disconnects in the meantime the resource goes away and the feedback only waits to be deleted*/
+class PresentationFeedback
+{
+public:
+    ///creates the resource for the content of the given commit of the owner's surface
+    PresentationFeedback(struct wl_client *client, uint32_t id, const void *owner, unsigned int commitSerial);
+    ///sends discarded if the feedback has not been reported yet
+    ~PresentationFeedback();
+
+    ///NULL once the feedback has been reported or the client destroyed the resource
+    struct wl_resource *resource() const;
+    ///identifies the surface node the feedback was requested on
+    const void *owner() const;
+    ///the WaylandSurface::commitSerial() of the commit whose content the feedback is about
+    unsigned int commitSerial() const;
+
+    ///records that the content was picked up by the given frame, which is expected to be presented at the given time
+    void latch(uint32_t frame, uint64_t predictedPresentationNanos);
+    bool isLatched() const;
+    ///records that newer content replaced the content from the given frame on
+    void supersede(uint32_t frame);
+
+    ///reports the presentation of the given frame if it concerns the content, returns whether the feedback has been reported
+    /*times are in nanoseconds on CLOCK_MONOTONIC*/
+    bool framePresented(uint32_t frame, uint64_t presentedNanos, uint32_t refreshNanos);
+    ///reports the content as never presented
+    void discard();
+
+private:
+    struct wl_resource *m_resource;
+    const void *m_owner;
+    unsigned int m_commitSerial;
+
+    bool m_latched, m_superseded;
+    uint32_t m_frame, m_supersededFrame;
+    uint64_t m_predictedPresentationNanos;
+
+    static void destroy_func(struct wl_resource *resource);
+
+    PresentationFeedback(const PresentationFeedback &);
+    PresentationFeedback &operator=(const PresentationFeedback &);
+};
+}
+
+#endif // PRESENTATIONFEEDBACK_H
@@ -40,11 +40,28 @@ WaylandSurface::WaylandSurface(SurfaceType type, bool isMotorcarSurface, Clippin
     , m_isMotorcarSurface(isMotorcarSurface)
     , m_clippingMode(clippingMode)
     , m_depthCompositingEnabled(depthCompositingEnabled)
+    , m_contentSerial(0)
+    , m_commitSerial(0)
+    , m_contentCommitSerial(0)
 {
 
 }
 
 
+WaylandSurface::TextureFormat WaylandSurface::textureFormat()
+{
+    return TextureFormat::RGBA;
+}
+
+GLuint WaylandSurface::planeTexture(int plane)
+{
+    return plane == 0 ? texture() : 0;
+}
+
+int WaylandSurface::stackingIndex()
+{
+    return 0;
+}
 
 WaylandSurface::SurfaceType WaylandSurface::type() const
 {
@@ -85,6 +102,32 @@ void WaylandSurface::setIsMotorcarSurface(bool isMotorcarSurface)
     m_isMotorcarSurface = isMotorcarSurface;
 }
 
+unsigned int WaylandSurface::contentSerial() const
+{
+    return m_contentSerial;
+}
+
+void WaylandSurface::contentChanged(unsigned int commitSerial)
+{
+    m_contentSerial++;
+    m_contentCommitSerial = commitSerial;
+}
+
+unsigned int WaylandSurface::commitSerial() const
+{
+    return m_commitSerial;
+}
+
+unsigned int WaylandSurface::contentCommitSerial() const
+{
+    return m_contentCommitSerial;
+}
+
+void WaylandSurface::committed()
+{
+    m_commitSerial++;
+}
+
 
 
 
@@ -47,6 +47,7 @@ public:
         TRANSIENT,
         POPUP,
         CURSOR,
+        SUBSURFACE,
         NA
     };
 
@@ -56,11 +57,26 @@ public:
         PORTAL
     };
 
+    ///Layout of the pixel data held by the surface's textures
+    /*RGBX is RGBA whose alpha channel must be ignored, NV12 has a luma texture and a two channel
+     * chroma texture at half resolution, YUV420 has a luma texture and separate half resolution
+     * U and V textures*/
+    enum TextureFormat{
+        RGBA,
+        RGBX,
+        NV12,
+        YUV420
+    };
+
     WaylandSurface(SurfaceType type, bool isMotorcarSurface=false, ClippingMode clippingMode = ClippingMode::NONE, bool depthCompositingEnabled = false);
     virtual ~WaylandSurface(){}
 
     ///Get the texture handle for this surface
     virtual GLuint texture() = 0;
+    ///Get the layout of the pixel data in this surface's textures
+    virtual TextureFormat textureFormat();
+    ///Get the texture handle for the given plane of a multi-planar surface, plane 0 is texture()
+    virtual GLuint planeTexture(int plane);
     ///Get the size of this surface in pixels
     virtual glm::ivec2 size() = 0;
     ///Set the size of this surface in pixels
@@ -69,6 +85,8 @@ public:
     virtual glm::ivec2 position() = 0;
     ///return the parent surface
     virtual WaylandSurface *parentSurface() = 0;
+    ///Get the place of this subsurface among its siblings as set by place_above and place_below, 0 is the bottom
+    virtual int stackingIndex();
     ///do any per-frame setup required for drawing
     /*note: this is the only safe place to change framebuffers*/
     virtual void prepare() = 0;
@@ -96,11 +114,28 @@ public:
     bool isMotorcarSurface() const;
     void setIsMotorcarSurface(bool isMotorcarSurface);
 
+    ///incremented whenever the contents of the surface's textures change, so copies of them can tell when they are stale
+    unsigned int contentSerial() const;
+    ///incremented whenever the client commits, the content of a commit reaches the textures with a later contentSerial change
+    unsigned int commitSerial() const;
+    ///the commitSerial() of the commit whose content the textures currently hold
+    /*textures may be filled asynchronously, so this can lag behind commitSerial() by a commit or two*/
+    unsigned int contentCommitSerial() const;
+
 protected:
+    ///call whenever the contents of the surface's textures change, passing the commitSerial() of the commit they now show
+    void contentChanged(unsigned int commitSerial);
+    ///call whenever the client commits new state
+    void committed();
+
+
     SurfaceType m_type;
     ClippingMode m_clippingMode;
     bool m_depthCompositingEnabled;
     bool m_isMotorcarSurface;
+    unsigned int m_contentSerial;
+    unsigned int m_commitSerial;
+    unsigned int m_contentCommitSerial;
 };
 }
 
@@ -54,6 +54,11 @@ WindowManager::~WindowManager()
     delete m_shell;
 }
 
+Shell *WindowManager::shell() const
+{
+    return m_shell;
+}
+
 WaylandSurfaceNode *WindowManager::createSurface(WaylandSurface *surface)
 {
 
@@ -209,6 +214,18 @@ WaylandSurfaceNode *WindowManager::mapSurface(motorcar::WaylandSurface *surface,
         if(type == WaylandSurface::SurfaceType::POPUP ){
             this->defaultSeat()->setPointerFocus(surfaceNode->surface(), glm::vec2());
         }
+    }else if(type == WaylandSurface::SurfaceType::SUBSURFACE){
+        //subsurfaces are drawn as children of their parent's node, their transform follows the
+        //subsurface position and is kept up to date by the node itself
+        WaylandSurfaceNode *parentSurfaceNode = this->getSurfaceNode(surface->parentSurface());
+        if(parentSurfaceNode != NULL){
+            std::cout << "mapping subsurface with parent " << parentSurfaceNode << std::endl;
+            surfaceNode->setParentNode(parentSurfaceNode);
+        }else{
+            std::cout << "WARNING: mapping subsurface with no parent " << std::endl;
+            surfaceNode->setParentNode(this->scene());
+        }
+        surfaceNode->setTransform(glm::mat4());
     }else{
         std::cout << "mapped surfaceNode other type"<< std::endl;
         surfaceNode->setParentNode(this->scene());
@@ -80,6 +80,8 @@ public:
 
     void ensureKeyboardFocusIsValid(WaylandSurface *oldSurface);
 
+    Shell *shell() const;
+
 
 private:
 
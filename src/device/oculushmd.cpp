@@ -33,10 +33,25 @@
 **
 ****************************************************************************/
 #include "oculushmd.h"
+#include <scenegraph/scene.h>
 
 using namespace motorcar;
 using namespace OVR;
 
+//the furthest sensor fusion is asked to predict ahead when the head pose is late latched
+#define OCULUS_MAX_LATE_LATCH_PREDICTION_SECONDS 0.05f
+
+static glm::quat toGlmOrientation(const OVR::Quatf &ovrQuat)
+{
+    OVR::Vector3f OVRaxis;
+    float angle;
+    ovrQuat.GetAxisAngle(&OVRaxis, &angle);
+
+    glm::vec3 axis =glm::vec3(OVRaxis.x, OVRaxis.y, OVRaxis.z);
+
+    return glm::angleAxis(glm::degrees(angle), glm::normalize(axis));
+}
+
 //using namespace OVR::Platform;
 //using namespace OVR::Render;
 
@@ -57,24 +72,42 @@ OculusHMD::~OculusHMD()
 
 
 
-void OculusHMD::prepareForDraw()
+void OculusHMD::handleFrameBegin(Scene *scene)
 {
-    OVR::Quatf ovrQuat = m_system->SFusion.GetOrientation();
+    RenderToTextureDisplay::handleFrameBegin(scene);
 
-    OVR::Vector3f OVRaxis;
-    float angle;
-    ovrQuat.GetAxisAngle(&OVRaxis, &angle);
-
-    glm::vec3 axis =glm::vec3(OVRaxis.x, OVRaxis.y, OVRaxis.z);
+    glm::quat orientation = toGlmOrientation(m_system->SFusion.GetOrientation());
 
-    glm::quat orientation = glm::angleAxis(glm::degrees(angle), glm::normalize(axis));
+    //sensor fusion runs on its own thread, so its orientation is as of now
+    m_posePredictor.addSample(PosePredictor::monotonicNanos(), glm::vec3(0), orientation);
 
-    glm::vec3 parentPos = glm::vec3(parentNode()->worldTransform() * glm::vec4(0,0,0,1));
+    glm::vec3 position;
+    m_posePredictor.predict(scene->predictedPresentationNanos(), &position, &orientation);
 
     m_boneTracker->setOrientation(glm::mat3_cast(orientation));
+    m_frameOrientation = orientation;
+}
 
+bool OculusHMD::trackerPose(glm::mat4 *trackerTransform, glm::quat *orientation) const
+{
+    *trackerTransform = m_boneTracker->worldTransform();
+    *orientation = m_frameOrientation;
+    return true;
+}
 
-    RenderToTextureDisplay::prepareForDraw();
+bool OculusHMD::lateLatchOrientation(const FrameSnapshot *frame, glm::quat *orientation)
+{
+    //sensor fusion locks its state, so it can be read from the drawing thread
+    float predictionSeconds = 0.0f;
+    uint64_t now = PosePredictor::monotonicNanos();
+    if(frame->predictedPresentationNanos > now){
+        predictionSeconds = (frame->predictedPresentationNanos - now) / 1.0e9f;
+        if(predictionSeconds > OCULUS_MAX_LATE_LATCH_PREDICTION_SECONDS){
+            predictionSeconds = OCULUS_MAX_LATE_LATCH_PREDICTION_SECONDS;
+        }
+    }
+    *orientation = toGlmOrientation(m_system->SFusion.GetPredictedOrientation(predictionSeconds));
+    return true;
 }
 
 
@@ -38,6 +38,7 @@
 
 #include <scenegraph/output/display/rendertotexturedisplay.h>
 #include <scenegraph/input/singlebonetracker.h>
+#include <scenegraph/input/posepredictor.h>
 #include <OVR.h>
 #include <glm/gtc/quaternion.hpp>
 
@@ -57,7 +58,13 @@ public:
 
 
 
-    void prepareForDraw() override;
+    ///reads the orientation of the headset and moves the head bone to where it is predicted to be once the frame is presented
+    void handleFrameBegin(Scene *scene) override;
+
+    ///reports the head bone tracker and the orientation it was given this frame
+    virtual bool trackerPose(glm::mat4 *trackerTransform, glm::quat *orientation) const override;
+    ///reads the orientation from sensor fusion again and predicts it to the frame's presentation
+    virtual bool lateLatchOrientation(const FrameSnapshot *frame, glm::quat *orientation) override;
 
     //This constructor should not be called externally, use create() instead;
     OculusHMD(OVRSystem * system, Skeleton *skeleton,
@@ -67,6 +74,9 @@ public:
 private:
 
     SingleBoneTracker *m_boneTracker;
+    PosePredictor m_posePredictor;
+    //the orientation the head bone was given for the current frame
+    glm::quat m_frameOrientation;
 
 
     class OVRSystem : OVR::MessageHandler{
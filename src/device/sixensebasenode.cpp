@@ -41,7 +41,7 @@ using namespace motorcar;
 SixenseBaseNode::SixenseBaseNode(int baseIndex, PhysicalNode *parent,
                                  const glm::mat4 &transform)
     : PhysicalNode(parent, transform), m_baseIndex(baseIndex),
-      m_connected(true) {
+      m_connected(true), m_baseConnected(true) {
 
   sixenseAllControllerData acd;
 
@@ -77,32 +77,46 @@ SixenseBaseNode::SixenseBaseNode(int baseIndex, PhysicalNode *parent,
   new WireframeNode(vertices, 3, glm::vec3(0.25f), this);
 }
 
-void SixenseBaseNode::handleFrameBegin(Scene *scene) {
-  PhysicalNode::handleFrameBegin(scene);
+void SixenseBaseNode::poll() {
+  if (!sixenseIsBaseConnected(m_baseIndex)) {
+    m_baseConnected.store(false);
+    return;
+  }
+  m_baseConnected.store(true);
 
   sixenseAllControllerData acd;
 
-  if (sixenseIsBaseConnected(m_baseIndex)) {
+  sixenseSetActiveBase(m_baseIndex);
+  sixenseGetAllNewestData(&acd);
+
+  for (SixenseControllerNode *controller : m_controllers) {
+    bool enabled = sixenseIsControllerEnabled(controller->controllerIndex());
+    controller->setTrackerEnabled(enabled);
+    if (enabled) {
+      controller->pollState(acd.controllers[controller->controllerIndex()]);
+    }
+  }
+}
+
+void SixenseBaseNode::handleFrameBegin(Scene *scene) {
+  PhysicalNode::handleFrameBegin(scene);
+
+  if (m_baseConnected.load()) {
     if (!connected()) {
       setConnected(true);
       std::cout << "Sixsense base " << m_baseIndex << " reconnected"
                 << std::endl;
     }
-    sixenseSetActiveBase(m_baseIndex);
-    sixenseGetAllNewestData(&acd);
 
     for (SixenseControllerNode *controller : m_controllers) {
-      if (sixenseIsControllerEnabled(controller->controllerIndex())) {
+      if (controller->trackerEnabled()) {
         if (!controller->enabled()) {
           controller->setEnabled(true);
           std::cout << "Sixsense controller " << controller->controllerIndex()
                     << " re-enabled" << std::endl;
         }
 
-        sixenseControllerData data =
-            acd.controllers[controller->controllerIndex()];
-
-        controller->updateState(data);
+        controller->updateState();
 
       } else if (controller->enabled()) {
         controller->setEnabled(false);
@@ -40,6 +40,7 @@
 #include "sixensecontrollernode.h"
 #include <scenegraph/scene.h>
 
+#include <atomic>
 #include <vector>
 
 namespace motorcar {
@@ -48,7 +49,10 @@ class SixenseBaseNode : public PhysicalNode
 public:
     SixenseBaseNode(int baseIndex, PhysicalNode *parent, const glm::mat4 &transform = glm::mat4());
 
-    ///gets current system state and passes new controller state to controller nodes
+    ///reads the newest data of the base and queues new controller samples, only called by the polling thread
+    void poll();
+
+    ///applies the system state last polled and the queued controller samples to the controller nodes
     virtual void handleFrameBegin(Scene *scene) override;
 
 
@@ -62,6 +66,8 @@ private:
     std::vector<SixenseControllerNode *> m_controllers;
     int m_baseIndex;
     bool m_connected;
+    //whether the base was connected when it was last polled
+    std::atomic<bool> m_baseConnected;
 };
 }
 
@@ -37,6 +37,8 @@ using namespace motorcar;
 
 #include <scenegraph/scene.h>
 #include <compositor.h>
+#include <windowmanager.h>
+#include <shell.h>
 
 SixenseControllerNode::SixenseControllerNode(int controllerIndex, PhysicalNode *parent, const glm::mat4 &transform )
     :PhysicalNode(parent, transform)
@@ -45,53 +47,71 @@ SixenseControllerNode::SixenseControllerNode(int controllerIndex, PhysicalNode *
     ,m_controllerIndex(controllerIndex)
     ,m_enabled(true)
     ,m_bumperDown(false)
-    ,m_filteredPos(0)
-    ,m_filterConstant(.8)
+    ,m_lastSequenceNumber(-1)
+    ,m_trackerEnabled(true)
 {
+    m_pointerPublication.shell = NULL;
+    m_pointerPublication.pointingDevice = NULL;
 
 }
 
-void SixenseControllerNode::updateState(sixenseControllerData data)
+void SixenseControllerNode::pollState(const sixenseControllerData &data)
 {
-    if(m_pointingDevice != NULL){
-        if(data.buttons & SIXENSE_BUTTON_BUMPER){
-            if(!m_bumperDown){
-                m_bumperDown = true;
-                m_pointingDevice->grabSurfaceUnderCursor();
-            }
-        }else{
-            if(m_bumperDown){
-                m_bumperDown = false;
-                m_pointingDevice->releaseGrabbedSurface();
-            }
-        }
-
-        m_pointingDevice->setLeftMouseDown((data.buttons & SIXENSE_BUTTON_1) != 0);
-        m_pointingDevice->setRightMouseDown((data.buttons & SIXENSE_BUTTON_2) != 0);
-        m_pointingDevice->setMiddleMouseDown((data.buttons & SIXENSE_BUTTON_JOYSTICK) != 0);
+    //the base is polled faster than it produces samples, only samples it has not reported before are new
+    if(data.sequence_number == m_lastSequenceNumber){
+        return;
     }
+    m_lastSequenceNumber = data.sequence_number;
+
+    TrackerSample sample;
+    sample.timeNanos = PosePredictor::monotonicNanos();
+    m_filter.filter(sample.timeNanos, glm::make_vec3(data.pos) / 1000.f, glm::quat_cast(glm::make_mat3((float *)data.rot_mat)),
+                    &sample.position, &sample.orientation);
+    sample.buttons = data.buttons;
+    m_samples.push(sample);
+
+    //clients reading the pose channel see the measured pose now instead of the predicted one at the next frame
+    std::lock_guard<std::mutex> lock(m_pointerPublicationMutex);
+    const PointerPublication &publication = m_pointerPublication;
+    if(publication.shell != NULL){
+        glm::mat4 controllerTransform = glm::translate(glm::mat4(), sample.position) * glm::mat4_cast(sample.orientation);
+        publication.shell->updatePose(publication.pointingDevice, sample.timeNanos,
+                                      publication.parentTransform * controllerTransform * publication.pointerOffset);
+    }
+}
 
-    glm::mat3 rotation = glm::make_mat3((float *)data.rot_mat);
-    glm::vec3 newPosition = (glm::make_vec3(data.pos) / 1000.f);
-
-    m_filteredPos = (1-m_filterConstant) * m_filteredPos + m_filterConstant * newPosition;
-
-
-
+void SixenseControllerNode::updateState()
+{
+    TrackerSample sample;
+    while(m_samples.pop(&sample)){
+        //every sample is applied so presses shorter than a frame are not lost
+        updateButtons(sample.buttons);
+        m_posePredictor.addSample(sample.timeNanos, sample.position, sample.orientation);
+    }
 
+    {
+        std::lock_guard<std::mutex> lock(m_pointerPublicationMutex);
+        WindowManager *windowManager = scene()->windowManager();
+        m_pointerPublication.shell = m_pointingDevice != NULL && windowManager != NULL ? windowManager->shell() : NULL;
+        m_pointerPublication.pointingDevice = m_pointingDevice;
+        m_pointerPublication.parentTransform = parentNode() != NULL ? parentNode()->worldTransform() : glm::mat4();
+        m_pointerPublication.pointerOffset = m_pointingDevice != NULL ? m_pointingDevice->transform() : glm::mat4();
+    }
 
-    glm::mat4 controllerTransform = glm::translate(glm::mat4(), m_filteredPos);// *
+    if(!m_posePredictor.hasSamples()){
+        return;
+    }
 
+    //moved to where the controller is predicted to be once the frame is presented
+    glm::vec3 position;
+    glm::quat orientation;
+    m_posePredictor.predict(scene()->predictedPresentationNanos(), &position, &orientation);
 
-    controllerTransform = glm::translate(glm::mat4(), m_filteredPos) * glm::mat4(glm::vec4(rotation[0], 0),
-                                                              glm::vec4(rotation[1], 0),
-                                                              glm::vec4(rotation[2], 0),
-                                                              glm::vec4(0,0,0, 1));
-    setTransform(controllerTransform);
+    setTransform(glm::translate(glm::mat4(), position) * glm::mat4_cast(orientation));
 
 
     if(m_boneTracker != NULL){
-        m_boneTracker->setPosition(m_filteredPos);
+        m_boneTracker->setPosition(position);
         //m_boneTracker->setOrientation(rotation);
     }
 
@@ -99,6 +119,27 @@ void SixenseControllerNode::updateState(sixenseControllerData data)
 
 }
 
+void SixenseControllerNode::updateButtons(unsigned int buttons)
+{
+    if(m_pointingDevice != NULL){
+        if(buttons & SIXENSE_BUTTON_BUMPER){
+            if(!m_bumperDown){
+                m_bumperDown = true;
+                m_pointingDevice->grabSurfaceUnderCursor();
+            }
+        }else{
+            if(m_bumperDown){
+                m_bumperDown = false;
+                m_pointingDevice->releaseGrabbedSurface();
+            }
+        }
+
+        m_pointingDevice->setLeftMouseDown((buttons & SIXENSE_BUTTON_1) != 0);
+        m_pointingDevice->setRightMouseDown((buttons & SIXENSE_BUTTON_2) != 0);
+        m_pointingDevice->setMiddleMouseDown((buttons & SIXENSE_BUTTON_JOYSTICK) != 0);
+    }
+}
+
 int SixenseControllerNode::controllerIndex() const
 {
     return m_controllerIndex;
@@ -121,6 +162,23 @@ bool SixenseControllerNode::enabled() const
 void SixenseControllerNode::setEnabled(bool enabled)
 {
     m_enabled = enabled;
+    if(!enabled){
+        //do not extrapolate across the time the controller was gone
+        m_posePredictor.reset();
+    }
+}
+
+bool SixenseControllerNode::trackerEnabled() const
+{
+    return m_trackerEnabled.load();
+}
+
+void SixenseControllerNode::setTrackerEnabled(bool trackerEnabled)
+{
+    if(m_trackerEnabled.exchange(trackerEnabled) && !trackerEnabled){
+        //do not smooth across the time the controller was gone
+        m_filter.reset();
+    }
 }
 
 
@@ -36,15 +36,31 @@
 #define SIXENSECONTROLLERNODE_H
 #include <scenegraph/input/sixdofpointingdevice.h>
 #include <scenegraph/input/singlebonetracker.h>
+#include <scenegraph/input/posepredictor.h>
+#include <scenegraph/input/oneeurofilter.h>
+#include <scenegraph/input/trackersamplequeue.h>
 #include <sixense.h>
 
+#include <atomic>
+#include <mutex>
+
 namespace motorcar {
+class Shell;
 class SixenseControllerNode : public PhysicalNode
 {
 public:
     SixenseControllerNode(int controllerIndex, PhysicalNode *parent, const glm::mat4 &transform = glm::mat4());
 
-    void updateState(sixenseControllerData data);
+    ///filters and queues the controller data if it is a sample not seen before, only called by the thread polling the base
+    /*the filtered pose of the pointing device is handed to the clients' pose channels right away*/
+    void pollState(const sixenseControllerData &data);
+    ///applies the samples queued since the last frame and moves the controller to its predicted pose
+    void updateState();
+
+    ///whether the base reported the controller as enabled when it was last polled
+    bool trackerEnabled() const;
+    ///only called by the thread polling the base
+    void setTrackerEnabled(bool trackerEnabled);
 
     int controllerIndex() const;
     void setControllerIndex(int controllerIndex);
@@ -60,14 +76,33 @@ public:
     void setBoneTracker(SingleBoneTracker *boneTracker);
 
 private:
+    ///turns the button state of one sample into pointer events
+    void updateButtons(unsigned int buttons);
+
     SixDOFPointingDevice *m_pointingDevice;
     SingleBoneTracker *m_boneTracker;
     int m_controllerIndex;
     bool m_enabled;
     bool m_bumperDown;
 
-    glm::vec3 m_filteredPos;
-    float m_filterConstant;
+    //only touched by the polling thread
+    int m_lastSequenceNumber;
+    OneEuroFilter m_filter;
+    //shared with the polling thread
+    TrackerSampleQueue m_samples;
+    std::atomic<bool> m_trackerEnabled;
+
+    //what the polling thread needs to turn a controller pose into the pointing device's world pose, taken
+    //from the scene graph every frame since the polling thread must not read it
+    struct PointerPublication{
+        Shell *shell;
+        const void *pointingDevice;
+        glm::mat4 parentTransform, pointerOffset;
+    };
+    PointerPublication m_pointerPublication;
+    std::mutex m_pointerPublicationMutex;
+
+    PosePredictor m_posePredictor;
 };
 }
 
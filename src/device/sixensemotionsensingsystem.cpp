@@ -39,8 +39,12 @@ using namespace motorcar;
 
 #include <unistd.h>
 
+//the base reports new samples at a few hundred Hertz, polling faster keeps the time a sample waits to be read short
+#define SIXENSE_POLL_INTERVAL_MICROS 1000
+
 SixenseMotionSensingSystem::SixenseMotionSensingSystem(Scene *scene)
     :m_isInitialized(false)
+    ,m_polling(false)
 {
 
     if(sixenseInit() == SIXENSE_SUCCESS){
@@ -70,6 +74,9 @@ SixenseMotionSensingSystem::SixenseMotionSensingSystem(Scene *scene)
         }else{
             m_isInitialized = true;
             std::cout << "Successfully intitialize SixenseMotionSensingSystem" << std::endl;
+
+            m_polling.store(true);
+            m_pollingThread = std::thread(&SixenseMotionSensingSystem::pollDevices, this);
         }
 
 
@@ -84,9 +91,24 @@ SixenseMotionSensingSystem::SixenseMotionSensingSystem(Scene *scene)
 
 SixenseMotionSensingSystem::~SixenseMotionSensingSystem()
 {
+    //the base station nodes belong to the scene and pointer poses go to its shell, so polling must end before either is deleted
+    m_polling.store(false);
+    if(m_pollingThread.joinable()){
+        m_pollingThread.join();
+    }
     sixenseExit();
 }
 
+void SixenseMotionSensingSystem::pollDevices()
+{
+    while(m_polling.load()){
+        for(SixenseBaseNode *base : m_baseStations){
+            base->poll();
+        }
+        usleep(SIXENSE_POLL_INTERVAL_MICROS);
+    }
+}
+
 void SixenseMotionSensingSystem::controllerManagerSetupCallback(sixenseUtils::IControllerManager::setup_step step)
 {
 
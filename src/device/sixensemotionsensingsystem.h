@@ -45,6 +45,9 @@
 
 #include <scenegraph/scene.h>
 
+#include <atomic>
+#include <thread>
+
 namespace motorcar {
 class SixenseMotionSensingSystem
 {
@@ -61,9 +64,17 @@ public:
     std::vector<SixenseBaseNode *> baseStations() const;
 
 private:
+    ///polls every base station until the system is destroyed, runs on its own thread
+    /*the SDK keeps the active base as global state, so all bases are polled from this one thread, and only
+     * by it once it has been started*/
+    void pollDevices();
+
     std::vector<SixenseBaseNode *> m_baseStations;
     bool m_controllerSetupScreenVisible;
     bool m_isInitialized;
+
+    std::thread m_pollingThread;
+    std::atomic<bool> m_polling;
 };
 }
 
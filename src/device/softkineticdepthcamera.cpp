@@ -36,6 +36,7 @@
 #include "softkineticdepthcamera.h"
 #include <scenegraph/output/viewpoint.h>
 #include <scenegraph/output/display/display.h>
+#include <scenegraph/scene.h>
 
 #include <vector>
 
@@ -349,60 +350,79 @@ void cameraEventLoop() {
 }
 
 
-SoftKineticDepthCamera::SoftKineticDepthCamera(SceneGraphNode *parent, const glm::mat4 &transform)
-    :Drawable(parent, transform)
-    ,m_pointCloudShader(new motorcar::OpenGLShader(std::string("../motorcar/src/shaders/softkineticdepthcam.vert"), std::string("../motorcar/src/shaders/softkineticdepthcam.frag")))
+///draws the point cloud uploaded by the snapshot it was created in
+class SoftKineticDepthCamera::Item : public RenderItem
 {
+public:
+    Item(std::shared_ptr<SoftKineticDepthCamera::Resources> resources, const glm::mat4 &worldTransform)
+        :m_resources(resources)
+        ,m_worldTransform(worldTransform)
+    {}
 
+    virtual void draw(const DisplaySnapshot &display) override
+    {
+        const SoftKineticDepthCamera::Resources &r = *m_resources;
 
-    g_context = Context::create("localhost");
+        glPointSize( 4.0 );
 
-    g_context.deviceAddedEvent().connect(&onDeviceConnected);
-    g_context.deviceRemovedEvent().connect(&onDeviceDisconnected);
+        glUseProgram(r.pointCloudShader->handle());
 
-    // Get the list of currently connected devices
-    vector<Device> da = g_context.getDevices();
+        glEnableVertexAttribArray(r.h_aPosition);
+        glBindBuffer(GL_ARRAY_BUFFER, r.vertexBuffer);
+        glVertexAttribPointer(r.h_aPosition, 3, GL_FLOAT, GL_FALSE, 0, 0);
+        glEnableVertexAttribArray(r.h_aConfidence);
+        glBindBuffer(GL_ARRAY_BUFFER, r.confidenceBuffer);
+        glVertexAttribPointer(r.h_aConfidence, 1, GL_FLOAT, GL_FALSE, 0, 0);
+        glEnableVertexAttribArray(r.h_aTexCoord);
+        glBindBuffer(GL_ARRAY_BUFFER, r.uvBuffer);
+        glVertexAttribPointer(r.h_aTexCoord, 2, GL_FLOAT, GL_FALSE, 0, 0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-    // We are only interested in the first device
-    if (da.size() >= 1)
-    {
-        g_bDeviceFound = true;
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, r.colorTexture);
 
-        da[0].nodeAddedEvent().connect(&onNodeConnected);
-        da[0].nodeRemovedEvent().connect(&onNodeDisconnected);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, r.indexBuffer);
 
-        vector<Node> na = da[0].getNodes();
+        for(const ViewpointSnapshot &viewpoint : display.viewpoints){
+            glUniformMatrix4fv(r.h_uMVPMatrix, 1, GL_FALSE, glm::value_ptr(viewpoint.projectionMatrix * viewpoint.viewMatrix *  m_worldTransform));
+            viewpoint.setViewport();
+            glDrawElements(GL_TRIANGLES, (COLOR_WIDTH - 1)*(COLOR_HEIGHT - 1), GL_UNSIGNED_SHORT, (GLvoid*)0);
+        }
 
-        std::cout << "Found " << na.size() << "nodes" << std::endl;
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        glBindTexture(GL_TEXTURE_2D, 0);
 
-        for (int n = 0; n < (int)na.size();n++)
-            configureNode(na[n]);
+        glDisableVertexAttribArray(r.h_aPosition);
+        glDisableVertexAttribArray(r.h_aConfidence);
+        glDisableVertexAttribArray(r.h_aTexCoord);
+
+        glUseProgram(0);
     }
 
-    m_cameraThread = std::thread(cameraEventLoop);
+private:
+    std::shared_ptr<SoftKineticDepthCamera::Resources> m_resources;
+    glm::mat4 m_worldTransform;
+};
+
 
-    h_aPosition =  glGetAttribLocation(m_pointCloudShader->handle(), "aPosition");
-    h_aConfidence =  glGetAttribLocation(m_pointCloudShader->handle(), "aConfidence");
-    h_aTexCoord =  glGetAttribLocation(m_pointCloudShader->handle(), "aTexCoord");
-    h_uMVPMatrix  = glGetUniformLocation(m_pointCloudShader->handle(), "uMVPMatrix");
+
+SoftKineticDepthCamera::Resources::Resources()
+    :pointCloudShader(new motorcar::OpenGLShader(std::string("../motorcar/src/shaders/softkineticdepthcam.vert"), std::string("../motorcar/src/shaders/softkineticdepthcam.frag")))
+    ,colorTexture(0)
+    ,resourcePool(NULL)
+{
+    h_aPosition =  glGetAttribLocation(pointCloudShader->handle(), "aPosition");
+    h_aConfidence =  glGetAttribLocation(pointCloudShader->handle(), "aConfidence");
+    h_aTexCoord =  glGetAttribLocation(pointCloudShader->handle(), "aTexCoord");
+    h_uMVPMatrix  = glGetUniformLocation(pointCloudShader->handle(), "uMVPMatrix");
 
     if(h_aPosition < 0 || h_aConfidence < 0 || h_aTexCoord < 0 || h_uMVPMatrix < 0){
        std::cout << "problem with point cloud shader handles: " << h_aPosition << ", " << h_aConfidence << ", "<< h_aTexCoord << ", "<< h_uMVPMatrix << std::endl;
     }
 
-    glActiveTexture(GL_TEXTURE0);
-    glGenTextures(1, &m_colorTexture);
-    glBindTexture(GL_TEXTURE_2D, m_colorTexture);
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
-
-    int w = m_colorWidth - 1;
-    int h =m_colorHeight - 1;
-    int rowOffset = m_colorWidth;
+    int w = COLOR_WIDTH - 1;
+    int h = COLOR_HEIGHT - 1;
+    int rowOffset = COLOR_WIDTH;
     GLushort indices[w][h][6];
     for(int i = 0; i < w; i++){
         for(int j=0; j< h; j++){
@@ -420,77 +440,107 @@ SoftKineticDepthCamera::SoftKineticDepthCamera(SceneGraphNode *parent, const glm
         }
     }
 
-    glGenBuffers(1, &m_indexBuffer);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+    glGenBuffers(1, &indexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
+    glGenBuffers(1, &vertexBuffer);
+    glGenBuffers(1, &confidenceBuffer);
+    glGenBuffers(1, &uvBuffer);
 }
 
-SoftKineticDepthCamera::~SoftKineticDepthCamera()
+SoftKineticDepthCamera::Resources::~Resources()
 {
-    std::cout << "stopping depth camera" <<std::endl;
-    g_context.quit();
-    m_cameraThread.join();
-
-    std::cout << "depth camera stopped" <<std::endl;
+    if(resourcePool != NULL){
+        resourcePool->releaseTexture(colorTexture);
+        resourcePool->unregisterOwner(this);
+    }
 
-    delete m_pointCloudShader;
+    glDeleteBuffers(1, &indexBuffer);
+    glDeleteBuffers(1, &vertexBuffer);
+    glDeleteBuffers(1, &confidenceBuffer);
+    glDeleteBuffers(1, &uvBuffer);
+    delete pointCloudShader;
 }
 
-void SoftKineticDepthCamera::draw(Scene *scene, Display *display)
-{
-
 
-    glPointSize( 4.0 );
 
-    //std::cout << g_depthData.verticesFloatingPoint.size() <<std::endl;
+SoftKineticDepthCamera::SoftKineticDepthCamera(SceneGraphNode *parent, const glm::mat4 &transform)
+    :Drawable(parent, transform)
+    ,m_resources(std::make_shared<Resources>())
+{
 
-    glUseProgram(m_pointCloudShader->handle());
 
-    glEnableVertexAttribArray(h_aPosition);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glEnableVertexAttribArray(h_aConfidence);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glEnableVertexAttribArray(h_aTexCoord);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    g_context = Context::create("localhost");
 
-    glVertexAttribPointer(h_aPosition, 3, GL_FLOAT, GL_FALSE, 0, g_vertexData);
-    glVertexAttribPointer(h_aConfidence, 1, GL_FLOAT, GL_FALSE, 0, g_confidenceData);
-    glVertexAttribPointer(h_aTexCoord, 2, GL_FLOAT, GL_FALSE, 0, g_uvData);
+    g_context.deviceAddedEvent().connect(&onDeviceConnected);
+    g_context.deviceRemovedEvent().connect(&onDeviceDisconnected);
 
+    // Get the list of currently connected devices
+    vector<Device> da = g_context.getDevices();
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, m_colorTexture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, m_colorWidth, m_colorHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, g_colorData.colorMap);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // We are only interested in the first device
+    if (da.size() >= 1)
+    {
+        g_bDeviceFound = true;
 
+        da[0].nodeAddedEvent().connect(&onNodeConnected);
+        da[0].nodeRemovedEvent().connect(&onNodeDisconnected);
 
-    //Geometry::printVector(glm::vec3(g_vertexData[0], g_vertexData[1], g_vertexData[2]));
+        vector<Node> na = da[0].getNodes();
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+        std::cout << "Found " << na.size() << "nodes" << std::endl;
 
-    for(ViewPoint *viewpoint : display->viewpoints()){
-        //Geometry::printMatrix(viewpoint->viewMatrix());
-        glUniformMatrix4fv(h_uMVPMatrix, 1, GL_FALSE, glm::value_ptr(viewpoint->projectionMatrix() * viewpoint->viewMatrix() *  this->worldTransform()));
-        viewpoint->viewport()->set();
-        //glDrawArrays(GL_POINTS, 0, g_depthMapSize);
+        for (int n = 0; n < (int)na.size();n++)
+            configureNode(na[n]);
+    }
 
-        //glDrawElements(GL_TRIANGLES, (m_colorWidth - 1)*(m_colorHeight - 1)* 6, GL_UNSIGNED_INT, (GLvoid*)0);
-        glDrawElements(GL_TRIANGLES, (m_colorWidth - 1)*(m_colorHeight - 1), GL_UNSIGNED_SHORT, (GLvoid*)0);
+    m_cameraThread = std::thread(cameraEventLoop);
+}
 
+SoftKineticDepthCamera::~SoftKineticDepthCamera()
+{
+    std::cout << "stopping depth camera" <<std::endl;
+    g_context.quit();
+    m_cameraThread.join();
 
+    std::cout << "depth camera stopped" <<std::endl;
+}
 
+void SoftKineticDepthCamera::snapshot(Scene *scene, FrameSnapshot *frame)
+{
+    Resources &r = *m_resources;
+    if(g_depthMapSize == 0){
+        return;
     }
 
+    glActiveTexture(GL_TEXTURE0);
+    if(r.colorTexture == 0){
+        r.resourcePool = scene->resourcePool();
+        r.resourcePool->registerOwner(&r, "depth camera");
+        r.colorTexture = r.resourcePool->acquireTexture(&r, GL_RGB8, glm::ivec2(COLOR_WIDTH, COLOR_HEIGHT));
+        glBindTexture(GL_TEXTURE_2D, r.colorTexture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    glBindTexture(GL_TEXTURE_2D, r.colorTexture);
+    //the frame size never changes, so the storage is only updated rather than respecified every frame
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, COLOR_WIDTH, COLOR_HEIGHT, GL_RGB, GL_UNSIGNED_BYTE, g_colorData.colorMap);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    //the camera's arrays are copied into buffers here as they may change before the frame is drawn
+    glBindBuffer(GL_ARRAY_BUFFER, r.vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, 3 * g_depthMapSize * sizeof(float), g_vertexData, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, r.confidenceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, g_depthMapSize * sizeof(float), g_confidenceData, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, r.uvBuffer);
+    glBufferData(GL_ARRAY_BUFFER, 2 * g_depthMapSize * sizeof(float), g_uvData, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-    glDisableVertexAttribArray(h_aPosition);
-    glDisableVertexAttribArray(h_aConfidence);
-    glDisableVertexAttribArray(h_aTexCoord);
-
-    glUseProgram(0);
-
+    frame->items.push_back(new Item(m_resources, this->worldTransform()));
 }
-
-
@@ -39,6 +39,7 @@
 #include <thread>
 #include <scenegraph/output/drawable.h>
 #include <gl/openglshader.h>
+#include <gl/gpuresourcepool.h>
 
 namespace motorcar {
 class SoftKineticDepthCamera : public Drawable
@@ -47,18 +48,32 @@ public:
     SoftKineticDepthCamera(SceneGraphNode *parent, const glm::mat4 &transform = glm::mat4());
     ~SoftKineticDepthCamera();
 
-    virtual void draw(Scene *scene, Display *display) override;
+    ///uploads the latest camera frame and snapshots the point cloud for drawing
+    virtual void snapshot(Scene *scene, FrameSnapshot *frame) override;
+
+    static const int COLOR_WIDTH = 640, COLOR_HEIGHT = 480;
 
 private:
-    OpenGLShader *m_pointCloudShader;
     std::thread m_cameraThread;
 
-    GLint h_aPosition, h_aConfidence,h_aTexCoord, h_uMVPMatrix;
-    GLuint m_colorTexture;
-    GLuint m_indexBuffer;
+    ///shader, camera frame buffers and color texture, shared with the frames in flight which draw the camera
+    class Resources
+    {
+    public:
+        Resources();
+        ~Resources();
+
+        OpenGLShader *pointCloudShader;
+        GLint h_aPosition, h_aConfidence,h_aTexCoord, h_uMVPMatrix;
+        GLuint indexBuffer, vertexBuffer, confidenceBuffer, uvBuffer;
+        //taken from the scene's resource pool on first snapshot
+        GLuint colorTexture;
+        GpuResourcePool *resourcePool;
+    };
 
+    class Item;
 
-    const int m_colorWidth = 640, m_colorHeight = 480;
+    std::shared_ptr<Resources> m_resources;
 
 };
 }
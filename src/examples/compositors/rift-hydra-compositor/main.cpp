@@ -77,6 +77,14 @@ int main(int argc, char *argv[])
 
     scene->addDisplay(compositor->display());
 
+    if(hmd){
+        //let the people around see what the wearer sees on a second screen, if there is one
+        motorcar::OpenGLContext *mirrorContext = compositor->createContext(1);
+        if(mirrorContext != NULL){
+            scene->addDisplay(new motorcar::MirrorDisplay(hmd, motorcar::RenderToTextureDisplay::MirrorSource::DISTORTED_OUTPUT, mirrorContext));
+        }
+    }
+
 
 //    glm::mat4 cameraTransform = glm::rotate(glm::mat4(), 180.f, glm::vec3(0,1, 0)) * glm::scale(glm::mat4(), glm::vec3(-1, 1, 1));
 //    motorcar::SoftKineticDepthCamera *ds325 = new motorcar::SoftKineticDepthCamera(scene, cameraTransform);
@@ -14,15 +14,123 @@ struct wl_resource;
 
 struct motorcar_shell;
 struct motorcar_surface;
+struct motorcar_pose_channel;
+struct motorcar_presentation_feedback;
 struct motorcar_viewpoint;
 struct motorcar_six_dof_pointer;
 
 extern const struct wl_interface motorcar_shell_interface;
 extern const struct wl_interface motorcar_surface_interface;
+extern const struct wl_interface motorcar_pose_channel_interface;
+extern const struct wl_interface motorcar_presentation_feedback_interface;
 extern const struct wl_interface motorcar_viewpoint_interface;
 extern const struct wl_interface motorcar_six_dof_pointer_interface;
 
+/**
+ * motorcar_shell - a 3D compositor shell
+ * @frame_state: the state of all viewpoints the client has bound for
+ *	the next frame
+ * @frame_timing: when to commit content to make the next refresh
+ *
+ * An interface to allow a copositor to composite 3D data from multiple
+ * clients in a manner that makes it appear to be in the same 3D space.
+ * Combined with embedding tradtional wayland surfaces on quads in the same
+ * space it provides the framework needed to achieve a seamless mixture of
+ * 2D and 3D user interfaces while still giving clients full flexibility in
+ * how their content is drawn to 2D
+ *
+ * It allows clients to associate a motorcar_surface with a basic surface,
+ * which both tells the compositor to perform 3D compositing on the client
+ * surface, and also provides a mechanism for the compositor to give the
+ * client the information it needs to draw its content to 2D correctly.
+ */
+struct motorcar_shell_listener {
+	/**
+	 * frame_state - the state of all viewpoints the client has bound
+	 *	for the next frame
+	 * @serial: incremented with every frame_state event sent to the
+	 *	client
+	 * @presentation_time: time at which the frame is expected to be
+	 *	presented, in milliseconds on the clock of wl_surface frame
+	 *	callbacks
+	 * @stride: size of each viewpoint record, in bytes
+	 * @viewpoints: packed records holding the state of every
+	 *	viewpoint the client has bound
+	 *
+	 * Sent at the beginning of a frame in which the state of any
+	 * viewpoint the client has bound changed, and replaces the
+	 * view_matrix, projection_matrix and view_port events of those
+	 * viewpoints, which the compositor no longer sends to clients that
+	 * bound this interface at version 4 or later (except once, right
+	 * after a viewpoint is bound). It carries the state of every bound
+	 * viewpoint at once, so clients update all of them atomically
+	 * instead of in between events. Nothing is sent for frames in which
+	 * no viewpoint changed.
+	 *
+	 * The viewpoints array holds one record per bound viewpoint, each
+	 * stride bytes long, made of these little endian 32 bit fields: the
+	 * object id of the client's motorcar_viewpoint (uint), the view
+	 * matrix as in view_matrix (16 floats), the projection matrix as in
+	 * projection_matrix (16 floats), the color and depth view ports as
+	 * in view_port (x, y, width, height of the color view port followed
+	 * by those of the depth view port, 8 ints). Later versions may
+	 * append fields to each record, so clients must step through the
+	 * array by stride rather than by the size of the fields they know.
+	 */
+	void (*frame_state)(void *data,
+			    struct motorcar_shell *motorcar_shell,
+			    uint32_t serial,
+			    uint32_t presentation_time,
+			    uint32_t stride,
+			    struct wl_array *viewpoints);
+	/**
+	 * frame_timing - when to commit content to make the next refresh
+	 * @deadline_hi: high 32 bits of the time until which content
+	 *	makes the presentation time
+	 * @deadline_lo: low 32 bits of the time until which content makes
+	 *	the presentation time
+	 * @presentation_hi: high 32 bits of the time content committed
+	 *	before the deadline is expected to be presented
+	 * @presentation_lo: low 32 bits of the time content committed
+	 *	before the deadline is expected to be presented
+	 * @refresh: time between two refreshes of the display in
+	 *	nanoseconds, 0 if unknown
+	 *
+	 * Sent to clients that bound this interface at version 6 or
+	 * later each time a frame has been presented, right before the
+	 * wl_surface frame callbacks of that frame are done. Content
+	 * committed before the deadline is picked up by a frame which the
+	 * compositor expects to be presented at the given presentation
+	 * time, content committed later misses that refresh and is
+	 * presented one or more refresh intervals after it. A client can
+	 * therefore start drawing shortly before the deadline, sampling its
+	 * poses as late as possible, rather than right after the frame
+	 * callback, which has its content presented with poses that are
+	 * older than they need to be.
+	 *
+	 * The deadline and the presentation time are 64 bit values in
+	 * nanoseconds on CLOCK_MONOTONIC, each split into its most and
+	 * least significant 32 bits.
+	 */
+	void (*frame_timing)(void *data,
+			     struct motorcar_shell *motorcar_shell,
+			     uint32_t deadline_hi,
+			     uint32_t deadline_lo,
+			     uint32_t presentation_hi,
+			     uint32_t presentation_lo,
+			     uint32_t refresh);
+};
+
+static inline int
+motorcar_shell_add_listener(struct motorcar_shell *motorcar_shell,
+			    const struct motorcar_shell_listener *listener, void *data)
+{
+	return wl_proxy_add_listener((struct wl_proxy *) motorcar_shell,
+				     (void (**)(void)) listener, data);
+}
+
 #define MOTORCAR_SHELL_GET_MOTORCAR_SURFACE	0
+#define MOTORCAR_SHELL_GET_POSE_CHANNEL	1
 
 static inline void
 motorcar_shell_set_user_data(struct motorcar_shell *motorcar_shell, void *user_data)
@@ -53,6 +161,17 @@ motorcar_shell_get_motorcar_surface(struct motorcar_shell *motorcar_shell, struc
 	return (struct motorcar_surface *) id;
 }
 
+static inline struct motorcar_pose_channel *
+motorcar_shell_get_pose_channel(struct motorcar_shell *motorcar_shell)
+{
+	struct wl_proxy *id;
+
+	id = wl_proxy_marshal_constructor((struct wl_proxy *) motorcar_shell,
+			 MOTORCAR_SHELL_GET_POSE_CHANNEL, &motorcar_pose_channel_interface, NULL);
+
+	return (struct motorcar_pose_channel *) id;
+}
+
 #ifndef MOTORCAR_SURFACE_CLIPPING_MODE_ENUM
 #define MOTORCAR_SURFACE_CLIPPING_MODE_ENUM
 /**
@@ -83,12 +202,41 @@ enum motorcar_surface_clipping_mode {
 };
 #endif /* MOTORCAR_SURFACE_CLIPPING_MODE_ENUM */
 
+#ifndef MOTORCAR_SURFACE_DEPTH_FORMAT_ENUM
+#define MOTORCAR_SURFACE_DEPTH_FORMAT_ENUM
+/**
+ * motorcar_surface_depth_format - layout of the depth values in a depth
+ *	buffer
+ * @MOTORCAR_SURFACE_DEPTH_FORMAT_DEPTH_16: one 16 bit value per pixel
+ * @MOTORCAR_SURFACE_DEPTH_FORMAT_DEPTH_24: one 32 bit value per pixel,
+ *	of which at least the 24 most significant bits are used
+ *
+ * Depth values are unsigned normalized integers, 0 at the near plane
+ * and the maximum value at the far plane, stored in rows with the stride
+ * of the buffer.
+ */
+enum motorcar_surface_depth_format {
+	MOTORCAR_SURFACE_DEPTH_FORMAT_DEPTH_16 = 0,
+	MOTORCAR_SURFACE_DEPTH_FORMAT_DEPTH_24 = 1,
+};
+#endif /* MOTORCAR_SURFACE_DEPTH_FORMAT_ENUM */
+
+#ifndef MOTORCAR_SURFACE_ERROR_ENUM
+#define MOTORCAR_SURFACE_ERROR_ENUM
+enum motorcar_surface_error {
+	MOTORCAR_SURFACE_ERROR_INVALID_DEPTH_BUFFER = 0,
+	MOTORCAR_SURFACE_ERROR_INVALID_DEPTH_FORMAT = 1,
+};
+#endif /* MOTORCAR_SURFACE_ERROR_ENUM */
+
 /**
  * motorcar_surface - a 3D, view dependent, depth composited meta-data
  *	surface
  * @transform_matrix: sets the tranformation of the 3D window
  * @request_size_3d: requests that the client resize the 3D window to the
  *	given scale
+ * @viewpoint_bounds: the region of a viewpoint's view ports covered by
+ *	the 3D window
  *
  * An interface that may be implemented by a wl_surface, for
  * implementations that provide motorcar style depth composited 3D surfaces
@@ -148,6 +296,56 @@ struct motorcar_surface_listener {
 	void (*request_size_3d)(void *data,
 				struct motorcar_surface *motorcar_surface,
 				struct wl_array *dimensions);
+	/**
+	 * viewpoint_bounds - the region of a viewpoint's view ports
+	 *	covered by the 3D window
+	 * @viewpoint: the viewpoint these bounds apply to
+	 * @serial: serial shared by all bounds sent for the same frame
+	 * @color_x: x position of the color bounds, in pixels
+	 * @color_y: y position of the color bounds, in pixels
+	 * @color_width: width of the color bounds, in pixels
+	 * @color_height: height of the color bounds, in pixels
+	 * @depth_x: x position of the depth bounds, in pixels
+	 * @depth_y: y position of the depth bounds, in pixels
+	 * @depth_width: width of the depth bounds, in pixels
+	 * @depth_height: height of the depth bounds, in pixels
+	 * @projection: the projection matrix mapping view space onto the
+	 *	bounds
+	 *
+	 * Tells the client which part of the view ports of the given
+	 * viewpoint its 3D window can cover, so that it only needs to draw
+	 * that part. The rectangles are the screen space bounds of the
+	 * window's clipping volume (with some margin) and lie within the
+	 * color and depth view ports most recently sent by the viewpoint,
+	 * in the same surface local pixel coordinates. Contents outside of
+	 * them are ignored by the compositor.
+	 *
+	 * The projection matrix maps view space onto the bounds, so a
+	 * client which uses the bounds as its GL viewport and this matrix
+	 * as its projection matrix draws exactly the pixels it would have
+	 * drawn inside the bounds when using the full view port and the
+	 * viewpoint's projection matrix. It is represented as a
+	 * column-major 4x4 matrix of 32 bit floats.
+	 *
+	 * The compositor sends one of these events for every viewpoint the
+	 * client has bound whenever the bounds of any of them change, all
+	 * with the same serial. Until a client acknowledges bounds with
+	 * ack_viewpoint_bounds the compositor uses the full view ports of
+	 * its buffers.
+	 */
+	void (*viewpoint_bounds)(void *data,
+				 struct motorcar_surface *motorcar_surface,
+				 struct motorcar_viewpoint *viewpoint,
+				 uint32_t serial,
+				 int32_t color_x,
+				 int32_t color_y,
+				 uint32_t color_width,
+				 uint32_t color_height,
+				 int32_t depth_x,
+				 int32_t depth_y,
+				 uint32_t depth_width,
+				 uint32_t depth_height,
+				 struct wl_array *projection);
 };
 
 static inline int
@@ -159,6 +357,9 @@ motorcar_surface_add_listener(struct motorcar_surface *motorcar_surface,
 }
 
 #define MOTORCAR_SURFACE_SET_SIZE_3D	0
+#define MOTORCAR_SURFACE_ACK_VIEWPOINT_BOUNDS	1
+#define MOTORCAR_SURFACE_SET_DEPTH_BUFFER	2
+#define MOTORCAR_SURFACE_PRESENTATION_FEEDBACK	3
 
 static inline void
 motorcar_surface_set_user_data(struct motorcar_surface *motorcar_surface, void *user_data)
@@ -185,6 +386,208 @@ motorcar_surface_set_size_3d(struct motorcar_surface *motorcar_surface, struct w
 			 MOTORCAR_SURFACE_SET_SIZE_3D, dimensions);
 }
 
+static inline void
+motorcar_surface_ack_viewpoint_bounds(struct motorcar_surface *motorcar_surface, uint32_t serial)
+{
+	wl_proxy_marshal((struct wl_proxy *) motorcar_surface,
+			 MOTORCAR_SURFACE_ACK_VIEWPOINT_BOUNDS, serial);
+}
+
+static inline void
+motorcar_surface_set_depth_buffer(struct motorcar_surface *motorcar_surface, struct wl_buffer *buffer, uint32_t format)
+{
+	wl_proxy_marshal((struct wl_proxy *) motorcar_surface,
+			 MOTORCAR_SURFACE_SET_DEPTH_BUFFER, buffer, format);
+}
+
+static inline struct motorcar_presentation_feedback *
+motorcar_surface_presentation_feedback(struct motorcar_surface *motorcar_surface)
+{
+	struct wl_proxy *callback;
+
+	callback = wl_proxy_marshal_constructor((struct wl_proxy *) motorcar_surface,
+			 MOTORCAR_SURFACE_PRESENTATION_FEEDBACK, &motorcar_presentation_feedback_interface, NULL);
+
+	return (struct motorcar_presentation_feedback *) callback;
+}
+
+#ifndef MOTORCAR_POSE_CHANNEL_POSE_TYPE_ENUM
+#define MOTORCAR_POSE_CHANNEL_POSE_TYPE_ENUM
+enum motorcar_pose_channel_pose_type {
+	MOTORCAR_POSE_CHANNEL_POSE_TYPE_VIEWPOINT = 0,
+	MOTORCAR_POSE_CHANNEL_POSE_TYPE_SIX_DOF_POINTER = 1,
+};
+#endif /* MOTORCAR_POSE_CHANNEL_POSE_TYPE_ENUM */
+
+/**
+ * motorcar_pose_channel - newest poses in shared memory
+ * @region: the shared memory region holding the poses
+ *
+ * A read only shared memory region into which the compositor writes the
+ * newest poses of the viewpoints and six degree of freedom pointers the
+ * client has bound, each time it samples them. The region is sent with
+ * the region event right after the channel is created and stays the
+ * same for the lifetime of the channel.
+ *
+ * The region starts with a 32 byte header, made of these little endian
+ * fields: sequence (uint32), record_count (uint32), record_stride
+ * (uint32), 4 reserved bytes, timestamp (uint64), 8 reserved bytes. It is
+ * followed by record_count records, each record_stride bytes long, made
+ * of: the object id of the client's motorcar_viewpoint or
+ * motorcar_six_dof_pointer (uint32), the pose_type of the object (uint32),
+ * the time the pose applies to (uint64), and the pose as a column-major
+ * 4x4 matrix of 32 bit floats. For viewpoints this is the view matrix, as
+ * in motorcar_viewpoint.view_matrix, for pointers it is the transform of
+ * the pointer into world space, in meters. The header timestamp is the
+ * time the region was last written. Poses of tracked devices are predicted
+ * to the time the compositor expects the frame it is preparing to be
+ * presented, which is then the time they apply to. Later versions may
+ * append fields to the header and to the records, so clients must locate
+ * records by record_stride. All times are in nanoseconds on
+ * CLOCK_MONOTONIC.
+ *
+ * The region is updated as a sequence lock: sequence is odd while the
+ * compositor writes and incremented to the next even value once it has
+ * written. A client reads a consistent set of poses by reading sequence
+ * (with acquire ordering), copying the header and records, then reading
+ * sequence again, and retrying if the first value was odd or the two
+ * values differ.
+ */
+struct motorcar_pose_channel_listener {
+	/**
+	 * region - the shared memory region holding the poses
+	 * @fd: file descriptor of the region
+	 * @size: size of the region, in bytes
+	 *
+	 * Sent once, right after the channel has been created. The file
+	 * descriptor can only be mapped read only.
+	 */
+	void (*region)(void *data,
+		       struct motorcar_pose_channel *motorcar_pose_channel,
+		       int32_t fd,
+		       uint32_t size);
+};
+
+static inline int
+motorcar_pose_channel_add_listener(struct motorcar_pose_channel *motorcar_pose_channel,
+				   const struct motorcar_pose_channel_listener *listener, void *data)
+{
+	return wl_proxy_add_listener((struct wl_proxy *) motorcar_pose_channel,
+				     (void (**)(void)) listener, data);
+}
+
+#define MOTORCAR_POSE_CHANNEL_DESTROY	0
+
+static inline void
+motorcar_pose_channel_set_user_data(struct motorcar_pose_channel *motorcar_pose_channel, void *user_data)
+{
+	wl_proxy_set_user_data((struct wl_proxy *) motorcar_pose_channel, user_data);
+}
+
+static inline void *
+motorcar_pose_channel_get_user_data(struct motorcar_pose_channel *motorcar_pose_channel)
+{
+	return wl_proxy_get_user_data((struct wl_proxy *) motorcar_pose_channel);
+}
+
+static inline void
+motorcar_pose_channel_destroy(struct motorcar_pose_channel *motorcar_pose_channel)
+{
+	wl_proxy_marshal((struct wl_proxy *) motorcar_pose_channel,
+			 MOTORCAR_POSE_CHANNEL_DESTROY);
+
+	wl_proxy_destroy((struct wl_proxy *) motorcar_pose_channel);
+}
+
+#ifndef MOTORCAR_PRESENTATION_FEEDBACK_KIND_ENUM
+#define MOTORCAR_PRESENTATION_FEEDBACK_KIND_ENUM
+enum motorcar_presentation_feedback_kind {
+	MOTORCAR_PRESENTATION_FEEDBACK_KIND_ON_TIME = 0x1,
+};
+#endif /* MOTORCAR_PRESENTATION_FEEDBACK_KIND_ENUM */
+
+/**
+ * motorcar_presentation_feedback - presentation feedback for the
+ *	content of one commit
+ * @presented: the content has been presented
+ * @discarded: the content was not presented
+ *
+ * Created with motorcar_surface.presentation_feedback. Exactly one
+ * presented or discarded event is sent on it, after which the compositor
+ * destroys the object, so the client must destroy its proxy as well.
+ */
+struct motorcar_presentation_feedback_listener {
+	/**
+	 * presented - the content has been presented
+	 * @time_hi: high 32 bits of the presentation time
+	 * @time_lo: low 32 bits of the presentation time
+	 * @refresh: time between two refreshes of the display in
+	 *	nanoseconds, 0 if unknown
+	 * @sequence: number of the compositor frame that presented the
+	 *	content
+	 * @flags: combination of the kind flags
+	 *
+	 * Sent once the first frame showing the content has been
+	 * presented. The time is when the buffers of the first display
+	 * showing that frame were swapped, which with vertical
+	 * synchronization is right after the refresh that shows it, as a
+	 * 64 bit value in nanoseconds on CLOCK_MONOTONIC split into its
+	 * most and least significant 32 bits. The sequence is the number of
+	 * the compositor frame that was presented, which increases by one
+	 * with every frame the compositor prepares.
+	 *
+	 * The on_time flag is set if the content was presented by the
+	 * frame that picked it up, no later than half a refresh interval
+	 * after the presentation time the compositor predicted for that
+	 * frame, which is the presentation time frame_timing announced to
+	 * clients committing before its deadline. Without it the content
+	 * was presented late, for example because the frame picking it up
+	 * was replaced by a newer one before a display could draw it.
+	 */
+	void (*presented)(void *data,
+			  struct motorcar_presentation_feedback *motorcar_presentation_feedback,
+			  uint32_t time_hi,
+			  uint32_t time_lo,
+			  uint32_t refresh,
+			  uint32_t sequence,
+			  uint32_t flags);
+	/**
+	 * discarded - the content was not presented
+	 *
+	 * Sent if the content is never presented, because newer content
+	 * was committed before any frame showing it was presented, or
+	 * because the surface was destroyed.
+	 */
+	void (*discarded)(void *data,
+			  struct motorcar_presentation_feedback *motorcar_presentation_feedback);
+};
+
+static inline int
+motorcar_presentation_feedback_add_listener(struct motorcar_presentation_feedback *motorcar_presentation_feedback,
+					    const struct motorcar_presentation_feedback_listener *listener, void *data)
+{
+	return wl_proxy_add_listener((struct wl_proxy *) motorcar_presentation_feedback,
+				     (void (**)(void)) listener, data);
+}
+
+static inline void
+motorcar_presentation_feedback_set_user_data(struct motorcar_presentation_feedback *motorcar_presentation_feedback, void *user_data)
+{
+	wl_proxy_set_user_data((struct wl_proxy *) motorcar_presentation_feedback, user_data);
+}
+
+static inline void *
+motorcar_presentation_feedback_get_user_data(struct motorcar_presentation_feedback *motorcar_presentation_feedback)
+{
+	return wl_proxy_get_user_data((struct wl_proxy *) motorcar_presentation_feedback);
+}
+
+static inline void
+motorcar_presentation_feedback_destroy(struct motorcar_presentation_feedback *motorcar_presentation_feedback)
+{
+	wl_proxy_destroy((struct wl_proxy *) motorcar_presentation_feedback);
+}
+
 /**
  * motorcar_viewpoint - represents a single viewpoint in the compositor,
  *	essentially a view and projection matrix
@@ -312,6 +715,7 @@ motorcar_viewpoint_destroy(struct motorcar_viewpoint *motorcar_viewpoint)
  * @leave: leave event
  * @motion: six_dof pointer motion event
  * @button: pointer button event
+ * @frame: end of the six_dof pointer events of a frame
  *
  * This interface represents a six degree of freedom pointing device
  * which behaves much like a traditional pointing device except that rather
@@ -399,6 +803,19 @@ struct motorcar_six_dof_pointer_listener {
 		       uint32_t time,
 		       uint32_t button,
 		       uint32_t state);
+	/**
+	 * frame - end of the six_dof pointer events of a frame
+	 *
+	 * Marks the end of the enter, leave, motion and button events
+	 * the compositor generated for one of its frames, so clients can
+	 * handle them as one update rather than one event at a time. Sent
+	 * to pointers bound at version 2 or later, only in frames in which
+	 * any of those events was sent. Motion is only sent when the pose
+	 * of the pointer or the point on the surface it hits changed
+	 * noticeably, so nothing at all is sent while the pointer rests.
+	 */
+	void (*frame)(void *data,
+		      struct motorcar_six_dof_pointer *motorcar_six_dof_pointer);
 };
 
 static inline int
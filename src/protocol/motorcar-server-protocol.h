@@ -14,17 +14,23 @@ struct wl_resource;
 
 struct motorcar_shell;
 struct motorcar_surface;
+struct motorcar_pose_channel;
+struct motorcar_presentation_feedback;
 struct motorcar_viewpoint;
 struct motorcar_six_dof_pointer;
 
 extern const struct wl_interface motorcar_shell_interface;
 extern const struct wl_interface motorcar_surface_interface;
+extern const struct wl_interface motorcar_pose_channel_interface;
+extern const struct wl_interface motorcar_presentation_feedback_interface;
 extern const struct wl_interface motorcar_viewpoint_interface;
 extern const struct wl_interface motorcar_six_dof_pointer_interface;
 
 /**
  * motorcar_shell - a 3D compositor shell
  * @get_motorcar_surface: create a motorcar surface from a surface
+ * @get_pose_channel: create a shared memory channel for the newest
+ *	poses
  *
  * An interface to allow a copositor to composite 3D data from multiple
  * clients in a manner that makes it appear to be in the same 3D space.
@@ -61,8 +67,40 @@ struct motorcar_shell_interface {
 				     struct wl_resource *surface,
 				     uint32_t clipping_mode,
 				     uint32_t enable_depth_compositing);
+	/**
+	 * get_pose_channel - create a shared memory channel for the
+	 *	newest poses
+	 * @id: the new pose channel
+	 *
+	 * Creates a pose channel, through which the compositor shares
+	 * the newest poses of the viewpoints and six degree of freedom
+	 * pointers the client has bound in shared memory, so the client
+	 * can sample them right before it draws instead of waiting for
+	 * events.
+	 */
+	void (*get_pose_channel)(struct wl_client *client,
+				 struct wl_resource *resource,
+				 uint32_t id);
 };
 
+#define MOTORCAR_SHELL_FRAME_STATE	0
+#define MOTORCAR_SHELL_FRAME_TIMING	1
+
+#define MOTORCAR_SHELL_FRAME_STATE_SINCE_VERSION	4
+#define MOTORCAR_SHELL_FRAME_TIMING_SINCE_VERSION	6
+
+static inline void
+motorcar_shell_send_frame_state(struct wl_resource *resource_, uint32_t serial, uint32_t presentation_time, uint32_t stride, struct wl_array *viewpoints)
+{
+	wl_resource_post_event(resource_, MOTORCAR_SHELL_FRAME_STATE, serial, presentation_time, stride, viewpoints);
+}
+
+static inline void
+motorcar_shell_send_frame_timing(struct wl_resource *resource_, uint32_t deadline_hi, uint32_t deadline_lo, uint32_t presentation_hi, uint32_t presentation_lo, uint32_t refresh)
+{
+	wl_resource_post_event(resource_, MOTORCAR_SHELL_FRAME_TIMING, deadline_hi, deadline_lo, presentation_hi, presentation_lo, refresh);
+}
+
 
 #ifndef MOTORCAR_SURFACE_CLIPPING_MODE_ENUM
 #define MOTORCAR_SURFACE_CLIPPING_MODE_ENUM
@@ -94,11 +132,43 @@ enum motorcar_surface_clipping_mode {
 };
 #endif /* MOTORCAR_SURFACE_CLIPPING_MODE_ENUM */
 
+#ifndef MOTORCAR_SURFACE_DEPTH_FORMAT_ENUM
+#define MOTORCAR_SURFACE_DEPTH_FORMAT_ENUM
+/**
+ * motorcar_surface_depth_format - layout of the depth values in a depth
+ *	buffer
+ * @MOTORCAR_SURFACE_DEPTH_FORMAT_DEPTH_16: one 16 bit value per pixel
+ * @MOTORCAR_SURFACE_DEPTH_FORMAT_DEPTH_24: one 32 bit value per pixel,
+ *	of which at least the 24 most significant bits are used
+ *
+ * Depth values are unsigned normalized integers, 0 at the near plane
+ * and the maximum value at the far plane, stored in rows with the stride
+ * of the buffer.
+ */
+enum motorcar_surface_depth_format {
+	MOTORCAR_SURFACE_DEPTH_FORMAT_DEPTH_16 = 0,
+	MOTORCAR_SURFACE_DEPTH_FORMAT_DEPTH_24 = 1,
+};
+#endif /* MOTORCAR_SURFACE_DEPTH_FORMAT_ENUM */
+
+#ifndef MOTORCAR_SURFACE_ERROR_ENUM
+#define MOTORCAR_SURFACE_ERROR_ENUM
+enum motorcar_surface_error {
+	MOTORCAR_SURFACE_ERROR_INVALID_DEPTH_BUFFER = 0,
+	MOTORCAR_SURFACE_ERROR_INVALID_DEPTH_FORMAT = 1,
+};
+#endif /* MOTORCAR_SURFACE_ERROR_ENUM */
+
 /**
  * motorcar_surface - a 3D, view dependent, depth composited meta-data
  *	surface
  * @set_size_3d: requests that the client resize the 3D window to the
  *	given scale
+ * @ack_viewpoint_bounds: the next buffer was drawn using the given
+ *	bounds
+ * @set_depth_buffer: attach a separate depth buffer to the surface
+ * @presentation_feedback: request feedback on the presentation of the
+ *	next commit
  *
  * An interface that may be implemented by a wl_surface, for
  * implementations that provide motorcar style depth composited 3D surfaces
@@ -140,13 +210,74 @@ struct motorcar_surface_interface {
 	void (*set_size_3d)(struct wl_client *client,
 			    struct wl_resource *resource,
 			    struct wl_array *dimensions);
+	/**
+	 * ack_viewpoint_bounds - the next buffer was drawn using the
+	 *	given bounds
+	 * @serial: the serial of the viewpoint_bounds events that were
+	 *	used
+	 *
+	 * Tells the compositor that the buffer attached by the next
+	 * commit was drawn only inside the bounds sent with the given
+	 * serial, so the compositor restricts compositing of that buffer
+	 * to those bounds.
+	 */
+	void (*ack_viewpoint_bounds)(struct wl_client *client,
+				     struct wl_resource *resource,
+				     uint32_t serial);
+	/**
+	 * set_depth_buffer - attach a separate depth buffer to the
+	 *	surface
+	 * @buffer: the depth buffer, or null to remove it
+	 * @format: the depth_format of the buffer
+	 *
+	 * Sets the buffer holding the depth values for the color buffer
+	 * of the surface. Like wl_surface.attach this only takes effect
+	 * with the next wl_surface.commit, after which the compositor
+	 * copies the depth values and sends wl_buffer.release for the
+	 * depth buffer. Passing a null buffer removes the depth buffer
+	 * again.
+	 *
+	 * While a depth buffer is attached the compositor does not read
+	 * depth from the depth view ports, and the color buffer only needs
+	 * to hold the color view ports, so its height can be halved. The
+	 * depth buffer uses the same layout as the color view ports and
+	 * may have a lower resolution than the color buffer (for example
+	 * half resolution), in which case it is stretched over it. The
+	 * bounds sent by viewpoint_bounds apply to it as for the color view
+	 * ports.
+	 *
+	 * The buffer must be a wl_shm buffer whose stride is a multiple of
+	 * the size of a depth value and holds a full row of them,
+	 * otherwise the invalid_depth_buffer error is raised. A format
+	 * which is not a depth_format raises the invalid_depth_format
+	 * error.
+	 */
+	void (*set_depth_buffer)(struct wl_client *client,
+				 struct wl_resource *resource,
+				 struct wl_resource *buffer,
+				 uint32_t format);
+	/**
+	 * presentation_feedback - request feedback on the presentation
+	 *	of the next commit
+	 * @callback: the new feedback object
+	 *
+	 * Requests feedback on the content committed by the next
+	 * wl_surface.commit. Once the compositor knows what became of that
+	 * content it sends either the presented or the discarded event on
+	 * the new object, and then destroys it.
+	 */
+	void (*presentation_feedback)(struct wl_client *client,
+				      struct wl_resource *resource,
+				      uint32_t callback);
 };
 
 #define MOTORCAR_SURFACE_TRANSFORM_MATRIX	0
 #define MOTORCAR_SURFACE_REQUEST_SIZE_3D	1
+#define MOTORCAR_SURFACE_VIEWPOINT_BOUNDS	2
 
 #define MOTORCAR_SURFACE_TRANSFORM_MATRIX_SINCE_VERSION	1
 #define MOTORCAR_SURFACE_REQUEST_SIZE_3D_SINCE_VERSION	1
+#define MOTORCAR_SURFACE_VIEWPOINT_BOUNDS_SINCE_VERSION	2
 
 static inline void
 motorcar_surface_send_transform_matrix(struct wl_resource *resource_, struct wl_array *transform)
@@ -160,6 +291,100 @@ motorcar_surface_send_request_size_3d(struct wl_resource *resource_, struct wl_a
 	wl_resource_post_event(resource_, MOTORCAR_SURFACE_REQUEST_SIZE_3D, dimensions);
 }
 
+static inline void
+motorcar_surface_send_viewpoint_bounds(struct wl_resource *resource_, struct wl_resource *viewpoint, uint32_t serial, int32_t color_x, int32_t color_y, uint32_t color_width, uint32_t color_height, int32_t depth_x, int32_t depth_y, uint32_t depth_width, uint32_t depth_height, struct wl_array *projection)
+{
+	wl_resource_post_event(resource_, MOTORCAR_SURFACE_VIEWPOINT_BOUNDS, viewpoint, serial, color_x, color_y, color_width, color_height, depth_x, depth_y, depth_width, depth_height, projection);
+}
+
+#ifndef MOTORCAR_POSE_CHANNEL_POSE_TYPE_ENUM
+#define MOTORCAR_POSE_CHANNEL_POSE_TYPE_ENUM
+enum motorcar_pose_channel_pose_type {
+	MOTORCAR_POSE_CHANNEL_POSE_TYPE_VIEWPOINT = 0,
+	MOTORCAR_POSE_CHANNEL_POSE_TYPE_SIX_DOF_POINTER = 1,
+};
+#endif /* MOTORCAR_POSE_CHANNEL_POSE_TYPE_ENUM */
+
+/**
+ * motorcar_pose_channel - newest poses in shared memory
+ * @destroy: destroy the pose channel
+ *
+ * A read only shared memory region into which the compositor writes the
+ * newest poses of the viewpoints and six degree of freedom pointers the
+ * client has bound, each time it samples them. The region is sent with
+ * the region event right after the channel is created and stays the
+ * same for the lifetime of the channel.
+ *
+ * The region starts with a 32 byte header, made of these little endian
+ * fields: sequence (uint32), record_count (uint32), record_stride
+ * (uint32), 4 reserved bytes, timestamp (uint64), 8 reserved bytes. It is
+ * followed by record_count records, each record_stride bytes long, made
+ * of: the object id of the client's motorcar_viewpoint or
+ * motorcar_six_dof_pointer (uint32), the pose_type of the object (uint32),
+ * the time the pose applies to (uint64), and the pose as a column-major
+ * 4x4 matrix of 32 bit floats. For viewpoints this is the view matrix, as
+ * in motorcar_viewpoint.view_matrix, for pointers it is the transform of
+ * the pointer into world space, in meters. The header timestamp is the
+ * time the region was last written. Poses of tracked devices are predicted
+ * to the time the compositor expects the frame it is preparing to be
+ * presented, which is then the time they apply to. Later versions may
+ * append fields to the header and to the records, so clients must locate
+ * records by record_stride. All times are in nanoseconds on
+ * CLOCK_MONOTONIC.
+ *
+ * The region is updated as a sequence lock: sequence is odd while the
+ * compositor writes and incremented to the next even value once it has
+ * written. A client reads a consistent set of poses by reading sequence
+ * (with acquire ordering), copying the header and records, then reading
+ * sequence again, and retrying if the first value was odd or the two
+ * values differ.
+ */
+struct motorcar_pose_channel_interface {
+	/**
+	 * destroy - destroy the pose channel
+	 *
+	 * Destroys the channel, the compositor stops writing into the
+	 * region. The client should unmap it.
+	 */
+	void (*destroy)(struct wl_client *client,
+			struct wl_resource *resource);
+};
+
+#define MOTORCAR_POSE_CHANNEL_REGION	0
+
+#define MOTORCAR_POSE_CHANNEL_REGION_SINCE_VERSION	1
+
+static inline void
+motorcar_pose_channel_send_region(struct wl_resource *resource_, int32_t fd, uint32_t size)
+{
+	wl_resource_post_event(resource_, MOTORCAR_POSE_CHANNEL_REGION, fd, size);
+}
+
+#ifndef MOTORCAR_PRESENTATION_FEEDBACK_KIND_ENUM
+#define MOTORCAR_PRESENTATION_FEEDBACK_KIND_ENUM
+enum motorcar_presentation_feedback_kind {
+	MOTORCAR_PRESENTATION_FEEDBACK_KIND_ON_TIME = 0x1,
+};
+#endif /* MOTORCAR_PRESENTATION_FEEDBACK_KIND_ENUM */
+
+#define MOTORCAR_PRESENTATION_FEEDBACK_PRESENTED	0
+#define MOTORCAR_PRESENTATION_FEEDBACK_DISCARDED	1
+
+#define MOTORCAR_PRESENTATION_FEEDBACK_PRESENTED_SINCE_VERSION	1
+#define MOTORCAR_PRESENTATION_FEEDBACK_DISCARDED_SINCE_VERSION	1
+
+static inline void
+motorcar_presentation_feedback_send_presented(struct wl_resource *resource_, uint32_t time_hi, uint32_t time_lo, uint32_t refresh, uint32_t sequence, uint32_t flags)
+{
+	wl_resource_post_event(resource_, MOTORCAR_PRESENTATION_FEEDBACK_PRESENTED, time_hi, time_lo, refresh, sequence, flags);
+}
+
+static inline void
+motorcar_presentation_feedback_send_discarded(struct wl_resource *resource_)
+{
+	wl_resource_post_event(resource_, MOTORCAR_PRESENTATION_FEEDBACK_DISCARDED);
+}
+
 #define MOTORCAR_VIEWPOINT_VIEW_MATRIX	0
 #define MOTORCAR_VIEWPOINT_PROJECTION_MATRIX	1
 #define MOTORCAR_VIEWPOINT_VIEW_PORT	2
@@ -217,11 +442,13 @@ struct motorcar_six_dof_pointer_interface {
 #define MOTORCAR_SIX_DOF_POINTER_LEAVE	1
 #define MOTORCAR_SIX_DOF_POINTER_MOTION	2
 #define MOTORCAR_SIX_DOF_POINTER_BUTTON	3
+#define MOTORCAR_SIX_DOF_POINTER_FRAME	4
 
 #define MOTORCAR_SIX_DOF_POINTER_ENTER_SINCE_VERSION	1
 #define MOTORCAR_SIX_DOF_POINTER_LEAVE_SINCE_VERSION	1
 #define MOTORCAR_SIX_DOF_POINTER_MOTION_SINCE_VERSION	1
 #define MOTORCAR_SIX_DOF_POINTER_BUTTON_SINCE_VERSION	1
+#define MOTORCAR_SIX_DOF_POINTER_FRAME_SINCE_VERSION	2
 
 static inline void
 motorcar_six_dof_pointer_send_enter(struct wl_resource *resource_, uint32_t serial, struct wl_resource *surface, struct wl_array *position, struct wl_array *orientation)
@@ -247,6 +474,12 @@ motorcar_six_dof_pointer_send_button(struct wl_resource *resource_, uint32_t ser
 	wl_resource_post_event(resource_, MOTORCAR_SIX_DOF_POINTER_BUTTON, serial, time, button, state);
 }
 
+static inline void
+motorcar_six_dof_pointer_send_frame(struct wl_resource *resource_)
+{
+	wl_resource_post_event(resource_, MOTORCAR_SIX_DOF_POINTER_FRAME);
+}
+
 #ifdef  __cplusplus
 }
 #endif
@@ -4,6 +4,10 @@
 
 extern const struct wl_interface motorcar_surface_interface;
 extern const struct wl_interface wl_surface_interface;
+extern const struct wl_interface motorcar_pose_channel_interface;
+extern const struct wl_interface wl_buffer_interface;
+extern const struct wl_interface motorcar_presentation_feedback_interface;
+extern const struct wl_interface motorcar_viewpoint_interface;
 
 static const struct wl_interface *types[] = {
 	NULL,
@@ -18,6 +22,21 @@ static const struct wl_interface *types[] = {
 	&wl_surface_interface,
 	NULL,
 	NULL,
+	&motorcar_pose_channel_interface,
+	&wl_buffer_interface,
+	NULL,
+	&motorcar_presentation_feedback_interface,
+	&motorcar_viewpoint_interface,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
 	NULL,
 	&motorcar_surface_interface,
 	NULL,
@@ -28,27 +47,62 @@ static const struct wl_interface *types[] = {
 
 static const struct wl_message motorcar_shell_requests[] = {
 	{ "get_motorcar_surface", "nouu", types + 8 },
+	{ "get_pose_channel", "5n", types + 12 },
+};
+
+static const struct wl_message motorcar_shell_events[] = {
+	{ "frame_state", "4uuua", types + 0 },
+	{ "frame_timing", "6uuuuu", types + 0 },
 };
 
 WL_EXPORT const struct wl_interface motorcar_shell_interface = {
-	"motorcar_shell", 1,
-	1, motorcar_shell_requests,
-	0, NULL,
+	"motorcar_shell", 6,
+	2, motorcar_shell_requests,
+	2, motorcar_shell_events,
 };
 
 static const struct wl_message motorcar_surface_requests[] = {
 	{ "set_size_3d", "a", types + 0 },
+	{ "ack_viewpoint_bounds", "2u", types + 0 },
+	{ "set_depth_buffer", "3?ou", types + 13 },
+	{ "presentation_feedback", "6n", types + 15 },
 };
 
 static const struct wl_message motorcar_surface_events[] = {
 	{ "transform_matrix", "a", types + 0 },
 	{ "request_size_3d", "a", types + 0 },
+	{ "viewpoint_bounds", "2ouiiuuiiuua", types + 16 },
 };
 
 WL_EXPORT const struct wl_interface motorcar_surface_interface = {
-	"motorcar_surface", 1,
-	1, motorcar_surface_requests,
-	2, motorcar_surface_events,
+	"motorcar_surface", 6,
+	4, motorcar_surface_requests,
+	3, motorcar_surface_events,
+};
+
+static const struct wl_message motorcar_pose_channel_requests[] = {
+	{ "destroy", "", types + 0 },
+};
+
+static const struct wl_message motorcar_pose_channel_events[] = {
+	{ "region", "hu", types + 0 },
+};
+
+WL_EXPORT const struct wl_interface motorcar_pose_channel_interface = {
+	"motorcar_pose_channel", 1,
+	1, motorcar_pose_channel_requests,
+	1, motorcar_pose_channel_events,
+};
+
+static const struct wl_message motorcar_presentation_feedback_events[] = {
+	{ "presented", "uuuuu", types + 0 },
+	{ "discarded", "", types + 0 },
+};
+
+WL_EXPORT const struct wl_interface motorcar_presentation_feedback_interface = {
+	"motorcar_presentation_feedback", 1,
+	0, NULL,
+	2, motorcar_presentation_feedback_events,
 };
 
 static const struct wl_message motorcar_viewpoint_events[] = {
@@ -68,15 +122,16 @@ static const struct wl_message motorcar_six_dof_pointer_requests[] = {
 };
 
 static const struct wl_message motorcar_six_dof_pointer_events[] = {
-	{ "enter", "uoaa", types + 12 },
-	{ "leave", "uo", types + 16 },
+	{ "enter", "uoaa", types + 27 },
+	{ "leave", "uo", types + 31 },
 	{ "motion", "uaa", types + 0 },
 	{ "button", "uuuu", types + 0 },
+	{ "frame", "2", types + 0 },
 };
 
 WL_EXPORT const struct wl_interface motorcar_six_dof_pointer_interface = {
-	"motorcar_six_dof_pointer", 1,
+	"motorcar_six_dof_pointer", 2,
 	1, motorcar_six_dof_pointer_requests,
-	4, motorcar_six_dof_pointer_events,
+	5, motorcar_six_dof_pointer_events,
 };
 